@@ -0,0 +1,312 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+int BVH::maxLeafSize = 4;
+
+static const int      NUM_BINS   = 12;
+static const int      MAX_PILHA  = 64;
+static const int      MAX_PROF   = MAX_PILHA - 1;  // a travessia empilha no maximo prof + 1 nos
+static const uint32_t MAGIC_BVH  = 0x32565851;     // "QXV2"
+static const float    CUSTO_NO   = 1.0f;        // custo de visitar um no relativo a um triangulo
+
+struct Caixa {
+  float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+  void inclui( const float p[3] ) {
+    for ( int k = 0; k < 3; k++ ) {
+      min[k] = std::min( min[k], p[k] );
+      max[k] = std::max( max[k], p[k] );
+    }
+  }
+
+  void inclui( const Caixa &c ) {
+    for ( int k = 0; k < 3; k++ ) {
+      min[k] = std::min( min[k], c.min[k] );
+      max[k] = std::max( max[k], c.max[k] );
+    }
+  }
+
+  float area() const {
+    float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    return ( dx < 0.0f ) ? 0.0f : 2.0f * ( dx * dy + dy * dz + dz * dx );
+  }
+};
+
+// dados da construcao: caixa e centroide de cada triangulo
+struct Construcao {
+  std::vector<Caixa> caixas;
+  std::vector<float> centros;  // 3 por triangulo
+};
+
+static void subdivide( std::vector<BVH::Node> &nodes,
+                       std::vector<uint32_t>  &order,
+                       const Construcao       &dados,
+                       uint32_t                no,
+                       int                     prof ) {
+  BVH::Node &n = nodes[no];
+  Caixa      caixa, caixaCentros;
+  for ( uint32_t i = n.first; i < n.first + n.count; i++ ) {
+    caixa.inclui( dados.caixas[order[i]] );
+    caixaCentros.inclui( &dados.centros[3 * order[i]] );
+  }
+  for ( int k = 0; k < 3; k++ ) {
+    n.min[k] = caixa.min[k];
+    n.max[k] = caixa.max[k];
+  }
+  if ( n.count <= (uint32_t)BVH::maxLeafSize || prof >= MAX_PROF )
+    return;
+
+  // SAH em bins: testa NUM_BINS - 1 planos em cada eixo
+  float melhorCusto = FLT_MAX;
+  int   melhorEixo = -1, melhorPlano = 0;
+  for ( int eixo = 0; eixo < 3; eixo++ ) {
+    float extensao = caixaCentros.max[eixo] - caixaCentros.min[eixo];
+    if ( extensao <= 0.0f )
+      continue;
+    float    escala = NUM_BINS / extensao;
+    Caixa    bins[NUM_BINS];
+    uint32_t contagem[NUM_BINS] = { 0 };
+    for ( uint32_t i = n.first; i < n.first + n.count; i++ ) {
+      uint32_t tri = order[i];
+      int      b   = (int)( ( dados.centros[3 * tri + eixo] - caixaCentros.min[eixo] ) * escala );
+      b            = std::min( b, NUM_BINS - 1 );
+      bins[b].inclui( dados.caixas[tri] );
+      contagem[b]++;
+    }
+    // varredura da esquerda guardando area * contagem, depois da direita somando o custo
+    float    custoEsq[NUM_BINS - 1];
+    Caixa    acum;
+    uint32_t soma = 0;
+    for ( int b = 0; b < NUM_BINS - 1; b++ ) {
+      acum.inclui( bins[b] );
+      soma        += contagem[b];
+      custoEsq[b]  = soma ? acum.area() * soma : 0.0f;
+    }
+    acum = Caixa();
+    soma = 0;
+    for ( int b = NUM_BINS - 1; b > 0; b-- ) {
+      acum.inclui( bins[b] );
+      soma       += contagem[b];
+      float custo = custoEsq[b - 1] + ( soma ? acum.area() * soma : 0.0f );
+      if ( custo < melhorCusto ) {
+        melhorCusto = custo;
+        melhorEixo  = eixo;
+        melhorPlano = b;
+      }
+    }
+  }
+  if ( melhorEixo < 0 )
+    return;  // todos os centroides coincidem
+
+  float area = caixa.area();
+  if ( area > 0.0f && CUSTO_NO + melhorCusto / area >= (float)n.count )
+    return;  // dividir sai mais caro que testar todos os triangulos
+
+  // particiona pelo plano escolhido
+  float     escala = NUM_BINS / ( caixaCentros.max[melhorEixo] - caixaCentros.min[melhorEixo] );
+  uint32_t *inicio = order.data() + n.first;
+  uint32_t *meio   = std::partition( inicio, inicio + n.count, [&]( uint32_t tri ) {
+    int b =
+      (int)( ( dados.centros[3 * tri + melhorEixo] - caixaCentros.min[melhorEixo] ) * escala );
+    return std::min( b, NUM_BINS - 1 ) < melhorPlano;
+  } );
+  uint32_t  nEsq   = (uint32_t)( meio - inicio );
+  if ( nEsq == 0 || nEsq == n.count )
+    return;
+
+  uint32_t filho = (uint32_t)nodes.size();
+  uint32_t first = n.first, count = n.count;
+  nodes.push_back( { { 0, 0, 0 }, { 0, 0, 0 }, first, nEsq } );
+  nodes.push_back( { { 0, 0, 0 }, { 0, 0, 0 }, first + nEsq, count - nEsq } );
+  nodes[no].first = filho;  // n pode ter sido invalidado pelo push_back
+  nodes[no].count = 0;
+  subdivide( nodes, order, dados, filho, prof + 1 );
+  subdivide( nodes, order, dados, filho + 1, prof + 1 );
+}
+
+// FNV-1a dos vertices, para o cache reconhecer uma malha alterada com o mesmo numero de triangulos
+static uint32_t hashTriangulos( const std::vector<float> &triangles ) {
+  const unsigned char *b = (const unsigned char *)triangles.data();
+  uint32_t             h = 2166136261u;
+  for ( size_t i = 0; i < triangles.size() * sizeof( float ); i++ )
+    h = ( h ^ b[i] ) * 16777619u;
+  return h;
+}
+
+void BVH::build( const std::vector<float> &triangles ) {
+  uint32_t n = (uint32_t)( triangles.size() / 9 );
+  nodes.clear();
+  order.resize( n );
+  hash = hashTriangulos( triangles );
+  if ( n == 0 ) {
+    tris.clear();
+    return;
+  }
+
+  Construcao dados;
+  dados.caixas.resize( n );
+  dados.centros.resize( 3 * n );
+  for ( uint32_t i = 0; i < n; i++ ) {
+    const float *v = &triangles[9 * i];
+    for ( int j = 0; j < 3; j++ )
+      dados.caixas[i].inclui( v + 3 * j );
+    for ( int k = 0; k < 3; k++ )
+      dados.centros[3 * i + k] = ( v[k] + v[3 + k] + v[6 + k] ) / 3.0f;
+    order[i] = i;
+  }
+
+  nodes.reserve( 2 * n );
+  nodes.push_back( { { 0, 0, 0 }, { 0, 0, 0 }, 0, n } );
+  subdivide( nodes, order, dados, 0, 0 );
+  nodes.shrink_to_fit();
+  reordena( triangles );
+}
+
+void BVH::reordena( const std::vector<float> &triangles ) {
+  tris.resize( 9 * order.size() );
+  for ( size_t i = 0; i < order.size(); i++ )
+    std::copy( &triangles[9 * order[i]], &triangles[9 * order[i]] + 9, &tris[9 * i] );
+}
+
+// distancia de entrada na caixa (FLT_MAX se nao acerta antes de tMax)
+static inline float entradaCaixa( const BVH::Node &n,
+                                   const float      o[3],
+                                   const float      inv[3],
+                                   float            tMax ) {
+  float tmin = 0.0f, tmax = tMax;
+  for ( int k = 0; k < 3; k++ ) {
+    float t0 = ( n.min[k] - o[k] ) * inv[k];
+    float t1 = ( n.max[k] - o[k] ) * inv[k];
+    if ( t0 > t1 )
+      std::swap( t0, t1 );
+    tmin = t0 > tmin ? t0 : tmin;
+    tmax = t1 < tmax ? t1 : tmax;
+  }
+  return tmin <= tmax ? tmin : FLT_MAX;
+}
+
+// Moller-Trumbore, dos dois lados
+static inline bool intersectaTriangulo( const float *v,
+                                        const float  o[3],
+                                        const float  d[3],
+                                        float       &t,
+                                        float       &u,
+                                        float       &w ) {
+  float e1[3] = { v[3] - v[0], v[4] - v[1], v[5] - v[2] };
+  float e2[3] = { v[6] - v[0], v[7] - v[1], v[8] - v[2] };
+  float p[3]  = {
+    d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]
+  };
+  float det   = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+  if ( fabsf( det ) < 1e-12f )
+    return false;
+  float inv  = 1.0f / det;
+  float s[3] = { o[0] - v[0], o[1] - v[1], o[2] - v[2] };
+  u          = ( s[0] * p[0] + s[1] * p[1] + s[2] * p[2] ) * inv;
+  if ( u < 0.0f || u > 1.0f )
+    return false;
+  float q[3] = {
+    s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]
+  };
+  w          = ( d[0] * q[0] + d[1] * q[1] + d[2] * q[2] ) * inv;
+  if ( w < 0.0f || u + w > 1.0f )
+    return false;
+  t = ( e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2] ) * inv;
+  return t >= 0.0f;
+}
+
+bool BVH::intersect(
+  const Ray &ray, float tMax, float &t, uint32_t &triangle, float &u, float &v ) const {
+  if ( nodes.empty() )
+    return false;
+  const float o[3]   = { ray.origin.x, ray.origin.y, ray.origin.z };
+  const float d[3]   = { ray.direction.x, ray.direction.y, ray.direction.z };
+  const float inv[3] = { 1.0f / d[0], 1.0f / d[1], 1.0f / d[2] };
+
+  bool     acertou = false;
+  float    melhor  = tMax;
+  uint32_t pilha[MAX_PILHA];
+  int      topo = 0;
+  if ( entradaCaixa( nodes[0], o, inv, melhor ) == FLT_MAX )
+    return false;
+  pilha[topo++] = 0;
+
+  while ( topo > 0 ) {
+    const Node &n = nodes[pilha[--topo]];
+    if ( n.count > 0 ) {
+      for ( uint32_t i = n.first; i < n.first + n.count; i++ ) {
+        float tt, uu, vv;
+        if ( intersectaTriangulo( &tris[9 * i], o, d, tt, uu, vv ) && tt < melhor ) {
+          melhor   = tt;
+          triangle = order[i];
+          u        = uu;
+          v        = vv;
+          acertou  = true;
+        }
+      }
+      continue;
+    }
+    // empilha o filho mais distante primeiro para visitar o mais proximo antes
+    float tEsq = entradaCaixa( nodes[n.first], o, inv, melhor );
+    float tDir = entradaCaixa( nodes[n.first + 1], o, inv, melhor );
+    uint32_t perto = n.first, longe = n.first + 1;
+    if ( tDir < tEsq ) {
+      std::swap( tEsq, tDir );
+      std::swap( perto, longe );
+    }
+    if ( tDir != FLT_MAX )
+      pilha[topo++] = longe;
+    if ( tEsq != FLT_MAX )
+      pilha[topo++] = perto;
+  }
+  if ( acertou )
+    t = melhor;
+  return acertou;
+}
+
+bool BVH::save( FILE *f ) const {
+  uint32_t cab[4] = { MAGIC_BVH, (uint32_t)order.size(), (uint32_t)nodes.size(), hash };
+  return fwrite( cab, sizeof( cab ), 1, f ) == 1 &&
+         fwrite( nodes.data(), sizeof( Node ), nodes.size(), f ) == nodes.size() &&
+         fwrite( order.data(), sizeof( uint32_t ), order.size(), f ) == order.size();
+}
+
+bool BVH::load( FILE *f, const std::vector<float> &triangles ) {
+  uint32_t cab[4];
+  uint32_t n = (uint32_t)( triangles.size() / 9 );
+  nodes.clear();
+  order.clear();
+  tris.clear();
+  hash = hashTriangulos( triangles );
+  if ( fread( cab, sizeof( cab ), 1, f ) != 1 || cab[0] != MAGIC_BVH || cab[1] != n ||
+       cab[2] > 2 * n || cab[3] != hash )
+    return false;
+  nodes.resize( cab[2] );
+  order.resize( n );
+  bool ok = fread( nodes.data(), sizeof( Node ), nodes.size(), f ) == nodes.size() &&
+            fread( order.data(), sizeof( uint32_t ), n, f ) == n;
+  for ( uint32_t i = 0; ok && i < n; i++ )
+    ok = order[i] < n;
+  // filhos sempre depois do pai (como em build), o que limita a profundidade a pilha da travessia
+  std::vector<int> prof( nodes.size(), 0 );
+  for ( size_t i = 0; ok && i < nodes.size(); i++ ) {
+    if ( nodes[i].count > 0 ) {
+      ok = nodes[i].first + nodes[i].count <= n;
+      continue;
+    }
+    ok = nodes[i].first > i && nodes[i].first + 1 < nodes.size() && prof[i] < MAX_PROF;
+    if ( ok )
+      prof[nodes[i].first] = prof[nodes[i].first + 1] = prof[i] + 1;
+  }
+  if ( !ok ) {
+    nodes.clear();
+    order.clear();
+    return false;
+  }
+  reordena( triangles );
+  return true;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file BVH.h
+ * @brief Declaração da classe BVH, uma hierarquia de volumes envolventes sobre triângulos.
+ *
+ * @details Usada pelo picking pela CPU (Model3D::raycast): a árvore é construída com a heurística
+ * de área de superfície (SAH) avaliada em bins, e a travessia visita primeiro o filho mais próximo,
+ * descartando as caixas mais distantes que o acerto já encontrado.
+ */
+#ifndef BVH_H
+#define BVH_H
+
+#include "Ray.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/**
+ * @class BVH
+ * @brief BVH binária de caixas alinhadas aos eixos sobre uma lista de triângulos.
+ *
+ * Os triângulos são passados como 9 floats cada (x, y, z dos três vértices). Depois de
+ * construída, a árvore é só de leitura e pode ser consultada por várias threads ao mesmo tempo.
+ * A profundidade é limitada a 63 níveis (a pilha fixa da travessia); abaixo disso os nós viram
+ * folhas mesmo com mais de maxLeafSize triângulos.
+ */
+class BVH {
+public:
+  /**
+   * @brief Nó da árvore. Com `count` == 0 é interno e `first` é o filho esquerdo (o direito é
+   * `first` + 1); senão é uma folha com os triângulos [`first`, `first` + `count`).
+   */
+  struct Node {
+    float    min[3];
+    float    max[3];
+    uint32_t first;
+    uint32_t count;
+  };
+
+  static int maxLeafSize; /**< @brief Folhas com até este número de triângulos não são divididas
+                             (padrão 4). */
+
+  /**
+   * @brief Constrói a árvore.
+   * @param triangles 9 floats por triângulo.
+   */
+  void build( const std::vector<float> &triangles );
+
+  /**
+   * @brief Primeira interseção do raio com os triângulos (dos dois lados).
+   * @param tMax Só considera acertos com distância menor que tMax.
+   * @param t Recebe a distância do acerto.
+   * @param triangle Recebe o índice do triângulo na lista original passada a build.
+   * @param u, v Recebem as coordenadas baricêntricas do acerto (em relação ao 2º e 3º vértices).
+   */
+  bool
+    intersect( const Ray &ray, float tMax, float &t, uint32_t &triangle, float &u, float &v ) const;
+
+  /**
+   * @brief Grava a árvore (nós, ordem e hash dos triângulos) no arquivo.
+   */
+  bool save( FILE *f ) const;
+
+  /**
+   * @brief Lê uma árvore gravada por save, para a mesma lista de triângulos.
+   * @return `false` se os dados não correspondem à lista, inclusive se algum vértice mudou (a
+   * árvore fica vazia).
+   */
+  bool load( FILE *f, const std::vector<float> &triangles );
+
+  /** @brief Quantidade de triângulos. */
+  size_t size() const { return order.size(); }
+
+  /** @brief Quantidade de nós. */
+  size_t nodeCount() const { return nodes.size(); }
+
+private:
+  std::vector<Node>     nodes;
+  std::vector<float>    tris;   // triangulos na ordem das folhas
+  std::vector<uint32_t> order;     // indice original de cada triangulo de tris
+  uint32_t              hash = 0;  // hash dos triangulos passados a build/load
+
+  void reordena( const std::vector<float> &triangles );
+};
+
+#endif  // BVH_H
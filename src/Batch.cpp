@@ -0,0 +1,360 @@
+#include "Batch.h"
+
+#include "GLInstrument.h"
+#include "Trace.h"
+#include "extra.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+bool Batch::enabled     = true;
+int  Batch::maxVertices = 1 << 16;
+
+struct VerticeLote {
+  GLfloat p[3];
+  GLfloat n[3];
+  GLfloat t[2];
+  GLfloat c[4];
+};
+
+// estado que acompanha os vertices gravados; comparado com memcmp (zerado antes de preencher)
+enum {
+  CAP_LIGHTING,
+  CAP_TEXTURE_2D,
+  CAP_BLEND,
+  CAP_DEPTH_TEST,
+  CAP_CULL_FACE,
+  CAP_COLOR_MATERIAL,
+  CAP_FOG,
+  CAP_LIGHT0,
+  CAP_CLIP_PLANE0 = CAP_LIGHT0 + 8,
+  NUM_CAPS        = CAP_CLIP_PLANE0 + 6
+};
+static const GLenum CAPS[NUM_CAPS] = {
+  GL_LIGHTING,    GL_TEXTURE_2D,  GL_BLEND,       GL_DEPTH_TEST,  GL_CULL_FACE,   GL_COLOR_MATERIAL,
+  GL_FOG,         GL_LIGHT0,      GL_LIGHT1,      GL_LIGHT2,      GL_LIGHT3,      GL_LIGHT4,
+  GL_LIGHT5,      GL_LIGHT6,      GL_LIGHT7,      GL_CLIP_PLANE0, GL_CLIP_PLANE1, GL_CLIP_PLANE2,
+  GL_CLIP_PLANE3, GL_CLIP_PLANE4, GL_CLIP_PLANE5
+};
+static const GLenum PARAMS_MATERIAL[4] = { GL_AMBIENT, GL_DIFFUSE, GL_SPECULAR, GL_EMISSION };
+
+struct EstadoLote {
+  GLfloat   projecao[16];
+  GLint     viewport[4];
+  GLboolean caps[NUM_CAPS];
+  GLint     textura;
+  GLint     colorMaterial[2];   // face e parametro
+  GLfloat   material[2][4][4];  // frente e verso
+  GLfloat   brilho[2];
+  GLint     blend[2];
+  GLfloat   larguraLinha;
+  GLfloat   tamanhoPonto;
+  GLint     modoPoligono[2];  // frente e verso
+  GLboolean mascaraProf;
+  GLint     programa;
+};
+
+enum { LOTE_TRIANGULOS, LOTE_LINHAS, LOTE_PONTOS, NUM_LOTES };
+static const GLenum MODO_LOTE[NUM_LOTES] = { GL_TRIANGLES, GL_LINES, GL_POINTS };
+
+static std::vector<VerticeLote> lotes[NUM_LOTES];
+static GLuint                   vbos[NUM_LOTES] = { 0, 0, 0 };
+static EstadoLote               estadoLotes;
+
+// primitiva em gravacao
+static bool                     gravando = false;
+static bool                     direto   = false;
+static GLenum                   modo;
+static std::vector<VerticeLote> primitiva;
+static VerticeLote              atual;         // normal, textura e cor correntes
+static GLfloat                  mv[16];        // modelview no begin
+static GLfloat                  normalMat[9];  // inversa transposta da parte 3x3 (por linhas)
+
+static int totalPendente() {
+  return (int)( lotes[0].size() + lotes[1].size() + lotes[2].size() );
+}
+
+// lido do OpenGL: os desenhos gravados podem vir logo depois de glDisable, glColor ou glMaterial
+// chamados direto pelo usuario
+static void leEstado( EstadoLote &e ) {
+  memset( &e, 0, sizeof( e ) );
+  glGetFloatv( GL_PROJECTION_MATRIX, e.projecao );
+  glGetIntegerv( GL_VIEWPORT, e.viewport );
+  for ( int i = 0; i < NUM_CAPS; i++ )
+    e.caps[i] = glIsEnabled( CAPS[i] );
+  if ( e.caps[CAP_TEXTURE_2D] )
+    glGetIntegerv( GL_TEXTURE_BINDING_2D, &e.textura );
+  if ( e.caps[CAP_COLOR_MATERIAL] ) {
+    glGetIntegerv( GL_COLOR_MATERIAL_FACE, &e.colorMaterial[0] );
+    glGetIntegerv( GL_COLOR_MATERIAL_PARAMETER, &e.colorMaterial[1] );
+  }
+  if ( e.caps[CAP_LIGHTING] ) {
+    for ( int f = 0; f < 2; f++ ) {
+      GLenum face = f == 0 ? GL_FRONT : GL_BACK;
+      for ( int k = 0; k < 4; k++ )
+        glGetMaterialfv( face, PARAMS_MATERIAL[k], e.material[f][k] );
+      glGetMaterialfv( face, GL_SHININESS, &e.brilho[f] );
+    }
+  }
+  if ( e.caps[CAP_BLEND] ) {
+    glGetIntegerv( GL_BLEND_SRC, &e.blend[0] );
+    glGetIntegerv( GL_BLEND_DST, &e.blend[1] );
+  }
+  glGetFloatv( GL_LINE_WIDTH, &e.larguraLinha );
+  glGetFloatv( GL_POINT_SIZE, &e.tamanhoPonto );
+  glGetIntegerv( GL_POLYGON_MODE, e.modoPoligono );
+  glGetBooleanv( GL_DEPTH_WRITEMASK, &e.mascaraProf );
+  glGetIntegerv( GL_CURRENT_PROGRAM, &e.programa );
+}
+
+// chamada entre glPushAttrib e glPopAttrib (o programa e devolvido por flush); usa o OpenGL
+// direto para que o glPopAttrib desfaca tudo
+static void aplicaEstado( const EstadoLote &e ) {
+  glViewport( e.viewport[0], e.viewport[1], e.viewport[2], e.viewport[3] );
+  for ( int i = 0; i < NUM_CAPS; i++ ) {
+    if ( e.caps[i] )
+      glEnable( CAPS[i] );
+    else
+      glDisable( CAPS[i] );
+  }
+  if ( e.caps[CAP_TEXTURE_2D] )
+    glBindTexture( GL_TEXTURE_2D, e.textura );
+  if ( e.caps[CAP_COLOR_MATERIAL] )
+    glColorMaterial( e.colorMaterial[0], e.colorMaterial[1] );
+  if ( e.caps[CAP_LIGHTING] ) {
+    for ( int f = 0; f < 2; f++ ) {
+      GLenum face = f == 0 ? GL_FRONT : GL_BACK;
+      for ( int k = 0; k < 4; k++ )
+        glMaterialfv( face, PARAMS_MATERIAL[k], e.material[f][k] );
+      glMaterialf( face, GL_SHININESS, e.brilho[f] );
+    }
+  }
+  if ( e.caps[CAP_BLEND] )
+    glBlendFunc( e.blend[0], e.blend[1] );
+  glLineWidth( e.larguraLinha );
+  glPointSize( e.tamanhoPonto );
+  glPolygonMode( GL_FRONT, e.modoPoligono[0] );
+  glPolygonMode( GL_BACK, e.modoPoligono[1] );
+  glDepthMask( e.mascaraProf );
+  glUseProgram( e.programa );
+}
+
+// inversa transposta da parte 3x3 da modelview (matriz dos cofatores dividida pelo determinante)
+static void calculaNormalMat() {
+  float a = mv[0], b = mv[4], c = mv[8];   // linha 0
+  float d = mv[1], e = mv[5], f = mv[9];   // linha 1
+  float g = mv[2], h = mv[6], i = mv[10];  // linha 2
+  float cof[9] = { e * i - f * h, f * g - d * i, d * h - e * g, c * h - b * i, a * i - c * g,
+                   b * g - a * h, b * f - c * e, c * d - a * f, a * e - b * d };
+  float det    = a * cof[0] + b * cof[1] + c * cof[2];
+  float inv    = fabsf( det ) > 1e-20f ? 1.0f / det : 1.0f;
+  for ( int k = 0; k < 9; k++ )
+    normalMat[k] = cof[k] * inv;
+}
+
+static void adiciona( int lote, const VerticeLote &v ) {
+  lotes[lote].push_back( v );
+}
+
+// converte a primitiva gravada em triangulos, linhas ou pontos
+static void fechaPrimitiva() {
+  const std::vector<VerticeLote> &p = primitiva;
+  size_t                          n = p.size();
+  switch ( modo ) {
+    case GL_TRIANGLES:
+      for ( size_t i = 0; i + 2 < n; i += 3 )
+        for ( int k = 0; k < 3; k++ )
+          adiciona( LOTE_TRIANGULOS, p[i + k] );
+      break;
+    case GL_QUADS:
+      for ( size_t i = 0; i + 3 < n; i += 4 ) {
+        for ( int k : { 0, 1, 2, 0, 2, 3 } )
+          adiciona( LOTE_TRIANGULOS, p[i + k] );
+      }
+      break;
+    case GL_TRIANGLE_STRIP:
+      for ( size_t i = 2; i < n; i++ ) {
+        adiciona( LOTE_TRIANGULOS, p[i % 2 ? i - 1 : i - 2] );
+        adiciona( LOTE_TRIANGULOS, p[i % 2 ? i - 2 : i - 1] );
+        adiciona( LOTE_TRIANGULOS, p[i] );
+      }
+      break;
+    case GL_QUAD_STRIP:
+      for ( size_t i = 0; i + 3 < n; i += 2 ) {
+        for ( int k : { 0, 1, 3, 0, 3, 2 } )
+          adiciona( LOTE_TRIANGULOS, p[i + k] );
+      }
+      break;
+    case GL_TRIANGLE_FAN:
+    case GL_POLYGON:
+      for ( size_t i = 2; i < n; i++ ) {
+        adiciona( LOTE_TRIANGULOS, p[0] );
+        adiciona( LOTE_TRIANGULOS, p[i - 1] );
+        adiciona( LOTE_TRIANGULOS, p[i] );
+      }
+      break;
+    case GL_LINES:
+      for ( size_t i = 0; i + 1 < n; i += 2 ) {
+        adiciona( LOTE_LINHAS, p[i] );
+        adiciona( LOTE_LINHAS, p[i + 1] );
+      }
+      break;
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP:
+      for ( size_t i = 1; i < n; i++ ) {
+        adiciona( LOTE_LINHAS, p[i - 1] );
+        adiciona( LOTE_LINHAS, p[i] );
+      }
+      if ( modo == GL_LINE_LOOP && n > 2 ) {
+        adiciona( LOTE_LINHAS, p[n - 1] );
+        adiciona( LOTE_LINHAS, p[0] );
+      }
+      break;
+    default:  // GL_POINTS
+      for ( size_t i = 0; i < n; i++ )
+        adiciona( LOTE_PONTOS, p[i] );
+      break;
+  }
+  primitiva.clear();
+}
+
+//---------------------------------------------------------------------------
+
+void Batch::begin( GLenum mode ) {
+  gravando = true;
+  direto   = !enabled || glutGUI::picking;
+  if ( direto ) {
+    glBegin( mode );
+    return;
+  }
+  modo = mode;
+
+  EstadoLote e;
+  leEstado( e );
+  if ( totalPendente() > 0 && memcmp( &e, &estadoLotes, sizeof( e ) ) != 0 )
+    flush();
+  estadoLotes = e;
+
+  glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+  calculaNormalMat();
+  glGetFloatv( GL_CURRENT_NORMAL, atual.n );
+  glGetFloatv( GL_CURRENT_TEXTURE_COORDS, atual.c );  // s, t, r, q: so s e t sao usados
+  atual.t[0] = atual.c[0];
+  atual.t[1] = atual.c[1];
+  glGetFloatv( GL_CURRENT_COLOR, atual.c );
+  normal3f( atual.n[0], atual.n[1], atual.n[2] );  // a normal corrente tambem vai para o olho
+}
+
+void Batch::end() {
+  if ( !gravando )
+    return;
+  gravando = false;
+  if ( direto ) {
+    glEnd();
+    return;
+  }
+  fechaPrimitiva();
+  if ( totalPendente() >= maxVertices )
+    flush();
+}
+
+void Batch::vertex3f( GLfloat x, GLfloat y, GLfloat z ) {
+  if ( direto ) {
+    glVertex3f( x, y, z );
+    return;
+  }
+  VerticeLote v = atual;
+  for ( int k = 0; k < 3; k++ )
+    v.p[k] = mv[k] * x + mv[4 + k] * y + mv[8 + k] * z + mv[12 + k];
+  primitiva.push_back( v );
+}
+
+void Batch::normal3f( GLfloat x, GLfloat y, GLfloat z ) {
+  if ( direto || !gravando ) {  // fora de begin/end vale como glNormal3f
+    glNormal3f( x, y, z );
+    return;
+  }
+  for ( int k = 0; k < 3; k++ )
+    atual.n[k] = normalMat[3 * k] * x + normalMat[3 * k + 1] * y + normalMat[3 * k + 2] * z;
+}
+
+void Batch::texCoord2f( GLfloat s, GLfloat t ) {
+  if ( direto || !gravando ) {
+    glTexCoord2f( s, t );
+    return;
+  }
+  atual.t[0] = s;
+  atual.t[1] = t;
+}
+
+void Batch::color4f( GLfloat r, GLfloat g, GLfloat b, GLfloat a ) {
+  if ( direto || !gravando ) {
+    glColor4f( r, g, b, a );
+    return;
+  }
+  atual.c[0] = r;
+  atual.c[1] = g;
+  atual.c[2] = b;
+  atual.c[3] = a;
+}
+
+void Batch::flush() {
+  if ( totalPendente() == 0 )
+    return;
+  QXGL_TRACE_ZONE( "Batch::flush" );
+
+  // o estado gravado vale so durante o envio
+  GLint programa = 0;
+  glGetIntegerv( GL_CURRENT_PROGRAM, &programa );
+  glPushAttrib( GL_ENABLE_BIT | GL_LIGHTING_BIT | GL_TEXTURE_BIT | GL_LINE_BIT | GL_POINT_BIT |
+                GL_CURRENT_BIT | GL_TRANSFORM_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT |
+                GL_POLYGON_BIT | GL_DEPTH_BUFFER_BIT );
+  aplicaEstado( estadoLotes );
+  glMatrixMode( GL_PROJECTION );
+  glPushMatrix();
+  glLoadMatrixf( estadoLotes.projecao );
+  glMatrixMode( GL_MODELVIEW );
+  glPushMatrix();
+  glLoadIdentity();  // vertices ja estao no espaco do olho
+  glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+  glEnableClientState( GL_VERTEX_ARRAY );
+  glEnableClientState( GL_NORMAL_ARRAY );
+  glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+  glEnableClientState( GL_COLOR_ARRAY );
+
+  for ( int l = 0; l < NUM_LOTES; l++ ) {
+    if ( lotes[l].empty() )
+      continue;
+    if ( vbos[l] == 0 )
+      glGenBuffers( 1, &vbos[l] );
+    glBindBuffer( GL_ARRAY_BUFFER, vbos[l] );
+    glBufferData( GL_ARRAY_BUFFER,
+                  lotes[l].size() * sizeof( VerticeLote ),
+                  lotes[l].data(),
+                  GL_STREAM_DRAW );
+    const GLsizei s = sizeof( VerticeLote );
+    glVertexPointer( 3, GL_FLOAT, s, (void *)offsetof( VerticeLote, p ) );
+    glNormalPointer( GL_FLOAT, s, (void *)offsetof( VerticeLote, n ) );
+    glTexCoordPointer( 2, GL_FLOAT, s, (void *)offsetof( VerticeLote, t ) );
+    glColorPointer( 4, GL_FLOAT, s, (void *)offsetof( VerticeLote, c ) );
+    glDrawArrays( MODO_LOTE[l], 0, (GLsizei)lotes[l].size() );
+    lotes[l].clear();
+  }
+
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  glPopClientAttrib();
+  glPopMatrix();
+  glMatrixMode( GL_PROJECTION );
+  glPopMatrix();
+  glPopAttrib();  // restaura tambem a cor corrente (indefinida apos o color array)
+  glUseProgram( programa );
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();
+#endif
+}
+
+int Batch::pending() {
+  return totalPendente() + (int)primitiva.size();
+}
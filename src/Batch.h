@@ -0,0 +1,60 @@
+/**
+ * @file Batch.h
+ * @brief Declaração da classe Batch, que agrupa os desenhos em modo imediato em poucos draws.
+ *
+ * @details Os utilitários de desenho (Desenha::drawWireBox, drawSelectedBox, drawGrid,
+ * drawArrow, GUI::drawBox...) emitem poucos vértices por glBegin/glEnd. Com Batch, os vértices
+ * são transformados pela modelview atual na CPU (ficam no espaço do olho, onde a iluminação fixa
+ * já guarda as luzes) e acumulados em um vertex buffer por tipo de primitiva (triângulos, linhas
+ * e pontos). O envio acontece em poucas chamadas quando o estado gravado muda, quando os buffers
+ * enchem e no fim do frame (GUI::displayEnd).
+ *
+ * O estado gravado junto com os vértices é: projeção, viewport, iluminação e materiais, luzes
+ * ligadas, GL_COLOR_MATERIAL, textura 2D (e a textura ligada), blend, teste e máscara de
+ * profundidade, culling, planos de recorte ligados, neblina, modo de polígono, programa em uso,
+ * largura de linha e tamanho de ponto, todos lidos do OpenGL a cada Batch::begin. Como os
+ * desenhos podem ser adiados, chame Batch::flush antes de desenhar diretamente com OpenGL quando
+ * a ordem importa (ex.: transparência). Durante o picking os vértices vão direto para o OpenGL.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <GL/gl.h>
+
+/**
+ * @class Batch
+ * @brief Gravador de vértices com a mesma interface do modo imediato.
+ */
+class Batch {
+public:
+  static bool enabled; /**< @brief Se falso, tudo vai direto para o OpenGL (ligado por padrão). */
+  static int  maxVertices; /**< @brief Vértices acumulados que forçam um envio (padrão 65536). */
+
+  /**
+   * @brief Equivalente a glBegin. Aceita todos os modos do glBegin; faixas, leques, quads e
+   * polígonos são convertidos em triângulos, e faixas e laços de linha, em linhas.
+   */
+  static void begin( GLenum mode );
+
+  /**
+   * @brief Equivalente a glEnd.
+   */
+  static void end();
+
+  static void vertex3f( GLfloat x, GLfloat y, GLfloat z );
+  static void normal3f( GLfloat x, GLfloat y, GLfloat z );
+  static void texCoord2f( GLfloat s, GLfloat t );
+  static void color4f( GLfloat r, GLfloat g, GLfloat b, GLfloat a = 1.0 );
+
+  /**
+   * @brief Envia os vértices acumulados (com o estado gravado) e esvazia os buffers.
+   */
+  static void flush();
+
+  /**
+   * @brief Quantidade de vértices acumulados ainda não enviados.
+   */
+  static int pending();
+};
+
+#endif  // BATCH_H
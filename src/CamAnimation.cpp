@@ -0,0 +1,94 @@
+#include "CamAnimation.h"
+
+#include "Stats.h"
+
+#include <chrono>
+#include <vector>
+
+struct AnimacaoCam {
+  int                                   id;
+  Axis                                  axis;
+  float                                 value;
+  float                                 durationMs;
+  Easing                                easing;
+  std::chrono::steady_clock::time_point inicio;
+  float                                 aplicado;  // fracao (com easing) ja aplicada a camera
+};
+
+static std::vector<AnimacaoCam> animacoes;
+static int                      proximoId   = 1;
+static long                     ultimoFrame  = -1;
+
+int CamAnimation::start( Axis axis, float value, float durationMs, Easing easing ) {
+  AnimacaoCam a = {
+    proximoId++, axis, value, durationMs, easing, std::chrono::steady_clock::now(), 0.0f
+  };
+  animacoes.push_back( a );
+  return a.id;
+}
+
+void CamAnimation::update( Camera *cam ) {
+  if ( animacoes.empty() || Stats::frame() == ultimoFrame )
+    return;
+  ultimoFrame = Stats::frame();
+
+  auto now = std::chrono::steady_clock::now();
+  for ( size_t i = 0; i < animacoes.size(); ) {
+    AnimacaoCam &a = animacoes[i];
+    float        t = 1.0f;
+    if ( a.durationMs > 0.0f )
+      t = std::chrono::duration<float, std::milli>( now - a.inicio ).count() / a.durationMs;
+    if ( t > 1.0f )
+      t = 1.0f;
+
+    float e    = ease( a.easing, t );
+    float step = a.value * ( e - a.aplicado );
+    a.aplicado = e;
+
+    switch ( a.axis ) {
+      case AXIS_X: cam->rotatex( 0, ( HALF_PI / 90.0 ) * step ); break;
+      case AXIS_Y: cam->rotatey( 0, ( HALF_PI / 90.0 ) * step ); break;
+      case AXIS_Z: cam->zoom( 0, 20.0 * step ); break;
+    }
+
+    if ( t >= 1.0f )
+      animacoes.erase( animacoes.begin() + i );
+    else
+      i++;
+  }
+}
+
+bool CamAnimation::isIdle() {
+  return animacoes.empty();
+}
+
+void CamAnimation::cancel( int id ) {
+  for ( size_t i = 0; i < animacoes.size(); i++ ) {
+    if ( animacoes[i].id == id ) {
+      animacoes.erase( animacoes.begin() + i );
+      return;
+    }
+  }
+}
+
+void CamAnimation::cancelAll() {
+  animacoes.clear();
+}
+
+float CamAnimation::ease( Easing easing, float t ) {
+  switch ( easing ) {
+    case EASE_IN_OUT:
+      if ( t < 0.5f )
+        return 4.0f * t * t * t;
+      else {
+        float u = 2.0f * t - 2.0f;
+        return 0.5f * u * u * u + 1.0f;
+      }
+    case EASE_OUT: {
+      float u = t - 1.0f;
+      return u * u * u + 1.0f;
+    }
+    case EASE_LINEAR:
+    default: return t;
+  }
+}
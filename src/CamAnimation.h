@@ -0,0 +1,70 @@
+/**
+ * @file CamAnimation.h
+ * @brief Declaração da classe CamAnimation, que executa as animações automáticas da câmera.
+ *
+ * @details As animações são baseadas em tempo: a cada frame, CamAnimation::update calcula a
+ * fração já decorrida de cada animação, aplica a curva de suavização (easing) e move a câmera
+ * apenas pela diferença em relação ao frame anterior. Assim a duração não depende da taxa do
+ * timer nem de frames lentos, e várias animações podem rodar ao mesmo tempo (os incrementos se
+ * somam).
+ */
+#ifndef CAMANIMATION_H
+#define CAMANIMATION_H
+
+#include "extra.h"
+
+/**
+ * @enum Easing
+ * @brief Curvas de suavização das animações.
+ */
+enum Easing {
+  EASE_LINEAR, /**< @brief Velocidade constante. */
+  EASE_IN_OUT, /**< @brief Acelera no início e desacelera no fim (cúbica). */
+  EASE_OUT     /**< @brief Começa rápido e desacelera no fim (cúbica). */
+};
+
+/**
+ * @class CamAnimation
+ * @brief Animações de câmera concorrentes, dirigidas pelo relógio do frame.
+ */
+class CamAnimation {
+public:
+  /**
+   * @brief Inicia uma animação.
+   * @param axis Eixo do movimento (AXIS_X e AXIS_Y rotacionam, AXIS_Z aproxima/afasta).
+   * @param value Valor total do movimento (graus para rotação, unidades de zoom para AXIS_Z).
+   * @param durationMs Duração em milissegundos.
+   * @param easing Curva de suavização.
+   * @return Identificador da animação (usado por cancel).
+   */
+  static int start( Axis axis, float value, float durationMs, Easing easing = EASE_IN_OUT );
+
+  /**
+   * @brief Avança as animações até o instante atual, movendo a câmera dada.
+   * @details Chamada por GUI::displayInit; chamadas repetidas no mesmo frame (múltiplas
+   * viewports) são ignoradas.
+   */
+  static void update( Camera *cam );
+
+  /**
+   * @brief Indica se não há nenhuma animação em andamento.
+   */
+  static bool isIdle();
+
+  /**
+   * @brief Interrompe uma animação, mantendo a câmera onde está.
+   */
+  static void cancel( int id );
+
+  /**
+   * @brief Interrompe todas as animações.
+   */
+  static void cancelAll();
+
+  /**
+   * @brief Valor da curva de suavização para t em [0,1].
+   */
+  static float ease( Easing easing, float t );
+};
+
+#endif  // CAMANIMATION_H
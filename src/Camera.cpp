@@ -90,3 +90,135 @@ void Camera::adaptavetorcjogotodist( GLfloat r ) {
 }
 
 //---------------------------------------------------------------------------
+void Camera::setProjection(
+  ProjectionMode mode, float fovy, float width, float height, float orthof ) {
+  if ( mode == modoCache && fovy == fovyCache && width == wCache && height == hCache &&
+       orthof == orthofCache )
+    return;
+  modoCache   = mode;
+  fovyCache   = fovy;
+  wCache      = width;
+  hCache      = height;
+  orthofCache = orthof;
+  projValida  = false;
+}
+
+//---------------------------------------------------------------------------
+static bool mesmoVetor( const Vetor3D &a, const Vetor3D &b ) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// e, c e u sao publicos e alterados diretamente pelas subclasses e pela aplicacao, entao a
+// validade da view e verificada comparando com os valores usados no ultimo calculo
+void Camera::atualizaMatrizes() {
+  if ( viewValida && !( mesmoVetor( e, eCache ) && mesmoVetor( c, cCache ) &&
+                        mesmoVetor( u, uCache ) ) )
+    viewValida = false;
+
+  if ( !viewValida ) {
+    eCache         = e;
+    cCache         = c;
+    uCache         = u;
+    mView          = Matriz4::lookAt( e, c, u );
+    viewValida     = true;
+    viewProjValida = false;
+    invViewValida  = false;
+  }
+
+  if ( !projValida ) {
+    float w  = wCache;
+    float h  = hCache > 0.0f ? hCache : 1.0f;
+    float ar = w / h;
+    switch ( modoCache ) {
+      case PROJ_PERSPECTIVE: mProj = Matriz4::perspective( fovyCache, ar, 0.1, 1000. ); break;
+      case PROJ_ORTHO:
+        mProj = Matriz4::ortho(
+          -orthofCache * w, orthofCache * w, -orthofCache * h, orthofCache * h, 0.0, 100.0 );
+        break;
+      case PROJ_OBLIQUE: {
+        // obliqua  //   S . T . T(0,0,-near) . Sh . T(0,0,near)
+        float s         = 5;
+        float nearPlane = 0;
+        // matriz de cisalhamento (projecao obliqua), alfa = 75 e phi = -75 graus
+        static const float shX = 1.0f / tan( grauToRad( 75.0 ) );
+        static const float shY = 1.0f / tan( grauToRad( -75.0 ) );
+        Matriz4            sh;
+        sh( 0, 2 ) = shX;
+        sh( 1, 2 ) = shY;
+        mProj      = Matriz4::ortho( -s, s, -s / ar, s / ar, nearPlane, 20 ) *
+                Matriz4::translation( 0.0, 0.0, -nearPlane ) * sh *
+                Matriz4::translation( 0.0, 0.0, nearPlane );
+        break;
+      }
+    }
+    projValida     = true;
+    viewProjValida = false;
+    invProjValida  = false;
+  }
+
+  if ( !viewProjValida ) {
+    mViewProj      = mProj * mView;
+    viewProjValida = true;
+    invVPValida    = false;
+  }
+}
+
+//---------------------------------------------------------------------------
+const Matriz4 &Camera::view() {
+  atualizaMatrizes();
+  return mView;
+}
+
+//---------------------------------------------------------------------------
+const Matriz4 &Camera::projection() {
+  atualizaMatrizes();
+  return mProj;
+}
+
+//---------------------------------------------------------------------------
+const Matriz4 &Camera::viewProjection() {
+  atualizaMatrizes();
+  return mViewProj;
+}
+
+//---------------------------------------------------------------------------
+const Matriz4 &Camera::inverseView() {
+  atualizaMatrizes();
+  if ( !invViewValida ) {
+    mInvView      = mView.inverse();
+    invViewValida = true;
+  }
+  return mInvView;
+}
+
+//---------------------------------------------------------------------------
+const Matriz4 &Camera::inverseProjection() {
+  atualizaMatrizes();
+  if ( !invProjValida ) {
+    mInvProj      = mProj.inverse();
+    invProjValida = true;
+  }
+  return mInvProj;
+}
+
+//---------------------------------------------------------------------------
+const Matriz4 &Camera::inverseViewProjection() {
+  atualizaMatrizes();
+  if ( !invVPValida ) {
+    mInvViewProj = mViewProj.inverse();
+    invVPValida  = true;
+  }
+  return mInvViewProj;
+}
+
+//---------------------------------------------------------------------------
+Ray Camera::screenRay( float x, float y ) {
+  float h  = hCache > 0.0f ? hCache : 1.0f;
+  float nx = 2.0f * x / wCache - 1.0f;
+  float ny = 1.0f - 2.0f * y / h;
+
+  const Matriz4 &inv   = inverseViewProjection();
+  Vetor3D        pNear = inv.transformPoint( Vetor3D( nx, ny, -1.0f ) );
+  Vetor3D        pFar  = inv.transformPoint( Vetor3D( nx, ny, 1.0f ) );
+  return Ray( pNear, pFar - pNear );
+}
@@ -22,12 +22,24 @@
  */
 #define CAMJOGO 2
 
+#include "Matriz4.h"
+#include "Ray.h"
 #include "Vetor3D.h"
 
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <cmath>
 
+/**
+ * @enum ProjectionMode
+ * @brief Tipo de projeção usada por Camera::setProjection.
+ */
+enum ProjectionMode {
+  PROJ_PERSPECTIVE, /**< @brief Perspectiva (gluPerspective). */
+  PROJ_ORTHO,       /**< @brief Ortográfica (glOrtho), com escala orthof por pixel. */
+  PROJ_OBLIQUE      /**< @brief Oblíqua (ortográfica com cisalhamento em z). */
+};
+
 /**
  * @class Camera
  * @brief Classe base abstrata para representar uma câmera em uma cena 3D.
@@ -158,6 +170,63 @@ public:
    * @param r A nova distância desejada entre o olho (e) e o alvo (c).
    */
   void adaptavetorcjogotodist( GLfloat r );
+
+  /**
+   * @brief Define a projeção da câmera. Só invalida a matriz de projeção se algum parâmetro
+   * mudar.
+   * @param mode Tipo de projeção.
+   * @param fovy Abertura vertical em graus (apenas PROJ_PERSPECTIVE).
+   * @param width Largura da viewport em pixels.
+   * @param height Altura da viewport em pixels.
+   * @param orthof Escala (unidades por pixel) da projeção ortográfica (apenas PROJ_ORTHO).
+   */
+  void setProjection( ProjectionMode mode, float fovy, float width, float height, float orthof );
+
+  /**
+   * @name Matrizes da câmera
+   * @brief Matrizes em cache (column-major, prontas para glLoadMatrixf).
+   * @details São recalculadas apenas quando e, c, u ou os parâmetros de setProjection mudam; as
+   * inversas só são calculadas quando pedidas.
+   * @{
+   */
+  const Matriz4 &view();
+  const Matriz4 &projection();
+  const Matriz4 &viewProjection();
+  const Matriz4 &inverseView();
+  const Matriz4 &inverseProjection();
+  const Matriz4 &inverseViewProjection();
+  /** @} */
+
+  /**
+   * @brief Raio no espaço do mundo que passa pelo pixel (x, y) da janela.
+   * @details Desprojeta os pontos do pixel nos planos near e far com a inversa da
+   * view-projection em cache, então vale para as projeções perspectiva, ortográfica e oblíqua.
+   * Não acessa o OpenGL.
+   * @param x Coordenada X na janela (origem à esquerda, como no GLUT).
+   * @param y Coordenada Y na janela (origem no topo, como no GLUT).
+   * @return Raio com origem no plano near e direção unitária.
+   */
+  Ray screenRay( float x, float y );
+
+private:
+  void atualizaMatrizes();
+
+  // valores de e, c, u e da projecao usados no calculo das matrizes em cache
+  Vetor3D        eCache, cCache, uCache;
+  ProjectionMode modoCache   = PROJ_PERSPECTIVE;
+  float          fovyCache   = 30.0f;
+  float          wCache      = 1.0f;
+  float          hCache      = 1.0f;
+  float          orthofCache = 0.0025f;
+
+  Matriz4 mView, mProj, mViewProj;
+  Matriz4 mInvView, mInvProj, mInvViewProj;
+  bool    viewValida     = false;
+  bool    projValida     = false;
+  bool    viewProjValida = false;
+  bool    invViewValida  = false;
+  bool    invProjValida  = false;
+  bool    invVPValida    = false;
 };
 
 #endif
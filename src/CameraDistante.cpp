@@ -140,25 +140,8 @@ void CameraDistante::rotatez( GLfloat new_x, GLfloat last_x ) {
 //---------------------------------------------------------------------------
 // passando o ponto local a camera (x,y,-1) para as coordenadas do mundo
 Vetor3D CameraDistante::getPickedPoint( GLfloat x, GLfloat y ) {
-  // calculando a base da camera
-  // vetor do centro(center) ao olho(eye) - Zpos
-  Vetor3D Vce = e.subtracao( c );
-  Vce.normaliza();
-  // vetor no sentido positivo da direcao x
-  Vetor3D Xpos = u.prodVetorial( Vce );
-  Xpos.normaliza();
-
-  // mudanca da base da camera para a base do mundo (canonica)
-  float dx = Xpos.x * x + u.x * y + Vce.x * -1;
-  float dy = Xpos.y * x + u.y * y + Vce.y * -1;
-  float dz = Xpos.z * x + u.z * y + Vce.z * -1;
-
-  // translacao em relacao a posicao da camera
-  dx += e.x;
-  dy += e.y;
-  dz += e.z;
-
-  return Vetor3D( dx, dy, dz );
+  // a inversa da view (em cache) leva da base da camera para a base do mundo
+  return inverseView().transformPoint( Vetor3D( x, y, -1 ) );
 }
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,283 @@
+#include "CameraPath.h"
+
+#include "GpuTimer.h"
+#include "Stats.h"
+
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+float CameraPath::segmentSeconds = 2.0f;
+float CameraPath::timestep       = 1.0f / 60.0f;
+
+struct KeyframeCam {
+  Vetor3D e, c, u;
+};
+
+// tempos de um frame da reproducao
+struct AmostraFrame {
+  long  frame;
+  float t;
+  float cpuMs;
+  float intervalMs;
+};
+
+static std::vector<KeyframeCam>  keyframes;
+static std::vector<AmostraFrame> amostras;
+static std::map<long, float>     gpuPorFrame;  // os tempos de GPU chegam frames depois
+static bool                      reproduzindo = false;
+static float                     tempoPath    = 0.0f;
+static long                      ultimoFrame  = -1;
+static int                       passos       = 0;
+static std::string               prefixoCsv;
+
+//---------------------------------------------------------------------------
+// quaternion (w, x, y, z) para a orientacao da camera
+struct Quat {
+  float w, x, y, z;
+};
+
+// base da camera (colunas: direita, up, -direcao) -> quaternion
+static Quat quatDaBase( Vetor3D f, Vetor3D u ) {
+  !f;
+  Vetor3D s = f ^ u;
+  !s;
+  Vetor3D v = s ^ f;
+  // matriz de rotacao R = [s v -f]
+  float m00 = s.x, m01 = v.x, m02 = -f.x;
+  float m10 = s.y, m11 = v.y, m12 = -f.y;
+  float m20 = s.z, m21 = v.z, m22 = -f.z;
+
+  Quat  q;
+  float tr = m00 + m11 + m22;
+  if ( tr > 0.0f ) {
+    float k = 0.5f / sqrt( tr + 1.0f );
+    q       = { 0.25f / k, ( m21 - m12 ) * k, ( m02 - m20 ) * k, ( m10 - m01 ) * k };
+  } else if ( m00 > m11 && m00 > m22 ) {
+    float k = 2.0f * sqrt( 1.0f + m00 - m11 - m22 );
+    q       = { ( m21 - m12 ) / k, 0.25f * k, ( m01 + m10 ) / k, ( m02 + m20 ) / k };
+  } else if ( m11 > m22 ) {
+    float k = 2.0f * sqrt( 1.0f + m11 - m00 - m22 );
+    q       = { ( m02 - m20 ) / k, ( m01 + m10 ) / k, 0.25f * k, ( m12 + m21 ) / k };
+  } else {
+    float k = 2.0f * sqrt( 1.0f + m22 - m00 - m11 );
+    q       = { ( m10 - m01 ) / k, ( m02 + m20 ) / k, ( m12 + m21 ) / k, 0.25f * k };
+  }
+  return q;
+}
+
+// quaternion -> direcao de visao e up
+static void baseDoQuat( Quat q, Vetor3D &f, Vetor3D &u ) {
+  float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  // coluna 1 (up) e coluna 2 (-direcao) da matriz de rotacao
+  u = Vetor3D( 2.0f * ( xy - wz ), 1.0f - 2.0f * ( xx + zz ), 2.0f * ( yz + wx ) );
+  f = Vetor3D( -2.0f * ( xz + wy ), -2.0f * ( yz - wx ), -( 1.0f - 2.0f * ( xx + yy ) ) );
+}
+
+static Quat slerp( Quat a, Quat b, float t ) {
+  float d = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+  if ( d < 0.0f ) {  // caminho mais curto
+    b = { -b.w, -b.x, -b.y, -b.z };
+    d = -d;
+  }
+  float ka = 1.0f - t, kb = t;
+  if ( d < 0.9995f ) {
+    float ang = acos( d );
+    float sn  = sin( ang );
+    ka        = sin( ( 1.0f - t ) * ang ) / sn;
+    kb        = sin( t * ang ) / sn;
+  }
+  Quat  q = { ka * a.w + kb * b.w, ka * a.x + kb * b.x, ka * a.y + kb * b.y, ka * a.z + kb * b.z };
+  float n = sqrt( q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z );
+  return { q.w / n, q.x / n, q.y / n, q.z / n };
+}
+
+// Catmull-Rom uniforme entre p1 e p2
+static Vetor3D catmullRom( Vetor3D p0, Vetor3D p1, Vetor3D p2, Vetor3D p3, float t ) {
+  float t2 = t * t, t3 = t2 * t;
+  return ( p1 * 2.0f + ( p2 - p0 ) * t + ( p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3 ) * t2 +
+           ( p1 * 3.0f - p0 - p2 * 3.0f + p3 ) * t3 ) *
+         0.5f;
+}
+
+//---------------------------------------------------------------------------
+void CameraPath::addKeyframe( Camera *cam ) {
+  keyframes.push_back( { cam->e, cam->c, cam->u } );
+  printf( "CameraPath: keyframe %zu adicionado\n", keyframes.size() );
+}
+
+void CameraPath::clear() {
+  stop();
+  keyframes.clear();
+}
+
+int CameraPath::size() {
+  return (int)keyframes.size();
+}
+
+float CameraPath::duration() {
+  return keyframes.size() < 2 ? 0.0f : ( keyframes.size() - 1 ) * segmentSeconds;
+}
+
+bool CameraPath::save( const char *path ) {
+  FILE *f = fopen( path, "w" );
+  if ( !f )
+    return false;
+  for ( const KeyframeCam &k : keyframes )
+    fprintf( f,
+             "%.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n",
+             k.e.x, k.e.y, k.e.z, k.c.x, k.c.y, k.c.z, k.u.x, k.u.y, k.u.z );
+  fclose( f );
+  return true;
+}
+
+bool CameraPath::load( const char *path ) {
+  FILE *f = fopen( path, "r" );
+  if ( !f )
+    return false;
+  stop();
+  keyframes.clear();
+  KeyframeCam k;
+  while ( fscanf( f,
+                  "%f %f %f %f %f %f %f %f %f",
+                  &k.e.x, &k.e.y, &k.e.z, &k.c.x, &k.c.y, &k.c.z, &k.u.x, &k.u.y, &k.u.z ) == 9 )
+    keyframes.push_back( k );
+  fclose( f );
+  return true;
+}
+
+void CameraPath::sample( float t, Vetor3D &e, Vetor3D &c, Vetor3D &u ) {
+  int n = (int)keyframes.size();
+  if ( n == 0 )
+    return;
+  if ( n == 1 || t <= 0.0f ) {
+    e = keyframes[0].e;
+    c = keyframes[0].c;
+    u = keyframes[0].u;
+    return;
+  }
+
+  float s = t / segmentSeconds;
+  int   i = (int)s;
+  if ( i >= n - 1 ) {
+    i = n - 2;
+    s = n - 1;
+  }
+  float lt = s - i;
+
+  // pontos de controle das pontas repetidos
+  KeyframeCam k0 = keyframes[i > 0 ? i - 1 : 0];
+  KeyframeCam k1 = keyframes[i];
+  KeyframeCam k2 = keyframes[i + 1];
+  KeyframeCam k3 = keyframes[i + 2 < n ? i + 2 : n - 1];
+
+  e = catmullRom( k0.e, k1.e, k2.e, k3.e, lt );
+
+  Vetor3D d1 = k1.c - k1.e;
+  Vetor3D d2 = k2.c - k2.e;
+  float   r  = d1.modulo() * ( 1.0f - lt ) + d2.modulo() * lt;
+  Quat    q  = slerp( quatDaBase( d1, k1.u ), quatDaBase( d2, k2.u ), lt );
+
+  Vetor3D f;
+  baseDoQuat( q, f, u );
+  c = e + f * r;
+}
+
+//---------------------------------------------------------------------------
+static void gravaCsv() {
+  if ( amostras.empty() )
+    return;
+
+  char      data[32];
+  time_t    agora = time( nullptr );
+  struct tm tmLocal;
+#ifdef _WIN32
+  localtime_s( &tmLocal, &agora );
+#else
+  localtime_r( &agora, &tmLocal );
+#endif
+  strftime( data, sizeof( data ), "%Y%m%d_%H%M%S", &tmLocal );
+  std::string nome = prefixoCsv + "_" + data + ".csv";
+
+  FILE *f = fopen( nome.c_str(), "w" );
+  if ( !f ) {
+    printf( "CameraPath: nao foi possivel criar %s\n", nome.c_str() );
+    return;
+  }
+  fprintf( f, "frame,time_s,cpu_ms,interval_ms,gpu_ms\n" );
+  double soma = 0.0, maximo = 0.0;
+  for ( const AmostraFrame &a : amostras ) {
+    fprintf( f, "%ld,%.4f,%.4f,%.4f,", a.frame, a.t, a.cpuMs, a.intervalMs );
+    // gpu_ms do mesmo frame; vazio se o resultado nao chegou (ou foi descartado)
+    auto gpu = gpuPorFrame.find( a.frame );
+    if ( gpu != gpuPorFrame.end() )
+      fprintf( f, "%.4f", gpu->second );
+    fprintf( f, "\n" );
+    soma += a.intervalMs;
+    if ( a.intervalMs > maximo )
+      maximo = a.intervalMs;
+  }
+  fclose( f );
+  printf( "CameraPath: %zu frames gravados em %s (intervalo medio %.3f ms, max %.3f ms)\n",
+          amostras.size(),
+          nome.c_str(),
+          soma / amostras.size(),
+          maximo );
+}
+
+void CameraPath::play( const char *csvPrefix ) {
+  if ( reproduzindo || keyframes.size() < 2 )
+    return;
+  amostras.clear();
+  gpuPorFrame.clear();
+  prefixoCsv   = csvPrefix;
+  tempoPath    = 0.0f;
+  passos       = 0;
+  ultimoFrame  = -1;
+  reproduzindo = true;
+}
+
+void CameraPath::stop() {
+  if ( !reproduzindo )
+    return;
+  reproduzindo = false;
+  gravaCsv();
+  amostras.clear();
+  gpuPorFrame.clear();
+}
+
+bool CameraPath::isPlaying() {
+  return reproduzindo;
+}
+
+void CameraPath::update( Camera *cam ) {
+  if ( !reproduzindo || Stats::frame() == ultimoFrame )
+    return;
+  ultimoFrame = Stats::frame();
+
+  // tempos do frame anterior (o primeiro frame da reproducao e descartado); o tempo de GPU e
+  // guardado pelo frame em que foi medido
+  if ( passos > 1 ) {
+    amostras.push_back( { Stats::frame() - 1,
+                          ( passos - 1 ) * timestep,
+                          Stats::cpuFrameMs(),
+                          Stats::frameIntervalMs() } );
+    const auto &gpu = Stats::gpuPasses();
+    auto        it  = gpu.find( "frame" );
+    if ( it != gpu.end() && GpuTimer::lastMeasuredFrame() >= 0 )
+      gpuPorFrame[GpuTimer::lastMeasuredFrame()] = it->second.last;
+  }
+
+  if ( tempoPath > duration() + 0.5f * timestep ) {
+    stop();
+    return;
+  }
+
+  sample( tempoPath, cam->e, cam->c, cam->u );
+  passos++;
+  tempoPath = passos * timestep;  // sem acumular erro de arredondamento
+}
@@ -0,0 +1,93 @@
+/**
+ * @file CameraPath.h
+ * @brief Declaração da classe CameraPath, que grava e reproduz trajetos de câmera.
+ *
+ * @details Os keyframes guardam o olho, o centro e o vetor up da câmera ativa (CameraDistante ou
+ * CameraJogo). Na reprodução, a posição do olho é interpolada por Catmull-Rom e a orientação
+ * (direção de visão e up) por slerp de quaternions; a distância ao centro é interpolada
+ * linearmente. O tempo do trajeto avança um passo fixo por frame, independente da duração real
+ * do frame, então o trajeto é sempre o mesmo em todas as execuções. Os tempos de cada frame são
+ * gravados em um CSV por execução, para comparar builds.
+ *
+ * Teclas (glutGUI::defaultKey): 'k' adiciona um keyframe, 'K' apaga o trajeto e 'p' inicia ou
+ * interrompe a reprodução.
+ */
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include "Camera.h"
+#include "Vetor3D.h"
+
+/**
+ * @class CameraPath
+ * @brief Gravação e reprodução de trajetos de câmera com passo de tempo fixo.
+ */
+class CameraPath {
+public:
+  static float segmentSeconds; /**< @brief Duração de cada trecho entre dois keyframes. */
+  static float timestep;       /**< @brief Avanço do tempo do trajeto por frame (segundos). */
+
+  /**
+   * @brief Adiciona a posição atual da câmera como keyframe.
+   */
+  static void addKeyframe( Camera *cam );
+
+  /**
+   * @brief Apaga todos os keyframes.
+   */
+  static void clear();
+
+  /**
+   * @brief Quantidade de keyframes.
+   */
+  static int size();
+
+  /**
+   * @brief Duração total do trajeto em segundos.
+   */
+  static float duration();
+
+  /**
+   * @brief Grava os keyframes em um arquivo texto (uma linha "ex ey ez cx cy cz ux uy uz" por
+   * keyframe).
+   * @return `false` se o arquivo não pôde ser criado.
+   */
+  static bool save( const char *path );
+
+  /**
+   * @brief Substitui os keyframes pelos de um arquivo gravado por save.
+   * @return `false` se o arquivo não pôde ser lido.
+   */
+  static bool load( const char *path );
+
+  /**
+   * @brief Calcula a câmera no instante t do trajeto.
+   * @param t Tempo em segundos (limitado a [0, duration()]).
+   */
+  static void sample( float t, Vetor3D &e, Vetor3D &c, Vetor3D &u );
+
+  /**
+   * @brief Inicia a reprodução do trajeto (são necessários ao menos 2 keyframes).
+   * @param csvPrefix Prefixo do arquivo CSV com os tempos por frame desta execução.
+   */
+  static void play( const char *csvPrefix = "qxgl_path_run" );
+
+  /**
+   * @brief Interrompe a reprodução e grava o CSV com os tempos dos frames.
+   */
+  static void stop();
+
+  /**
+   * @brief Indica se há uma reprodução em andamento.
+   */
+  static bool isPlaying();
+
+  /**
+   * @brief Avança a reprodução um passo e posiciona a câmera. Chamada por GUI::displayInit
+   * (chamadas repetidas no mesmo frame são ignoradas). Ao passar do fim do trajeto, a câmera fica
+   * no último keyframe e a reprodução termina.
+   */
+  static void update( Camera *cam );
+};
+
+#endif  // CAMERAPATH_H
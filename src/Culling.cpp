@@ -0,0 +1,304 @@
+#include "Culling.h"
+
+#include <utility>
+
+#if defined( __AVX__ )
+  #include <immintrin.h>
+  #define QXGL_CULL_AVX
+#elif defined( __SSE2__ )
+  #include <emmintrin.h>
+  #define QXGL_CULL_SSE
+#endif
+
+//---------------------------------------------------------------------------
+// Frustum
+
+// extracao dos planos a partir das linhas da matriz (Gribb e Hartmann)
+Frustum Frustum::fromMatrix( const Matriz4 &m ) {
+  Frustum f;
+  for ( int j = 0; j < 4; j++ ) {
+    f.planes[LEFT][j]       = m( 3, j ) + m( 0, j );
+    f.planes[RIGHT][j]      = m( 3, j ) - m( 0, j );
+    f.planes[BOTTOM][j]     = m( 3, j ) + m( 1, j );
+    f.planes[TOP][j]        = m( 3, j ) - m( 1, j );
+    f.planes[NEAR_PLANE][j] = m( 3, j ) + m( 2, j );
+    f.planes[FAR_PLANE][j]  = m( 3, j ) - m( 2, j );
+  }
+  // normaliza para que a distancia seja em unidades do mundo (teste das esferas)
+  for ( int p = 0; p < NUM_PLANES; p++ ) {
+    float *pl  = f.planes[p];
+    float  len = sqrt( pl[0] * pl[0] + pl[1] * pl[1] + pl[2] * pl[2] );
+    if ( len > 0.0f )
+      for ( int j = 0; j < 4; j++ )
+        pl[j] /= len;
+  }
+  return f;
+}
+
+Frustum Frustum::fromCamera( Camera *cam ) {
+  return fromMatrix( cam->viewProjection() );
+}
+
+Frustum Frustum::fromScreenRect(
+  const Matriz4 &viewProj, float x0, float y0, float x1, float y1, int w, int h ) {
+  if ( x1 < x0 )
+    std::swap( x0, x1 );
+  if ( y1 < y0 )
+    std::swap( y0, y1 );
+  // no minimo 1 pixel (clique sem arrastar)
+  x1 = fmax( x1, x0 + 1.0f );
+  y1 = fmax( y1, y0 + 1.0f );
+  w  = w > 0 ? w : 1;
+  h  = h > 0 ? h : 1;
+
+  // retangulo em NDC (y da janela cresce para baixo)
+  float nx0 = 2.0f * x0 / w - 1.0f, nx1 = 2.0f * x1 / w - 1.0f;
+  float ny0 = 1.0f - 2.0f * y1 / h, ny1 = 1.0f - 2.0f * y0 / h;
+
+  // leva o retangulo para [-1, 1] (como a gluPickMatrix)
+  Matriz4 pick;
+  pick( 0, 0 ) = 2.0f / ( nx1 - nx0 );
+  pick( 0, 3 ) = -( nx1 + nx0 ) / ( nx1 - nx0 );
+  pick( 1, 1 ) = 2.0f / ( ny1 - ny0 );
+  pick( 1, 3 ) = -( ny1 + ny0 ) / ( ny1 - ny0 );
+  return fromMatrix( pick * viewProj );
+}
+
+bool Frustum::testSphere( float x, float y, float z, float radius ) const {
+  for ( int p = 0; p < NUM_PLANES; p++ ) {
+    const float *pl = planes[p];
+    if ( pl[0] * x + pl[1] * y + pl[2] * z + pl[3] < -radius )
+      return false;
+  }
+  return true;
+}
+
+// para cada plano basta testar o vertice da caixa mais a frente na direcao da normal
+bool Frustum::testAABB( Vetor3D min, Vetor3D max ) const {
+  for ( int p = 0; p < NUM_PLANES; p++ ) {
+    const float *pl = planes[p];
+    float        x  = pl[0] >= 0.0f ? max.x : min.x;
+    float        y  = pl[1] >= 0.0f ? max.y : min.y;
+    float        z  = pl[2] >= 0.0f ? max.z : min.z;
+    if ( pl[0] * x + pl[1] * y + pl[2] * z + pl[3] < 0.0f )
+      return false;
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+// AABBSet / SphereSet
+
+int AABBSet::add( Vetor3D min, Vetor3D max ) {
+  minX.push_back( min.x );
+  minY.push_back( min.y );
+  minZ.push_back( min.z );
+  maxX.push_back( max.x );
+  maxY.push_back( max.y );
+  maxZ.push_back( max.z );
+  return size() - 1;
+}
+
+void AABBSet::set( int i, Vetor3D min, Vetor3D max ) {
+  minX[i] = min.x;
+  minY[i] = min.y;
+  minZ[i] = min.z;
+  maxX[i] = max.x;
+  maxY[i] = max.y;
+  maxZ[i] = max.z;
+}
+
+void AABBSet::clear() {
+  minX.clear();
+  minY.clear();
+  minZ.clear();
+  maxX.clear();
+  maxY.clear();
+  maxZ.clear();
+}
+
+void AABBSet::reserve( int n ) {
+  minX.reserve( n );
+  minY.reserve( n );
+  minZ.reserve( n );
+  maxX.reserve( n );
+  maxY.reserve( n );
+  maxZ.reserve( n );
+}
+
+int SphereSet::add( float x, float y, float z, float radius ) {
+  this->x.push_back( x );
+  this->y.push_back( y );
+  this->z.push_back( z );
+  this->radius.push_back( radius );
+  return size() - 1;
+}
+
+void SphereSet::set( int i, float x, float y, float z, float radius ) {
+  this->x[i]      = x;
+  this->y[i]      = y;
+  this->z[i]      = z;
+  this->radius[i] = radius;
+}
+
+void SphereSet::clear() {
+  x.clear();
+  y.clear();
+  z.clear();
+  radius.clear();
+}
+
+void SphereSet::reserve( int n ) {
+  x.reserve( n );
+  y.reserve( n );
+  z.reserve( n );
+  radius.reserve( n );
+}
+
+//---------------------------------------------------------------------------
+// Culling
+
+int Culling::simdWidth() {
+#if defined( QXGL_CULL_AVX )
+  return 8;
+#elif defined( QXGL_CULL_SSE )
+  return 4;
+#else
+  return 1;
+#endif
+}
+
+// escreve em out os indices (base + bit) dos bits ligados de mask
+static inline int *emiteVisiveis( int *out, int base, unsigned mask ) {
+  while ( mask ) {
+    *out++ = base + __builtin_ctz( mask );
+    mask &= mask - 1;
+  }
+  return out;
+}
+
+int Culling::cull( const Frustum &frustum, const AABBSet &boxes, std::vector<int> &visible ) {
+  const int n = boxes.size();
+  visible.resize( n );
+  int *out = visible.data();
+
+  // por plano, o vertice mais a frente e escolhido uma vez para o lote inteiro
+  const float *px[Frustum::NUM_PLANES], *py[Frustum::NUM_PLANES], *pz[Frustum::NUM_PLANES];
+  for ( int p = 0; p < Frustum::NUM_PLANES; p++ ) {
+    const float *pl = frustum.planes[p];
+    px[p]           = ( pl[0] >= 0.0f ? boxes.maxX : boxes.minX ).data();
+    py[p]           = ( pl[1] >= 0.0f ? boxes.maxY : boxes.minY ).data();
+    pz[p]           = ( pl[2] >= 0.0f ? boxes.maxZ : boxes.minZ ).data();
+  }
+
+  int i = 0;
+#if defined( QXGL_CULL_AVX )
+  __m256 pa[Frustum::NUM_PLANES], pb[Frustum::NUM_PLANES], pc[Frustum::NUM_PLANES],
+    pd[Frustum::NUM_PLANES];
+  for ( int p = 0; p < Frustum::NUM_PLANES; p++ ) {
+    pa[p] = _mm256_set1_ps( frustum.planes[p][0] );
+    pb[p] = _mm256_set1_ps( frustum.planes[p][1] );
+    pc[p] = _mm256_set1_ps( frustum.planes[p][2] );
+    pd[p] = _mm256_set1_ps( frustum.planes[p][3] );
+  }
+  for ( ; i + 8 <= n; i += 8 ) {
+    unsigned fora = 0;
+    for ( int p = 0; p < Frustum::NUM_PLANES && fora != 0xFF; p++ ) {
+      __m256 d = _mm256_add_ps(
+        _mm256_add_ps( _mm256_mul_ps( pa[p], _mm256_loadu_ps( px[p] + i ) ),
+                       _mm256_mul_ps( pb[p], _mm256_loadu_ps( py[p] + i ) ) ),
+        _mm256_add_ps( _mm256_mul_ps( pc[p], _mm256_loadu_ps( pz[p] + i ) ), pd[p] ) );
+      fora |= _mm256_movemask_ps( _mm256_cmp_ps( d, _mm256_setzero_ps(), _CMP_LT_OQ ) );
+    }
+    out = emiteVisiveis( out, i, ~fora & 0xFF );
+  }
+#elif defined( QXGL_CULL_SSE )
+  __m128 pa[Frustum::NUM_PLANES], pb[Frustum::NUM_PLANES], pc[Frustum::NUM_PLANES],
+    pd[Frustum::NUM_PLANES];
+  for ( int p = 0; p < Frustum::NUM_PLANES; p++ ) {
+    pa[p] = _mm_set1_ps( frustum.planes[p][0] );
+    pb[p] = _mm_set1_ps( frustum.planes[p][1] );
+    pc[p] = _mm_set1_ps( frustum.planes[p][2] );
+    pd[p] = _mm_set1_ps( frustum.planes[p][3] );
+  }
+  for ( ; i + 4 <= n; i += 4 ) {
+    unsigned fora = 0;
+    // a maioria dos lotes costuma ficar toda fora ja nos primeiros planos
+    for ( int p = 0; p < Frustum::NUM_PLANES && fora != 0xF; p++ ) {
+      __m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( pa[p], _mm_loadu_ps( px[p] + i ) ),
+                                         _mm_mul_ps( pb[p], _mm_loadu_ps( py[p] + i ) ) ),
+                             _mm_add_ps( _mm_mul_ps( pc[p], _mm_loadu_ps( pz[p] + i ) ), pd[p] ) );
+      fora |= _mm_movemask_ps( _mm_cmplt_ps( d, _mm_setzero_ps() ) );
+    }
+    out = emiteVisiveis( out, i, ~fora & 0xF );
+  }
+#endif
+  // restante (ou tudo, sem SIMD)
+  for ( ; i < n; i++ ) {
+    bool dentro = true;
+    for ( int p = 0; p < Frustum::NUM_PLANES && dentro; p++ ) {
+      const float *pl = frustum.planes[p];
+      dentro          = pl[0] * px[p][i] + pl[1] * py[p][i] + pl[2] * pz[p][i] + pl[3] >= 0.0f;
+    }
+    if ( dentro )
+      *out++ = i;
+  }
+
+  int count = (int)( out - visible.data() );
+  visible.resize( count );
+  return count;
+}
+
+int Culling::cull( const Frustum &frustum, const SphereSet &spheres, std::vector<int> &visible ) {
+  const int n = spheres.size();
+  visible.resize( n );
+  int *out = visible.data();
+
+  const float *x = spheres.x.data(), *y = spheres.y.data(), *z = spheres.z.data();
+  const float *r = spheres.radius.data();
+
+  int i = 0;
+#if defined( QXGL_CULL_AVX )
+  for ( ; i + 8 <= n; i += 8 ) {
+    __m256 fora   = _mm256_setzero_ps();
+    __m256 menosR = _mm256_sub_ps( _mm256_setzero_ps(), _mm256_loadu_ps( r + i ) );
+    __m256 vx     = _mm256_loadu_ps( x + i );
+    __m256 vy     = _mm256_loadu_ps( y + i );
+    __m256 vz     = _mm256_loadu_ps( z + i );
+    for ( int p = 0; p < Frustum::NUM_PLANES; p++ ) {
+      const float *pl = frustum.planes[p];
+      __m256       d  = _mm256_add_ps(
+        _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( pl[0] ), vx ),
+                       _mm256_mul_ps( _mm256_set1_ps( pl[1] ), vy ) ),
+        _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( pl[2] ), vz ), _mm256_set1_ps( pl[3] ) ) );
+      fora = _mm256_or_ps( fora, _mm256_cmp_ps( d, menosR, _CMP_LT_OQ ) );
+    }
+    out = emiteVisiveis( out, i, ~_mm256_movemask_ps( fora ) & 0xFF );
+  }
+#elif defined( QXGL_CULL_SSE )
+  for ( ; i + 4 <= n; i += 4 ) {
+    __m128 fora   = _mm_setzero_ps();
+    __m128 menosR = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( r + i ) );
+    __m128 vx     = _mm_loadu_ps( x + i );
+    __m128 vy     = _mm_loadu_ps( y + i );
+    __m128 vz     = _mm_loadu_ps( z + i );
+    for ( int p = 0; p < Frustum::NUM_PLANES; p++ ) {
+      const float *pl = frustum.planes[p];
+      __m128       xy = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( pl[0] ), vx ),
+                                  _mm_mul_ps( _mm_set1_ps( pl[1] ), vy ) );
+      __m128       d  = _mm_add_ps(
+        xy, _mm_add_ps( _mm_mul_ps( _mm_set1_ps( pl[2] ), vz ), _mm_set1_ps( pl[3] ) ) );
+      fora = _mm_or_ps( fora, _mm_cmplt_ps( d, menosR ) );
+    }
+    out = emiteVisiveis( out, i, ~_mm_movemask_ps( fora ) & 0xF );
+  }
+#endif
+  for ( ; i < n; i++ ) {
+    if ( frustum.testSphere( x[i], y[i], z[i], r[i] ) )
+      *out++ = i;
+  }
+
+  int count = (int)( out - visible.data() );
+  visible.resize( count );
+  return count;
+}
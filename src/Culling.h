@@ -0,0 +1,140 @@
+/**
+ * @file Culling.h
+ * @brief Declaração do recorte por volume de visão (frustum culling) em lote.
+ *
+ * @details Os planos do frustum são extraídos da matriz view-projection da câmera
+ * (Camera::viewProjection). Os volumes envolventes dos objetos ficam em arrays separados por
+ * coordenada (SoA), o que permite testar 4 (SSE) ou 8 (AVX, com a opção QXGL_SIMD_AVX do CMake)
+ * objetos por instrução; sem SIMD é usado o teste escalar. O resultado é a lista compacta dos
+ * índices visíveis.
+ */
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "Camera.h"
+#include "Matriz4.h"
+#include "Vetor3D.h"
+
+#include <vector>
+
+/**
+ * @class Frustum
+ * @brief Os 6 planos do volume de visão, com normais unitárias apontando para dentro.
+ */
+class Frustum {
+public:
+  /**
+   * @enum Plane
+   * @brief Índices dos planos.
+   */
+  enum Plane { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, NUM_PLANES };
+
+  float planes[NUM_PLANES][4]; /**< @brief Coeficientes (a, b, c, d) de ax + by + cz + d >= 0. */
+
+  /**
+   * @brief Extrai os planos de uma matriz de projeção combinada.
+   * @details Com viewProjection os planos ficam no espaço do mundo; com
+   * viewProjection * modelo, no espaço do objeto.
+   */
+  static Frustum fromMatrix( const Matriz4 &viewProj );
+
+  /**
+   * @brief Frustum da câmera com a projeção definida por Camera::setProjection.
+   */
+  static Frustum fromCamera( Camera *cam );
+
+  /**
+   * @brief Sub-frustum do retângulo (x0, y0)-(x1, y1) da janela, em pixels com y para baixo
+   * (coordenadas do GLUT), equivalente a aplicar gluPickMatrix sobre a projeção.
+   * @param viewProj Matriz view-projection da câmera.
+   * @param w, h Tamanho da janela.
+   */
+  static Frustum fromScreenRect(
+    const Matriz4 &viewProj, float x0, float y0, float x1, float y1, int w, int h );
+
+  /**
+   * @brief Testa uma esfera (falso apenas se estiver totalmente fora).
+   */
+  bool testSphere( float x, float y, float z, float radius ) const;
+
+  /**
+   * @brief Testa uma caixa alinhada aos eixos (falso apenas se estiver totalmente fora).
+   */
+  bool testAABB( Vetor3D min, Vetor3D max ) const;
+};
+
+/**
+ * @class AABBSet
+ * @brief Conjunto de caixas alinhadas aos eixos armazenadas por coordenada (SoA).
+ */
+class AABBSet {
+public:
+  std::vector<float> minX, minY, minZ;
+  std::vector<float> maxX, maxY, maxZ;
+
+  /**
+   * @brief Adiciona uma caixa e retorna o seu índice.
+   */
+  int add( Vetor3D min, Vetor3D max );
+
+  /**
+   * @brief Altera a caixa de índice i (ex.: objeto que se moveu).
+   */
+  void set( int i, Vetor3D min, Vetor3D max );
+
+  int  size() const { return (int)minX.size(); }
+  void clear();
+  void reserve( int n );
+};
+
+/**
+ * @class SphereSet
+ * @brief Conjunto de esferas envolventes armazenadas por coordenada (SoA).
+ */
+class SphereSet {
+public:
+  std::vector<float> x, y, z, radius;
+
+  /**
+   * @brief Adiciona uma esfera e retorna o seu índice.
+   */
+  int add( float x, float y, float z, float radius );
+
+  /**
+   * @brief Altera a esfera de índice i.
+   */
+  void set( int i, float x, float y, float z, float radius );
+
+  int  size() const { return (int)x.size(); }
+  void clear();
+  void reserve( int n );
+};
+
+/**
+ * @class Culling
+ * @brief Testes em lote contra o frustum.
+ */
+class Culling {
+public:
+  /**
+   * @brief Seleciona as caixas que intersectam o frustum.
+   * @param visible Recebe os índices visíveis, em ordem crescente (o conteúdo anterior é
+   * descartado).
+   * @return Quantidade de objetos visíveis.
+   */
+  static int cull( const Frustum &frustum, const AABBSet &boxes, std::vector<int> &visible );
+
+  /**
+   * @brief Seleciona as esferas que intersectam o frustum.
+   * @param visible Recebe os índices visíveis, em ordem crescente.
+   * @return Quantidade de objetos visíveis.
+   */
+  static int cull( const Frustum &frustum, const SphereSet &spheres, std::vector<int> &visible );
+
+  /**
+   * @brief Largura do SIMD usado nos testes em lote (8, 4 ou 1 quando escalar).
+   */
+  static int simdWidth();
+};
+
+#endif  // CULLING_H
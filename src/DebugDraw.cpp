@@ -0,0 +1,341 @@
+#include "DebugDraw.h"
+
+#include "GLInstrument.h"
+#include "Trace.h"
+#include "extra.h"
+
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+bool DebugDraw::enabled = true;
+
+// vertice no formato GL_C4UB_V3F
+struct VerticeDebug {
+  GLubyte c[4];
+  GLfloat p[3];
+};
+
+// listas por tipo de primitiva e teste de profundidade
+enum { LINHAS_PROF, TRIANGULOS_PROF, LINHAS_FRENTE, TRIANGULOS_FRENTE, NUM_LISTAS };
+
+// forma que dura mais de um frame
+struct FormaPersistente {
+  int                       frames;
+  int                       lista;
+  std::vector<VerticeDebug> v;
+};
+
+// buffer de uma thread: so a propria thread grava e so a thread principal coleta, no flush
+struct FilaThread {
+  std::mutex                    mutex;
+  std::vector<VerticeDebug>     listas[NUM_LISTAS];
+  std::vector<FormaPersistente> persistentes;
+};
+
+// a lista de filas so e alterada quando uma thread grava pela primeira vez
+static std::mutex                mutexFilas;
+static std::vector<FilaThread *> filas;
+static thread_local FilaThread  *filaLocal = nullptr;
+
+// dados do frame (so na thread principal): reaproveitados de um frame para o outro
+static std::vector<VerticeDebug>     frame[NUM_LISTAS];
+static std::vector<FormaPersistente> persistentes;
+static GLuint                        vboDebug = 0;
+
+static FilaThread *filaDaThread() {
+  if ( !filaLocal ) {
+    FilaThread                 *f = new FilaThread();  // vive ate o fim do programa
+    std::lock_guard<std::mutex> lock( mutexFilas );
+    filas.push_back( f );
+    filaLocal = f;
+  }
+  return filaLocal;
+}
+
+// grava os vertices de uma forma direto na fila da thread: na lista do frame (reaproveitada) ou,
+// se durar mais de um frame, no vetor de uma nova forma persistente. A fila fica travada enquanto
+// a forma existe (o flush nao pode coletar uma forma pela metade)
+class Forma {
+public:
+  Forma( DebugDraw::Color cor, bool depthTest, int frames, bool triangulos )
+    : fila( filaDaThread() ), lock( fila->mutex ) {
+    int lista = ( depthTest ? 0 : LINHAS_FRENTE ) + ( triangulos ? 1 : 0 );
+    if ( frames <= 1 )
+      v = &fila->listas[lista];
+    else {
+      fila->persistentes.push_back( { frames, lista, {} } );
+      v = &fila->persistentes.back().v;
+    }
+    c[0] = byteCor( cor.r );
+    c[1] = byteCor( cor.g );
+    c[2] = byteCor( cor.b );
+    c[3] = byteCor( cor.a );
+  }
+
+  void vertice( Vetor3D p, float sombra = 1.0 ) {
+    VerticeDebug vd = { { (GLubyte)( c[0] * sombra ), (GLubyte)( c[1] * sombra ),
+                          (GLubyte)( c[2] * sombra ), c[3] },
+                        { (GLfloat)p.x, (GLfloat)p.y, (GLfloat)p.z } };
+    v->push_back( vd );
+  }
+
+  void segmento( Vetor3D a, Vetor3D b ) {
+    vertice( a );
+    vertice( b );
+  }
+
+private:
+  static GLubyte byteCor( float x ) {
+    return (GLubyte)( x <= 0.0f ? 0 : x >= 1.0f ? 255 : x * 255.0f + 0.5f );
+  }
+
+  FilaThread                 *fila;
+  std::lock_guard<std::mutex> lock;
+  std::vector<VerticeDebug>  *v;
+  GLubyte                     c[4];
+};
+
+// sombreamento fixo das faces (luz vinda de cima), para os cones nao ficarem chapados
+static float sombraFace( Vetor3D n ) {
+  Vetor3D l( 0.3, 0.9, 0.3 );
+  float   d = n * l.getUnit();
+  return 0.55f + 0.45f * ( d > 0.0f ? d : 0.0f );
+}
+
+// cone com a ponta em "ponta", apontando na direcao unitaria d
+static void cone( Forma &f, Vetor3D ponta, Vetor3D d, float raio, float comp ) {
+  const int nLados = 8;
+  Vetor3D   a      = fabs( d.x ) < 0.9 ? Vetor3D( 1, 0, 0 ) : Vetor3D( 0, 1, 0 );
+  Vetor3D   u      = ( a ^ d ).getUnit();
+  Vetor3D   v      = d ^ u;
+  Vetor3D   base   = ponta - d * comp;
+  float     sBase  = sombraFace( d * -1.0 );
+  for ( int i = 0; i < nLados; i++ ) {
+    float   t0 = 2 * M_PI * i / nLados, t1 = 2 * M_PI * ( i + 1 ) / nLados;
+    Vetor3D p0 = base + ( u * cos( t0 ) + v * sin( t0 ) ) * raio;
+    Vetor3D p1 = base + ( u * cos( t1 ) + v * sin( t1 ) ) * raio;
+    float   s  = sombraFace( ( ( p1 - p0 ) ^ ( ponta - p0 ) ).getUnit() );
+    f.vertice( p0, s );
+    f.vertice( p1, s );
+    f.vertice( ponta, s );
+    f.vertice( base, sBase );
+    f.vertice( p1, sBase );
+    f.vertice( p0, sBase );
+  }
+}
+
+// seta com uma ou duas pontas; a haste vai para as linhas e as pontas para os triangulos
+static void seta( Vetor3D          from,
+                  Vetor3D          to,
+                  DebugDraw::Color cor,
+                  float            size,
+                  bool             depthTest,
+                  int              frames,
+                  bool             dupla ) {
+  Vetor3D d   = to - from;
+  float   len = d.modulo();
+  if ( len <= 0.0f )
+    return;
+  d.normaliza();
+  float raio = size > 0.0f ? size : 0.04f * len;
+  float comp = fmin( 3.0f * raio, dupla ? 0.5f * len : len );
+
+  {
+    Forma haste( cor, depthTest, frames, false );
+    haste.segmento( dupla ? from + d * comp : from, to - d * comp );
+  }  // libera a fila para as pontas
+
+  Forma pontas( cor, depthTest, frames, true );
+  cone( pontas, to, d, raio, comp );
+  if ( dupla )
+    cone( pontas, from, d * -1.0, raio, comp );
+}
+
+void DebugDraw::line( Vetor3D a, Vetor3D b, Color color, bool depthTest, int frames ) {
+  if ( !enabled )
+    return;
+  Forma f( color, depthTest, frames, false );
+  f.segmento( a, b );
+}
+
+void DebugDraw::arrow(
+  Vetor3D from, Vetor3D to, Color color, float size, bool depthTest, int frames ) {
+  if ( enabled )
+    seta( from, to, color, size, depthTest, frames, false );
+}
+
+void DebugDraw::doubleArrow(
+  Vetor3D from, Vetor3D to, Color color, float size, bool depthTest, int frames ) {
+  if ( enabled )
+    seta( from, to, color, size, depthTest, frames, true );
+}
+
+void DebugDraw::box( Vetor3D min, Vetor3D max, Color color, bool depthTest, int frames ) {
+  if ( !enabled )
+    return;
+  Forma f( color, depthTest, frames, false );
+  for ( int k = 0; k < 4; k++ ) {
+    // arestas paralelas a cada eixo, uma por combinacao dos outros dois
+    float a = ( k & 1 ) ? max.y : min.y, b = ( k & 2 ) ? max.z : min.z;
+    f.segmento( Vetor3D( min.x, a, b ), Vetor3D( max.x, a, b ) );
+    a = ( k & 1 ) ? max.x : min.x;
+    f.segmento( Vetor3D( a, min.y, b ), Vetor3D( a, max.y, b ) );
+    b = ( k & 2 ) ? max.y : min.y;
+    f.segmento( Vetor3D( a, b, min.z ), Vetor3D( a, b, max.z ) );
+  }
+}
+
+void DebugDraw::axes( const Matriz4 &frame, float size, bool depthTest, int frames ) {
+  if ( !enabled )
+    return;
+  Vetor3D origem = frame.transformPoint( Vetor3D( 0, 0, 0 ) );
+  for ( int i = 0; i < 3; i++ ) {
+    Vetor3D eixo( i == 0 ? size : 0, i == 1 ? size : 0, i == 2 ? size : 0 );
+    seta( origem,
+          frame.transformPoint( eixo ),
+          Color( i == 0, i == 1, i == 2 ),
+          0.04f * size,
+          depthTest,
+          frames,
+          false );
+  }
+}
+
+void DebugDraw::sphere( Vetor3D center, float radius, Color color, bool depthTest, int frames ) {
+  if ( !enabled )
+    return;
+  const int nLados = 32;
+  Forma     f( color, depthTest, frames, false );
+  for ( int i = 0; i < nLados; i++ ) {
+    float t0 = 2 * M_PI * i / nLados, t1 = 2 * M_PI * ( i + 1 ) / nLados;
+    float c0 = radius * cos( t0 ), s0 = radius * sin( t0 );
+    float c1 = radius * cos( t1 ), s1 = radius * sin( t1 );
+    f.segmento( center + Vetor3D( c0, s0, 0 ), center + Vetor3D( c1, s1, 0 ) );
+    f.segmento( center + Vetor3D( c0, 0, s0 ), center + Vetor3D( c1, 0, s1 ) );
+    f.segmento( center + Vetor3D( 0, c0, s0 ), center + Vetor3D( 0, c1, s1 ) );
+  }
+}
+
+void DebugDraw::frustum( const Matriz4 &inverseViewProjection,
+                         Color          color,
+                         bool           depthTest,
+                         int            frames ) {
+  if ( !enabled )
+    return;
+  // cantos do cubo de coordenadas normalizadas (bits x = 1, y = 2, z = 4)
+  Vetor3D p[8];
+  for ( int i = 0; i < 8; i++ )
+    p[i] = inverseViewProjection.transformPoint(
+      Vetor3D( ( i & 1 ) ? 1 : -1, ( i & 2 ) ? 1 : -1, ( i & 4 ) ? 1 : -1 ) );
+  Forma f( color, depthTest, frames, false );
+  for ( int i = 0; i < 8; i++ ) {
+    for ( int bit = 1; bit < 8; bit <<= 1 ) {
+      if ( !( i & bit ) )
+        f.segmento( p[i], p[i | bit] );
+    }
+  }
+}
+
+void DebugDraw::flush() {
+  // coleta as filas de todas as threads
+  {
+    std::lock_guard<std::mutex> lock( mutexFilas );
+    for ( FilaThread *q : filas ) {
+      std::lock_guard<std::mutex> lockFila( q->mutex );
+      for ( int l = 0; l < NUM_LISTAS; l++ ) {
+        frame[l].insert( frame[l].end(), q->listas[l].begin(), q->listas[l].end() );
+        q->listas[l].clear();  // mantem a capacidade
+      }
+      for ( FormaPersistente &fp : q->persistentes )
+        persistentes.push_back( std::move( fp ) );
+      q->persistentes.clear();
+    }
+  }
+  for ( size_t i = 0; i < persistentes.size(); ) {
+    FormaPersistente &fp = persistentes[i];
+    frame[fp.lista].insert( frame[fp.lista].end(), fp.v.begin(), fp.v.end() );
+    if ( --fp.frames <= 0 ) {
+      persistentes[i] = std::move( persistentes.back() );
+      persistentes.pop_back();
+    } else
+      i++;
+  }
+
+  size_t total = 0;
+  for ( int l = 0; l < NUM_LISTAS; l++ )
+    total += frame[l].size();
+  if ( total == 0 || glutGUI::picking ) {
+    for ( int l = 0; l < NUM_LISTAS; l++ )
+      frame[l].clear();
+    return;
+  }
+  QXGL_TRACE_ZONE( "DebugDraw::flush" );
+
+  // todas as listas em sequencia no mesmo buffer (realocado a cada frame)
+  if ( vboDebug == 0 )
+    glGenBuffers( 1, &vboDebug );
+  glBindBuffer( GL_ARRAY_BUFFER, vboDebug );
+  glBufferData( GL_ARRAY_BUFFER, total * sizeof( VerticeDebug ), NULL, GL_STREAM_DRAW );
+  GLint  inicio[NUM_LISTAS];
+  size_t offset = 0;
+  for ( int l = 0; l < NUM_LISTAS; l++ ) {
+    inicio[l] = (GLint)offset;
+    glBufferSubData( GL_ARRAY_BUFFER,
+                     offset * sizeof( VerticeDebug ),
+                     frame[l].size() * sizeof( VerticeDebug ),
+                     frame[l].data() );
+    offset += frame[l].size();
+  }
+
+  glPushAttrib( GL_ENABLE_BIT | GL_CURRENT_BIT | GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT |
+                GL_VIEWPORT_BIT | GL_TRANSFORM_BIT );
+  glDisable( GL_LIGHTING );
+  glDisable( GL_TEXTURE_2D );
+  glDisable( GL_CULL_FACE );
+  glEnable( GL_BLEND );
+  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  glViewport( 0, 0, glutGUI::width, glutGUI::height );
+  glMatrixMode( GL_PROJECTION );
+  glPushMatrix();
+  glLoadMatrixf( glutGUI::cam->projection().m );
+  glMatrixMode( GL_MODELVIEW );
+  glPushMatrix();
+  glLoadMatrixf( glutGUI::cam->view().m );
+
+  glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+  glInterleavedArrays( GL_C4UB_V3F, 0, (const GLvoid *)0 );
+  for ( int l = 0; l < NUM_LISTAS; l++ ) {
+    if ( l == LINHAS_PROF )
+      glEnable( GL_DEPTH_TEST );
+    else if ( l == LINHAS_FRENTE )
+      glDisable( GL_DEPTH_TEST );
+    if ( !frame[l].empty() )
+      glDrawArrays( ( l & 1 ) ? GL_TRIANGLES : GL_LINES, inicio[l], (GLsizei)frame[l].size() );
+    frame[l].clear();
+  }
+  glPopClientAttrib();
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+  glMatrixMode( GL_PROJECTION );
+  glPopMatrix();
+  glMatrixMode( GL_MODELVIEW );
+  glPopMatrix();
+  glPopAttrib();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();
+#endif
+}
+
+void DebugDraw::clear() {
+  std::lock_guard<std::mutex> lock( mutexFilas );
+  for ( FilaThread *q : filas ) {
+    std::lock_guard<std::mutex> lockFila( q->mutex );
+    for ( int l = 0; l < NUM_LISTAS; l++ )
+      q->listas[l].clear();
+    q->persistentes.clear();
+  }
+  for ( int l = 0; l < NUM_LISTAS; l++ )
+    frame[l].clear();
+  persistentes.clear();
+}
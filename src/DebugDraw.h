@@ -0,0 +1,108 @@
+/**
+ * @file DebugDraw.h
+ * @brief Declaração da classe DebugDraw, uma fila de desenhos de depuração por frame.
+ *
+ * @details Linhas, setas, caixas, eixos, esferas e frustums podem ser pedidos de qualquer ponto do
+ * código, inclusive de outras threads (cada thread grava no seu próprio buffer, sem contexto
+ * OpenGL). As formas são expandidas em vértices no espaço do mundo, gravadas direto nos vetores
+ * da thread, reaproveitados de um frame para o outro (as que duram mais de um frame ganham um
+ * vetor próprio), e desenhadas todas juntas em GUI::displayEnd, com a câmera de glutGUI::cam e
+ * sem iluminação: um desenho de linhas e um de triângulos para as formas com teste de
+ * profundidade e outros dois para as que ficam sempre à frente.
+ */
+#ifndef DEBUGDRAW_H
+#define DEBUGDRAW_H
+
+#include "Matriz4.h"
+#include "Vetor3D.h"
+
+/**
+ * @class DebugDraw
+ * @brief Desenhos de depuração enfileirados e enviados em lote no fim do frame.
+ */
+class DebugDraw {
+public:
+  /**
+   * @struct Color
+   * @brief Cor RGBA de uma forma.
+   */
+  struct Color {
+    float r, g, b, a;
+    Color( float r = 1.0, float g = 1.0, float b = 1.0, float a = 1.0 )
+      : r( r ), g( g ), b( b ), a( a ) {}
+  };
+
+  static bool enabled; /**< @brief Se falso, os pedidos são ignorados (ligado por padrão). */
+
+  /**
+   * @brief Segmento de a até b.
+   * @param depthTest Se falso, a forma é desenhada por cima de toda a cena.
+   * @param frames Quantidade de frames em que a forma aparece (1 = só o frame atual).
+   */
+  static void
+    line( Vetor3D a, Vetor3D b, Color color = Color(), bool depthTest = true, int frames = 1 );
+
+  /**
+   * @brief Seta de from até to, com ponta cônica de raio `size` (0 usa 4% do comprimento).
+   */
+  static void arrow( Vetor3D from,
+                     Vetor3D to,
+                     Color   color     = Color(),
+                     float   size      = 0.0,
+                     bool    depthTest = true,
+                     int     frames    = 1 );
+
+  /**
+   * @brief Seta com pontas nas duas extremidades.
+   */
+  static void doubleArrow( Vetor3D from,
+                           Vetor3D to,
+                           Color   color     = Color(),
+                           float   size      = 0.0,
+                           bool    depthTest = true,
+                           int     frames    = 1 );
+
+  /**
+   * @brief Caixa alinhada aos eixos, em aramado.
+   */
+  static void
+    box( Vetor3D min, Vetor3D max, Color color = Color(), bool depthTest = true, int frames = 1 );
+
+  /**
+   * @brief Eixos X (vermelho), Y (verde) e Z (azul) de um referencial.
+   * @param frame Matriz do referencial (ex.: Matriz4::translation para só uma origem).
+   * @param size Comprimento de cada eixo.
+   */
+  static void axes( const Matriz4 &frame, float size = 1.0, bool depthTest = true, int frames = 1 );
+
+  /**
+   * @brief Esfera representada por três círculos (um em cada plano coordenado).
+   */
+  static void sphere( Vetor3D center,
+                      float   radius,
+                      Color   color     = Color(),
+                      bool    depthTest = true,
+                      int     frames    = 1 );
+
+  /**
+   * @brief Arestas de um frustum (ex.: de outra câmera).
+   * @param inverseViewProjection Inversa da view-projection (Camera::inverseViewProjection).
+   */
+  static void frustum( const Matriz4 &inverseViewProjection,
+                       Color          color     = Color(),
+                       bool           depthTest = true,
+                       int            frames    = 1 );
+
+  /**
+   * @brief Desenha as formas enfileiradas por todas as threads e esvazia a fila do frame.
+   * @details Chamada por GUI::displayEnd (thread principal).
+   */
+  static void flush();
+
+  /**
+   * @brief Descarta todas as formas, inclusive as que durariam mais frames.
+   */
+  static void clear();
+};
+
+#endif  // DEBUGDRAW_H
@@ -1,114 +1,53 @@
 #include "Desenha.h"
 
+#include "Batch.h"
+#include "GLState.h"
+#include "Primitives.h"
+#include "Shader.h"
+#include "Tessellation.h"
+#include "extra.h"
+
+#include <vector>
+
 //---------------------------------------------------------------------------
 // Draws a simple box using the given corners
 void Desenha::drawBox(
   GLfloat xmin, GLfloat ymin, GLfloat zmin, GLfloat xmax, GLfloat ymax, GLfloat zmax ) {
-  glBegin( GL_QUADS );
-  glNormal3f( 0., 0., -1. );
-  glTexCoord2f( 0.0f, 0.0f );
-  glVertex3f( xmin, ymin, zmin );
-  glTexCoord2f( 1.0f, 0.0f );
-  glVertex3f( xmin, ymax, zmin );
-  glTexCoord2f( 1.0f, 1.0f );
-  glVertex3f( xmax, ymax, zmin );
-  glTexCoord2f( 0.0f, 1.0f );
-  glVertex3f( xmax, ymin, zmin );
-  glEnd();
-
-  glBegin( GL_QUADS );
-  glNormal3f( 1., 0., 0. );
-  glTexCoord2f( 0.0f, 0.0f );
-  glVertex3f( xmax, ymin, zmin );
-  glTexCoord2f( 1.0f, 0.0f );
-  glVertex3f( xmax, ymax, zmin );
-  glTexCoord2f( 1.0f, 1.0f );
-  glVertex3f( xmax, ymax, zmax );
-  glTexCoord2f( 0.0f, 1.0f );
-  glVertex3f( xmax, ymin, zmax );
-  glEnd();
-
-  glBegin( GL_QUADS );
-  glNormal3f( 0., 0., 1. );
-  glTexCoord2f( 0.0f, 0.0f );
-  glVertex3f( xmax, ymin, zmax );
-  glTexCoord2f( 1.0f, 0.0f );
-  glVertex3f( xmax, ymax, zmax );
-  glTexCoord2f( 1.0f, 1.0f );
-  glVertex3f( xmin, ymax, zmax );
-  glTexCoord2f( 0.0f, 1.0f );
-  glVertex3f( xmin, ymin, zmax );
-  glEnd();
-
-  glBegin( GL_QUADS );
-  glNormal3f( -1., 0., 0. );
-  glTexCoord2f( 0.0f, 0.0f );
-  glVertex3f( xmin, ymin, zmax );
-  glTexCoord2f( 1.0f, 0.0f );
-  glVertex3f( xmin, ymax, zmax );
-  glTexCoord2f( 1.0f, 1.0f );
-  glVertex3f( xmin, ymax, zmin );
-  glTexCoord2f( 0.0f, 1.0f );
-  glVertex3f( xmin, ymin, zmin );
-  glEnd();
-
-  glBegin( GL_QUADS );
-  glNormal3f( 0., 1., 0. );
-  glTexCoord2f( 0.0f, 0.0f );
-  glVertex3f( xmin, ymax, zmin );
-  glTexCoord2f( 1.0f, 0.0f );
-  glVertex3f( xmin, ymax, zmax );
-  glTexCoord2f( 1.0f, 1.0f );
-  glVertex3f( xmax, ymax, zmax );
-  glTexCoord2f( 0.0f, 1.0f );
-  glVertex3f( xmax, ymax, zmin );
-  glEnd();
-
-  glBegin( GL_QUADS );
-  glNormal3f( 0., -1., 0. );
-  glTexCoord2f( 0.0f, 0.0f );
-  glVertex3f( xmax, ymin, zmin );
-  glTexCoord2f( 1.0f, 0.0f );
-  glVertex3f( xmax, ymin, zmax );
-  glTexCoord2f( 1.0f, 1.0f );
-  glVertex3f( xmin, ymin, zmax );
-  glTexCoord2f( 0.0f, 1.0f );
-  glVertex3f( xmin, ymin, zmin );
-  glEnd();
+  Primitives::box( xmin, ymin, zmin, xmax, ymax, zmax );
 }
 
 //---------------------------------------------------------------------------
 // Draws a simple box using the given corners
 void Desenha::drawWireBox(
   GLfloat xmin, GLfloat ymin, GLfloat zmin, GLfloat xmax, GLfloat ymax, GLfloat zmax ) {
-  glBegin( GL_LINES );
-  glVertex3f( xmin, ymin, zmin );
-  glVertex3f( xmax, ymin, zmin );
-  glVertex3f( xmax, ymin, zmin );
-  glVertex3f( xmax, ymax, zmin );
-  glVertex3f( xmax, ymax, zmin );
-  glVertex3f( xmin, ymax, zmin );
-  glVertex3f( xmin, ymax, zmin );
-  glVertex3f( xmin, ymin, zmin );
-
-  glVertex3f( xmin, ymin, zmax );
-  glVertex3f( xmax, ymin, zmax );
-  glVertex3f( xmax, ymin, zmax );
-  glVertex3f( xmax, ymax, zmax );
-  glVertex3f( xmax, ymax, zmax );
-  glVertex3f( xmin, ymax, zmax );
-  glVertex3f( xmin, ymax, zmax );
-  glVertex3f( xmin, ymin, zmax );
-
-  glVertex3f( xmin, ymin, zmin );
-  glVertex3f( xmin, ymin, zmax );
-  glVertex3f( xmax, ymin, zmin );
-  glVertex3f( xmax, ymin, zmax );
-  glVertex3f( xmax, ymax, zmin );
-  glVertex3f( xmax, ymax, zmax );
-  glVertex3f( xmin, ymax, zmin );
-  glVertex3f( xmin, ymax, zmax );
-  glEnd();
+  Batch::begin( GL_LINES );
+  Batch::vertex3f( xmin, ymin, zmin );
+  Batch::vertex3f( xmax, ymin, zmin );
+  Batch::vertex3f( xmax, ymin, zmin );
+  Batch::vertex3f( xmax, ymax, zmin );
+  Batch::vertex3f( xmax, ymax, zmin );
+  Batch::vertex3f( xmin, ymax, zmin );
+  Batch::vertex3f( xmin, ymax, zmin );
+  Batch::vertex3f( xmin, ymin, zmin );
+
+  Batch::vertex3f( xmin, ymin, zmax );
+  Batch::vertex3f( xmax, ymin, zmax );
+  Batch::vertex3f( xmax, ymin, zmax );
+  Batch::vertex3f( xmax, ymax, zmax );
+  Batch::vertex3f( xmax, ymax, zmax );
+  Batch::vertex3f( xmin, ymax, zmax );
+  Batch::vertex3f( xmin, ymax, zmax );
+  Batch::vertex3f( xmin, ymin, zmax );
+
+  Batch::vertex3f( xmin, ymin, zmin );
+  Batch::vertex3f( xmin, ymin, zmax );
+  Batch::vertex3f( xmax, ymin, zmin );
+  Batch::vertex3f( xmax, ymin, zmax );
+  Batch::vertex3f( xmax, ymax, zmin );
+  Batch::vertex3f( xmax, ymax, zmax );
+  Batch::vertex3f( xmin, ymax, zmin );
+  Batch::vertex3f( xmin, ymax, zmax );
+  Batch::end();
 }
 
 //---------------------------------------------------------------------------
@@ -121,89 +60,233 @@ void Desenha::drawSelectedBox(
   float dy = ( ymax - ymin ) / 8.0;
   float dz = ( zmax - zmin ) / 8.0;
 
-  glBegin( GL_LINES );
-  glVertex3f( xmin, ymin, zmin );
-  glVertex3f( xmin + dx, ymin, zmin );
-  glVertex3f( xmax - dx, ymin, zmin );
-  glVertex3f( xmax, ymin, zmin );
-  glVertex3f( xmax, ymin, zmin );
-  glVertex3f( xmax, ymin + dy, zmin );
-  glVertex3f( xmax, ymax - dy, zmin );
-  glVertex3f( xmax, ymax, zmin );
-  glVertex3f( xmax, ymax, zmin );
-  glVertex3f( xmax - dx, ymax, zmin );
-  glVertex3f( xmin + dx, ymax, zmin );
-  glVertex3f( xmin, ymax, zmin );
-  glVertex3f( xmin, ymax, zmin );
-  glVertex3f( xmin, ymax - dy, zmin );
-  glVertex3f( xmin, ymin + dy, zmin );
-  glVertex3f( xmin, ymin, zmin );
-
-  glVertex3f( xmin, ymin, zmax );
-  glVertex3f( xmin + dx, ymin, zmax );
-  glVertex3f( xmax - dx, ymin, zmax );
-  glVertex3f( xmax, ymin, zmax );
-  glVertex3f( xmax, ymin, zmax );
-  glVertex3f( xmax, ymin + dy, zmax );
-  glVertex3f( xmax, ymax - dy, zmax );
-  glVertex3f( xmax, ymax, zmax );
-  glVertex3f( xmax, ymax, zmax );
-  glVertex3f( xmax - dx, ymax, zmax );
-  glVertex3f( xmin + dx, ymax, zmax );
-  glVertex3f( xmin, ymax, zmax );
-  glVertex3f( xmin, ymax, zmax );
-  glVertex3f( xmin, ymax - dy, zmax );
-  glVertex3f( xmin, ymin + dy, zmax );
-  glVertex3f( xmin, ymin, zmax );
-
-  glVertex3f( xmin, ymin, zmin );
-  glVertex3f( xmin, ymin, zmin + dz );
-  glVertex3f( xmin, ymin, zmax - dz );
-  glVertex3f( xmin, ymin, zmax );
-  glVertex3f( xmax, ymin, zmin );
-  glVertex3f( xmax, ymin, zmin + dz );
-  glVertex3f( xmax, ymin, zmax - dz );
-  glVertex3f( xmax, ymin, zmax );
-  glVertex3f( xmax, ymax, zmin );
-  glVertex3f( xmax, ymax, zmin + dz );
-  glVertex3f( xmax, ymax, zmax - dz );
-  glVertex3f( xmax, ymax, zmax );
-  glVertex3f( xmin, ymax, zmin );
-  glVertex3f( xmin, ymax, zmin + dz );
-  glVertex3f( xmin, ymax, zmax - dz );
-  glVertex3f( xmin, ymax, zmax );
-  glEnd();
+  Batch::begin( GL_LINES );
+  Batch::vertex3f( xmin, ymin, zmin );
+  Batch::vertex3f( xmin + dx, ymin, zmin );
+  Batch::vertex3f( xmax - dx, ymin, zmin );
+  Batch::vertex3f( xmax, ymin, zmin );
+  Batch::vertex3f( xmax, ymin, zmin );
+  Batch::vertex3f( xmax, ymin + dy, zmin );
+  Batch::vertex3f( xmax, ymax - dy, zmin );
+  Batch::vertex3f( xmax, ymax, zmin );
+  Batch::vertex3f( xmax, ymax, zmin );
+  Batch::vertex3f( xmax - dx, ymax, zmin );
+  Batch::vertex3f( xmin + dx, ymax, zmin );
+  Batch::vertex3f( xmin, ymax, zmin );
+  Batch::vertex3f( xmin, ymax, zmin );
+  Batch::vertex3f( xmin, ymax - dy, zmin );
+  Batch::vertex3f( xmin, ymin + dy, zmin );
+  Batch::vertex3f( xmin, ymin, zmin );
+
+  Batch::vertex3f( xmin, ymin, zmax );
+  Batch::vertex3f( xmin + dx, ymin, zmax );
+  Batch::vertex3f( xmax - dx, ymin, zmax );
+  Batch::vertex3f( xmax, ymin, zmax );
+  Batch::vertex3f( xmax, ymin, zmax );
+  Batch::vertex3f( xmax, ymin + dy, zmax );
+  Batch::vertex3f( xmax, ymax - dy, zmax );
+  Batch::vertex3f( xmax, ymax, zmax );
+  Batch::vertex3f( xmax, ymax, zmax );
+  Batch::vertex3f( xmax - dx, ymax, zmax );
+  Batch::vertex3f( xmin + dx, ymax, zmax );
+  Batch::vertex3f( xmin, ymax, zmax );
+  Batch::vertex3f( xmin, ymax, zmax );
+  Batch::vertex3f( xmin, ymax - dy, zmax );
+  Batch::vertex3f( xmin, ymin + dy, zmax );
+  Batch::vertex3f( xmin, ymin, zmax );
+
+  Batch::vertex3f( xmin, ymin, zmin );
+  Batch::vertex3f( xmin, ymin, zmin + dz );
+  Batch::vertex3f( xmin, ymin, zmax - dz );
+  Batch::vertex3f( xmin, ymin, zmax );
+  Batch::vertex3f( xmax, ymin, zmin );
+  Batch::vertex3f( xmax, ymin, zmin + dz );
+  Batch::vertex3f( xmax, ymin, zmax - dz );
+  Batch::vertex3f( xmax, ymin, zmax );
+  Batch::vertex3f( xmax, ymax, zmin );
+  Batch::vertex3f( xmax, ymax, zmin + dz );
+  Batch::vertex3f( xmax, ymax, zmax - dz );
+  Batch::vertex3f( xmax, ymax, zmax );
+  Batch::vertex3f( xmin, ymax, zmin );
+  Batch::vertex3f( xmin, ymax, zmin + dz );
+  Batch::vertex3f( xmin, ymax, zmax - dz );
+  Batch::vertex3f( xmin, ymax, zmax );
+  Batch::end();
 }
 
 //---------------------------------------------------------------------------
-// desenha um quadrado da grade
-void Desenha::drawQuad( GLfloat xmin, GLfloat y, GLfloat zmin, GLfloat lado ) {
-  glBegin( GL_LINES );
-  glVertex3f( xmin, y, zmin );
-  glVertex3f( xmin, y, zmin + lado );
+// arestas de um quadrado da grade (dentro de um Batch::begin(GL_LINES))
+static void arestasQuad( GLfloat xmin, GLfloat y, GLfloat zmin, GLfloat lado ) {
+  Batch::vertex3f( xmin, y, zmin );
+  Batch::vertex3f( xmin, y, zmin + lado );
 
-  glVertex3f( xmin, y, zmin + lado );
-  glVertex3f( xmin + lado, y, zmin + lado );
+  Batch::vertex3f( xmin, y, zmin + lado );
+  Batch::vertex3f( xmin + lado, y, zmin + lado );
 
-  glVertex3f( xmin + lado, y, zmin + lado );
-  glVertex3f( xmin + lado, y, zmin );
+  Batch::vertex3f( xmin + lado, y, zmin + lado );
+  Batch::vertex3f( xmin + lado, y, zmin );
 
-  glVertex3f( xmin + lado, y, zmin );
-  glVertex3f( xmin, y, zmin );
-  glEnd();
+  Batch::vertex3f( xmin + lado, y, zmin );
+  Batch::vertex3f( xmin, y, zmin );
+}
+
+//---------------------------------------------------------------------------
+// desenha um quadrado da grade
+void Desenha::drawQuad( GLfloat xmin, GLfloat y, GLfloat zmin, GLfloat lado ) {
+  Batch::begin( GL_LINES );
+  arestasQuad( xmin, y, zmin, lado );
+  Batch::end();
 }
 
 //---------------------------------------------------------------------------
-// desenha a grade
+// desenha a grade: uma linha inteira por divisao (arestas compartilhadas entre os quadrados),
+// guardada em um vertex buffer que so e refeito quando os parametros mudam
+static GLuint grade = 0;
+static int    gradeVertices = 0, gradeParams[3] = { 0, 0, 0 };
+
 void Desenha::drawGrid( int meionx, GLfloat y, int meionz, int dimensao ) {
-  glPushMatrix();
-  int i, k;
-  for ( i = -meionx * dimensao; i <= ( meionx - 1 ) * dimensao; i += dimensao ) {
-    for ( k = -meionz * dimensao; k <= ( meionz - 1 ) * dimensao; k += dimensao ) {
-      drawQuad( i, y, k, dimensao );
+  if ( meionx <= 0 || meionz <= 0 )
+    return;
+  Batch::flush();  // a grade vai direto para o OpenGL: o que foi agrupado antes vem antes
+  if ( grade == 0 || gradeParams[0] != meionx || gradeParams[1] != meionz ||
+       gradeParams[2] != dimensao ) {
+    GLfloat              xmax = meionx * dimensao, zmax = meionz * dimensao;
+    std::vector<GLfloat> v;
+    for ( int i = -meionx; i <= meionx; i++ ) {  // paralelas ao eixo Z
+      GLfloat x = i * dimensao;
+      v.insert( v.end(), { x, 0, -zmax, x, 0, zmax } );
     }
-  }
+    for ( int k = -meionz; k <= meionz; k++ ) {  // paralelas ao eixo X
+      GLfloat z = k * dimensao;
+      v.insert( v.end(), { -xmax, 0, z, xmax, 0, z } );
+    }
+    if ( grade == 0 )
+      glGenBuffers( 1, &grade );
+    glBindBuffer( GL_ARRAY_BUFFER, grade );
+    glBufferData( GL_ARRAY_BUFFER, v.size() * sizeof( GLfloat ), v.data(), GL_STATIC_DRAW );
+    gradeVertices  = (int)v.size() / 3;
+    gradeParams[0] = meionx;
+    gradeParams[1] = meionz;
+    gradeParams[2] = dimensao;
+  } else
+    glBindBuffer( GL_ARRAY_BUFFER, grade );
+
+  glPushMatrix();
+  glTranslatef( 0, y, 0 );
+  glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+  glInterleavedArrays( GL_V3F, 0, (const GLvoid *)0 );
+  glDrawArrays( GL_LINES, 0, gradeVertices );
+  glPopClientAttrib();
   glPopMatrix();
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+//---------------------------------------------------------------------------
+// grade infinita: um retangulo que cobre a tela e, para cada pixel, o ponto do plano y = altura
+// visto por ele (entre os pontos do pixel nos planos near e far, pela inversa da MVP)
+static GLuint gradeInfinita = 0;
+static GLint  gradeAltura = -1, gradeCelula = -1, gradeFade = -1, gradePixels = -1;
+static bool   gradeFalhou = false;
+
+static bool criaProgramaGradeInfinita() {
+  const char *vs =
+    "#version 120\n"
+    "varying vec3 pNear;\n"
+    "varying vec3 pFar;\n"
+    "varying vec4 cor;\n"
+    "vec3 desprojeta( float z ) {\n"
+    "  vec4 p = gl_ModelViewProjectionMatrixInverse * vec4( gl_Vertex.xy, z, 1.0 );\n"
+    "  return p.xyz / p.w;\n"
+    "}\n"
+    "void main() {\n"
+    "  pNear       = desprojeta( -1.0 );\n"
+    "  pFar        = desprojeta( 1.0 );\n"
+    "  cor         = gl_Color;\n"
+    "  gl_Position = vec4( gl_Vertex.xy, 0.0, 1.0 );\n"
+    "}\n";
+  const char *fs =
+    "#version 120\n"
+    "uniform float altura;\n"
+    "uniform float celula;\n"
+    "uniform float fade;\n"
+    "uniform float pixels;\n"
+    "varying vec3  pNear;\n"
+    "varying vec3  pFar;\n"
+    "varying vec4  cor;\n"
+    // intensidade das linhas de uma grade com celulas de lado c (antialiasing pela derivada)
+    "float linhas( vec2 p, float c ) {\n"
+    "  vec2 q = p / c;\n"
+    "  vec2 d = abs( fract( q - 0.5 ) - 0.5 ) / fwidth( q );\n"
+    "  return 1.0 - min( min( d.x, d.y ), 1.0 );\n"
+    "}\n"
+    "void main() {\n"
+    "  float t = ( altura - pNear.y ) / ( pFar.y - pNear.y );\n"
+    "  if ( t < 0.0 || t > 1.0 ) discard;\n"
+    "  vec3 p = pNear + t * ( pFar - pNear );\n"
+    // subdivisao adaptativa: potencias de 10 da celula, a menor com pelo menos `pixels` pixels,
+    // que some aos poucos ate a seguinte assumir
+    "  float tam = length( fwidth( p.xz ) ) * pixels / celula;\n"
+    "  float lod = max( 0.0, log( tam ) / log( 10.0 ) );\n"
+    "  float c0  = celula * pow( 10.0, floor( lod ) );\n"
+    "  float a   = max( linhas( p.xz, c0 ) * ( 1.0 - fract( lod ) ), linhas( p.xz, c0 * 10.0 ) );\n"
+    // desvanece com a distancia ao olho
+    "  vec3 olho = ( gl_ModelViewMatrixInverse * vec4( 0.0, 0.0, 0.0, 1.0 ) ).xyz;\n"
+    "  a *= 1.0 - smoothstep( 0.0, fade, distance( p, olho ) );\n"
+    "  if ( a <= 0.0 ) discard;\n"
+    "  vec4 clip    = gl_ModelViewProjectionMatrix * vec4( p, 1.0 );\n"
+    "  gl_FragDepth = 0.5 * ( gl_DepthRange.diff * clip.z / clip.w + gl_DepthRange.near +\n"
+    "                         gl_DepthRange.far );\n"
+    "  gl_FragColor = vec4( cor.rgb, cor.a * a );\n"
+    "}\n";
+  gradeInfinita = Shader::program( vs, fs, "Desenha::drawInfiniteGrid" );
+  if ( gradeInfinita == 0 )
+    return false;
+  gradeAltura = glGetUniformLocation( gradeInfinita, "altura" );
+  gradeCelula = glGetUniformLocation( gradeInfinita, "celula" );
+  gradeFade   = glGetUniformLocation( gradeInfinita, "fade" );
+  gradePixels = glGetUniformLocation( gradeInfinita, "pixels" );
+  return true;
+}
+
+void Desenha::drawInfiniteGrid( GLfloat y,
+                                 GLfloat cell,
+                                 GLfloat fadeDistance,
+                                 GLfloat minPixels ) {
+  // no picking a grade cobriria a tela inteira
+  if ( glutGUI::picking || gradeFalhou )
+    return;
+  if ( gradeInfinita == 0 && !criaProgramaGradeInfinita() ) {
+    gradeFalhou = true;
+    return;
+  }
+  Batch::flush();  // a grade e transparente: o que ja foi desenhado precisa estar no depth buffer
+
+  glPushAttrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+  glDisable( GL_LIGHTING );
+  glDisable( GL_TEXTURE_2D );
+  glDisable( GL_CULL_FACE );
+  glEnable( GL_DEPTH_TEST );
+  glEnable( GL_BLEND );
+  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  glDepthMask( GL_FALSE );
+
+  GLState::useProgram( gradeInfinita );
+  glUniform1f( gradeAltura, y );
+  glUniform1f( gradeCelula, cell );
+  glUniform1f( gradeFade, fadeDistance );
+  glUniform1f( gradePixels, minPixels );
+  glBegin( GL_QUADS );
+  glVertex2f( -1, -1 );
+  glVertex2f( 1, -1 );
+  glVertex2f( 1, 1 );
+  glVertex2f( -1, 1 );
+  glEnd();
+  GLState::useProgram( 0 );
+
+  glPopAttrib();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();
+#endif
 }
 
 //---------------------------------------------------------------------------
@@ -212,14 +295,8 @@ void Desenha::gluClosedCylinder(
   GLUquadric *quad, GLdouble base, GLdouble top, GLdouble height, GLint slices, GLint stacks ) {
   gluQuadricNormals( quad, GLU_SMOOTH );  // Create Smooth Normals
   gluQuadricTexture( quad, GL_TRUE );     // Create Texture Coords
-  glPushMatrix();
-  gluCylinder( quad, base, top, height, slices, stacks );
-  glTranslated( 0, 0, height );
-  gluDisk( quad, 0, top, slices, stacks );
-  glRotated( 180, 0, 1, 0 );
-  glTranslated( 0, 0, height );
-  gluDisk( quad, 0, base, slices, stacks );
-  glPopMatrix();
+  Tessellation::adjust( fmax( fmax( base, top ), height / 2 ), slices, stacks, 0, 0, height / 2 );
+  Primitives::cylinder( base, top, height, slices, true, quad, stacks );
 }
 
 //---------------------------------------------------------------------------
@@ -228,12 +305,84 @@ void Desenha::gluCapsule(
   GLUquadric *quad, GLdouble base, GLdouble top, GLdouble height, GLint slices, GLint stacks ) {
   gluQuadricNormals( quad, GLU_SMOOTH );  // Create Smooth Normals
   gluQuadricTexture( quad, GL_TRUE );     // Create Texture Coords
-  glPushMatrix();
-  gluCylinder( quad, base, top, height, slices, stacks );
-  gluSphere( quad, base, slices, stacks );
-  glTranslated( 0, 0, height );
-  gluSphere( quad, top, slices, stacks );
-  glPopMatrix();
+  Tessellation::adjust( height / 2 + fmax( base, top ), slices, stacks, 0, 0, height / 2 );
+  Primitives::capsule( base, top, height, slices, quad, stacks );
+}
+
+//---------------------------------------------------------------------------
+// ponta de seta (cone com base) em "ponta", apontando na direcao unitaria d
+static void pontaSeta( Vetor3D ponta, Vetor3D d, GLfloat raio, GLfloat comp ) {
+  const int nLados = 12;
+  // base ortonormal (u, v) perpendicular a d
+  Vetor3D   a      = fabs( d.x ) < 0.9 ? Vetor3D( 1, 0, 0 ) : Vetor3D( 0, 1, 0 );
+  Vetor3D   u      = ( a ^ d ).getUnit();
+  Vetor3D   v      = d ^ u;
+  Vetor3D   base   = ponta - d * comp;
+  // normal da lateral do cone: inclinada para a ponta
+  float     k      = raio / comp;
+
+  Batch::begin( GL_TRIANGLES );
+  for ( int i = 0; i < nLados; i++ ) {
+    float   t0 = 2 * PI * i / nLados, t1 = 2 * PI * ( i + 1 ) / nLados;
+    Vetor3D r0 = u * cos( t0 ) + v * sin( t0 );
+    Vetor3D r1 = u * cos( t1 ) + v * sin( t1 );
+    Vetor3D n0 = ( r0 + d * k ).getUnit();
+    Vetor3D n1 = ( r1 + d * k ).getUnit();
+    Vetor3D p0 = base + r0 * raio, p1 = base + r1 * raio;
+    Vetor3D nm = ( n0 + n1 ).getUnit();
+    // lateral
+    Batch::normal3f( n0.x, n0.y, n0.z );
+    Batch::vertex3f( p0.x, p0.y, p0.z );
+    Batch::normal3f( n1.x, n1.y, n1.z );
+    Batch::vertex3f( p1.x, p1.y, p1.z );
+    Batch::normal3f( nm.x, nm.y, nm.z );
+    Batch::vertex3f( ponta.x, ponta.y, ponta.z );
+    // base
+    Batch::normal3f( -d.x, -d.y, -d.z );
+    Batch::vertex3f( base.x, base.y, base.z );
+    Batch::vertex3f( p1.x, p1.y, p1.z );
+    Batch::vertex3f( p0.x, p0.y, p0.z );
+  }
+  Batch::end();
+}
+
+//---------------------------------------------------------------------------
+// desenha uma seta (linha com ponta conica) de from ate to
+void Desenha::drawArrow( Vetor3D from, Vetor3D to, GLfloat larg ) {
+  Vetor3D d   = to - from;
+  float   len = d.modulo();
+  if ( len <= 0.0 )
+    return;
+  d.normaliza();
+  float raio = larg > 0.0 ? larg : 0.04 * len;
+  float comp = fmin( 3.0 * raio, 0.5 * len );
+
+  Vetor3D fim = to - d * comp;
+  Batch::begin( GL_LINES );
+  Batch::vertex3f( from.x, from.y, from.z );
+  Batch::vertex3f( fim.x, fim.y, fim.z );
+  Batch::end();
+  pontaSeta( to, d, raio, comp );
+}
+
+//---------------------------------------------------------------------------
+// desenha uma seta com pontas nas duas extremidades
+void Desenha::drawDoubleArrow( Vetor3D from, Vetor3D to, GLfloat larg ) {
+  Vetor3D d   = to - from;
+  float   len = d.modulo();
+  if ( len <= 0.0 )
+    return;
+  d.normaliza();
+  float raio = larg > 0.0 ? larg : 0.04 * len;
+  float comp = fmin( 3.0 * raio, 0.5 * len );
+
+  Vetor3D ini = from + d * comp, fim = to - d * comp;
+  Batch::begin( GL_LINES );
+  Batch::vertex3f( ini.x, ini.y, ini.z );
+  Batch::vertex3f( fim.x, fim.y, fim.z );
+  Batch::end();
+  pontaSeta( to, d, raio, comp );
+  pontaSeta( from, d * -1.0, raio, comp );
 }
 
 //---------------------------------------------------------------------------
@@ -267,61 +416,21 @@ void Desenha::drawEixos(GLfloat tam) {
 // desenha os tres eixos x, y e z
 //*
 void Desenha::drawEixos( GLfloat tam ) {
-  const GLfloat redMaterial[]   = { 0.3, 0., 0., 1. };
-  const GLfloat greenMaterial[] = { 0., 0.3, 0., 1. };
-  const GLfloat blueMaterial[]  = { 0., 0., 0.3, 1. };
-
-  GLUquadricObj *quad = gluNewQuadric();
-
-  glLineWidth( 2 );
-
-  // x
-  glMaterialfv( GL_FRONT, GL_AMBIENT, redMaterial );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, redMaterial );
-  glColor3d( 0.3, 0.0, 0.0 );
-
-  glBegin( GL_LINES );
-  glVertex3f( 0, 0, 0 );
-  glVertex3f( tam, 0, 0 );
-  glEnd();
-  glPushMatrix();
-  glRotated( 90, 0, 1, 0 );
-  glTranslated( 0, 0, tam );
-  Desenha::gluClosedCylinder( quad, 0.1 * tam, 0, 0.2 * tam, 10, 10 );
-  glPopMatrix();
-
-  // y
-  glMaterialfv( GL_FRONT, GL_AMBIENT, greenMaterial );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, greenMaterial );
-  glColor3d( 0.0, 0.3, 0.0 );
+  const GLfloat materiais[3][4] = { { 0.3, 0., 0., 1. }, { 0., 0.3, 0., 1. }, { 0., 0., 0.3, 1. } };
 
-  glBegin( GL_LINES );
-  glVertex3f( 0, 0, 0 );
-  glVertex3f( 0, tam, 0 );
-  glEnd();
+  // linhas e cones vem da malha AXES (cones com 10 fatias no desenho original)
+  int lod = Primitives::lodFor( 10 );
+  GLState::lineWidth( 2 );
   glPushMatrix();
-  glRotated( 90, -1, 0, 0 );
-  glTranslated( 0, 0, tam );
-  Desenha::gluClosedCylinder( quad, 0.1 * tam, 0, 0.2 * tam, 10, 10 );
-  glPopMatrix();
-
-  // z
-  glMaterialfv( GL_FRONT, GL_AMBIENT, blueMaterial );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, blueMaterial );
-  glColor3d( 0.0, 0.0, 0.3 );
-
-  glBegin( GL_LINES );
-  glVertex3f( 0, 0, 0 );
-  glVertex3f( 0, 0, tam );
-  glEnd();
-  glPushMatrix();
-  glTranslated( 0, 0, tam );
-  Desenha::gluClosedCylinder( quad, 0.1 * tam, 0, 0.2 * tam, 10, 10 );
+  glScalef( tam, tam, tam );
+  for ( int k = 0; k < 3; k++ ) {
+    GLState::material( GL_FRONT, GL_AMBIENT, materiais[k] );
+    GLState::material( GL_FRONT, GL_DIFFUSE, materiais[k] );
+    glColor3d( materiais[k][0], materiais[k][1], materiais[k][2] );
+    Primitives::axis( k, lod );
+  }
   glPopMatrix();
-
-  glLineWidth( 1 );
-
-  gluDeleteQuadric( quad );
+  GLState::lineWidth( 1 );
 }
 
 //*/
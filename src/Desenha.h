@@ -3,6 +3,7 @@
  * @brief Declaração da classe Desenha, uma biblioteca de utilitários para renderização com OpenGL.
  *
  * @details Esta classe estática fornece um conjunto de funções para desenhar primitivas geométrica.
+ * As caixas em aramado, a grade e as setas são gravadas pelo Batch e enviadas em lote.
  */
 #ifndef DESENHA_H
 #define DESENHA_H
@@ -13,6 +14,8 @@
 #include <GL/glu.h>
 #include <cmath>
 
+#include "GLInstrument.h"
+
 class Desenha {
 public:
   /**
@@ -78,7 +81,9 @@ public:
 
   /**
    * @brief Desenha uma grade 2D no plano XZ.
-   * @details A grade é centrada na origem.
+   * @details A grade é centrada na origem. Cada divisão é uma única linha (as arestas são
+   * compartilhadas entre os quadrados), e as linhas ficam em um vertex buffer refeito só quando
+   * meionx, meionz ou dimensao mudam: cada frame custa um glDrawArrays.
    * @param meionx Número de quadrados na metade do eixo X.
    * @param y A altura (coordenada Y) onde a grade será desenhada.
    * @param meionz Número de quadrados na metade do eixo Z.
@@ -86,6 +91,24 @@ public:
    */
   static void drawGrid( int meionx, GLfloat y, int meionz, int dimensao );
 
+  /**
+   * @brief Desenha uma grade infinita no plano y, gerada por pixel em um shader.
+   * @details Um retângulo que cobre a tela é intersectado, por pixel, com o plano y (usa as
+   * matrizes correntes, com a modelview da câmera). O custo não depende da extensão da grade: as
+   * linhas são calculadas com antialiasing, as células crescem em potências de 10 quando ficam
+   * menores que minPixels na tela e a grade desaparece com a distância ao olho. A cor é a cor
+   * corrente (glColor), misturada com blend; desenhe-a depois dos objetos opacos. Não desenha
+   * nada durante o picking.
+   * @param y Altura do plano.
+   * @param cell Lado da menor célula.
+   * @param fadeDistance Distância ao olho em que a grade some.
+   * @param minPixels Tamanho mínimo, em pixels, de uma célula antes de passar à seguinte.
+   */
+  static void drawInfiniteGrid( GLfloat y,
+                                GLfloat cell         = 1.0,
+                                GLfloat fadeDistance = 50.0,
+                                GLfloat minPixels    = 8.0 );
+
   /**
    * @brief Desenha um cilindro com as duas extremidades fechadas por discos.
    * @details Utiliza um objeto GLUquadric para renderizar o cilindro e os discos.
@@ -93,8 +116,11 @@ public:
    * @param base Raio da base do cilindro.
    * @param top Raio do topo do cilindro.
    * @param height Altura do cilindro.
-   * @param slices Número de subdivisões ao redor do eixo Z (afeta a suavidade).
-   * @param stacks Número de subdivisões ao longo do eixo Z (afeta a suavidade).
+   * @param slices Número de subdivisões ao redor do eixo Z (afeta a suavidade). Com
+   * Tessellation::autoLOD é o máximo, reduzido pelo tamanho na tela.
+   * @param stacks Número de subdivisões ao longo do eixo Z. Só é usado em troncos de cone (base e
+   * topo diferentes e não nulos); cilindros e cones vêm das malhas de Primitives, em que o raio
+   * varia linearmente em Z e as pilhas são as do nível de detalhe.
    */
   static void gluClosedCylinder(
     GLUquadric *quad, GLdouble base, GLdouble top, GLdouble height, GLint slices, GLint stacks );
@@ -106,27 +132,29 @@ public:
    * @param base Raio da base da cápsula.
    * @param top Raio do topo da cápsula.
    * @param height Altura da seção cilíndrica.
-   * @param slices Número de subdivisões (afeta a suavidade).
-   * @param stacks Número de subdivisões (afeta a suavidade).
+   * @param slices Número de subdivisões (afeta a suavidade). Com Tessellation::autoLOD é o
+   * máximo, reduzido pelo tamanho na tela.
+   * @param stacks Número de subdivisões do cilindro, como em gluClosedCylinder; as esferas usam as
+   * pilhas do nível de detalhe de Primitives (metade das fatias).
    */
   static void gluCapsule(
     GLUquadric *quad, GLdouble base, GLdouble top, GLdouble height, GLint slices, GLint stacks );
 
   /**
    * @brief Desenha uma seta indicando uma direção de um ponto a outro.
-   * @note A implementação desta função não foi fornecida no arquivo .cpp.
+   * @details A haste é uma linha e a ponta, um cone com base, gravados pelo Batch.
    * @param from Ponto de origem da seta.
    * @param to Ponto de destino da seta.
-   * @param larg Largura da seta (parâmetro opcional).
+   * @param larg Raio da ponta (0 usa 4% do comprimento da seta).
    */
   static void drawArrow( Vetor3D from, Vetor3D to, GLfloat larg = 0.0 );
 
   /**
    * @brief Desenha uma seta com duas pontas.
-   * @note A implementação desta função não foi fornecida no arquivo .cpp.
+   * @details Como drawArrow, com um cone em cada extremidade.
    * @param from Ponto de uma extremidade.
    * @param to Ponto da outra extremidade.
-   * @param larg Largura da seta (parâmetro opcional).
+   * @param larg Raio das pontas (0 usa 4% do comprimento da seta).
    */
   static void drawDoubleArrow( Vetor3D from, Vetor3D to, GLfloat larg = 0.0 );
 
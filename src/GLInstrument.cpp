@@ -0,0 +1,525 @@
+// as macros nao sao definidas aqui: os wrappers chamam as funcoes reais
+#define QXGL_GL_INSTRUMENT_IMPL
+#include "GLInstrument.h"
+
+#ifdef QXGL_GL_INSTRUMENT
+
+  #include <algorithm>
+  #include <array>
+  #include <cstdio>
+  #include <cstring>
+  #include <map>
+  #include <utility>
+  #include <vector>
+
+// um local de chamada (arquivo:linha) e seus contadores no frame
+struct LocalChamada {
+  const char        *file;
+  int                line;
+  GLInstrument::Call call;
+  long               calls;
+  long               redundant;
+};
+
+using ChaveLocal = std::pair<const char *, int>;
+using Valor4     = std::array<GLfloat, 4>;
+
+// contadores do frame atual e do ultimo frame fechado
+static long contagem[GLInstrument::NUM_CALLS];
+static long redundantes[GLInstrument::NUM_CALLS];
+static long verticesFrame = 0;
+static long lotesFrame    = 0;
+
+static long ultContagem[GLInstrument::NUM_CALLS];
+static long ultRedundantes[GLInstrument::NUM_CALLS];
+static long ultVertices = 0;
+static long ultLotes    = 0;
+
+static std::map<ChaveLocal, LocalChamada> locais;
+static std::vector<LocalChamada>          ultLocais;
+
+// estado conhecido (o que ja foi enviado ao driver pelos wrappers)
+static bool                                        dentroBeginEnd = false;
+static std::map<GLenum, bool>                      caps;
+static std::map<std::pair<GLenum, GLenum>, Valor4> luzes;
+static std::map<std::pair<GLenum, GLenum>, Valor4> materiais;
+static std::map<GLenum, GLuint>                    texturas;
+static Valor4                                      corAtual;
+static bool                                        corConhecida = false;
+static std::pair<GLenum, GLenum>                   blendAtual;
+static bool                                        blendConhecido = false;
+static GLfloat                                     larguraLinha   = -1.0f;
+static GLenum                                      modoMatriz     = 0;
+
+static const char *nomes[GLInstrument::NUM_CALLS] = {
+  "glBegin",       "glEnd",        "glVertex",      "glNormal",       "glTexCoord",
+  "glColor",       "glDraw*",      "glu/glut shape", "glEnable",      "glDisable",
+  "glLight",       "glMaterial",   "glBindTexture", "glBlendFunc",    "glLineWidth",
+  "glPushMatrix",  "glPopMatrix",  "glMatrixMode",  "glLoad*Matrix",  "glMult/Transf",
+  "glClear",       "glViewport"
+};
+
+static void conta( GLInstrument::Call c, const char *file, int line, bool redundante = false ) {
+  contagem[c]++;
+  LocalChamada &l = locais[ChaveLocal( file, line )];
+  if ( l.calls == 0 ) {
+    l.file = file;
+    l.line = line;
+    l.call = c;
+  }
+  l.calls++;
+  if ( redundante ) {
+    redundantes[c]++;
+    l.redundant++;
+  }
+}
+
+// compara e atualiza um valor conhecido; retorna true se o novo valor e igual ao atual
+static bool
+  atualiza( std::map<std::pair<GLenum, GLenum>, Valor4> &m, GLenum a, GLenum b, const Valor4 &v ) {
+  auto chave = std::make_pair( a, b );
+  auto it    = m.find( chave );
+  if ( it != m.end() && it->second == v )
+    return true;
+  m[chave] = v;
+  return false;
+}
+
+static int componentesLuz( GLenum pname ) {
+  switch ( pname ) {
+    case GL_AMBIENT:
+    case GL_DIFFUSE:
+    case GL_SPECULAR:
+    case GL_POSITION: return 4;
+    case GL_SPOT_DIRECTION: return 3;
+    default: return 1;
+  }
+}
+
+static int componentesMaterial( GLenum pname ) {
+  switch ( pname ) {
+    case GL_SHININESS: return 1;
+    case GL_COLOR_INDEXES: return 3;
+    default: return 4;
+  }
+}
+
+static Valor4 valor4( const GLfloat *v, int n ) {
+  Valor4 r = { 0.0f, 0.0f, 0.0f, 0.0f };
+  for ( int i = 0; i < n; i++ )
+    r[i] = v[i];
+  return r;
+}
+
+static bool materialRedundante( GLenum face, GLenum pname, const Valor4 &v ) {
+  // GL_FRONT_AND_BACK e GL_AMBIENT_AND_DIFFUSE alteram mais de um valor: so e redundante se
+  // todos ja forem iguais
+  GLenum faces[2]  = { face, face };
+  GLenum params[2] = { pname, pname };
+  int    nf = 1, np = 1;
+  if ( face == GL_FRONT_AND_BACK ) {
+    faces[0] = GL_FRONT;
+    faces[1] = GL_BACK;
+    nf       = 2;
+  }
+  if ( pname == GL_AMBIENT_AND_DIFFUSE ) {
+    params[0] = GL_AMBIENT;
+    params[1] = GL_DIFFUSE;
+    np        = 2;
+  }
+  bool redundante = true;
+  for ( int i = 0; i < nf; i++ )
+    for ( int j = 0; j < np; j++ )
+      redundante = atualiza( materiais, faces[i], params[j], v ) && redundante;
+  return redundante;
+}
+
+static bool corRedundante( GLfloat r, GLfloat g, GLfloat b, GLfloat a ) {
+  Valor4 c          = { r, g, b, a };
+  bool   redundante = corConhecida && c == corAtual;
+  corAtual          = c;
+  corConhecida      = true;
+  return redundante;
+}
+
+static bool capRedundante( GLenum cap, bool valor ) {
+  auto it         = caps.find( cap );
+  bool redundante = it != caps.end() && it->second == valor;
+  caps[cap]       = valor;
+  return redundante;
+}
+
+void GLInstrument::endFrame() {
+  memcpy( ultContagem, contagem, sizeof( contagem ) );
+  memcpy( ultRedundantes, redundantes, sizeof( redundantes ) );
+  memset( contagem, 0, sizeof( contagem ) );
+  memset( redundantes, 0, sizeof( redundantes ) );
+  ultVertices   = verticesFrame;
+  ultLotes      = lotesFrame;
+  verticesFrame = 0;
+  lotesFrame    = 0;
+
+  ultLocais.clear();
+  ultLocais.reserve( locais.size() );
+  for ( const auto &[chave, l] : locais )
+    ultLocais.push_back( l );
+  locais.clear();
+}
+
+long GLInstrument::calls( Call c ) {
+  return ultContagem[c];
+}
+
+long GLInstrument::redundant( Call c ) {
+  return ultRedundantes[c];
+}
+
+long GLInstrument::vertices() {
+  return ultVertices;
+}
+
+long GLInstrument::drawCalls() {
+  return ultLotes;
+}
+
+const char *GLInstrument::callName( Call c ) {
+  return nomes[c];
+}
+
+void GLInstrument::print( int topSites ) {
+  long total = 0, totalRedundantes = 0;
+  for ( int c = 0; c < NUM_CALLS; c++ ) {
+    total += ultContagem[c];
+    totalRedundantes += ultRedundantes[c];
+  }
+  printf( "GL: %ld chamadas (%ld redundantes), %ld lotes, %ld vertices\n",
+          total,
+          totalRedundantes,
+          ultLotes,
+          ultVertices );
+  for ( int c = 0; c < NUM_CALLS; c++ ) {
+    if ( ultContagem[c] == 0 )
+      continue;
+    printf( "  %-16s %8ld", nomes[c], ultContagem[c] );
+    if ( ultRedundantes[c] > 0 )
+      printf( "  (%ld redundantes)", ultRedundantes[c] );
+    printf( "\n" );
+  }
+
+  std::vector<LocalChamada> ordenados = ultLocais;
+  int n = std::min( topSites, (int)ordenados.size() );
+  std::partial_sort( ordenados.begin(),
+                     ordenados.begin() + n,
+                     ordenados.end(),
+                     []( const LocalChamada &a, const LocalChamada &b ) {
+                       return a.calls > b.calls;
+                     } );
+  printf( "  locais com mais chamadas:\n" );
+  for ( int i = 0; i < n; i++ )
+    printf( "    %8ld %-14s %s:%d\n",
+            ordenados[i].calls,
+            nomes[ordenados[i].call],
+            ordenados[i].file,
+            ordenados[i].line );
+
+  std::partial_sort( ordenados.begin(),
+                     ordenados.begin() + n,
+                     ordenados.end(),
+                     []( const LocalChamada &a, const LocalChamada &b ) {
+                       return a.redundant > b.redundant;
+                     } );
+  printf( "  locais com mais chamadas redundantes:\n" );
+  for ( int i = 0; i < n && ordenados[i].redundant > 0; i++ )
+    printf( "    %8ld %-14s %s:%d\n",
+            ordenados[i].redundant,
+            nomes[ordenados[i].call],
+            ordenados[i].file,
+            ordenados[i].line );
+}
+
+void GLInstrument::invalidateState() {
+  caps.clear();
+  luzes.clear();
+  materiais.clear();
+  texturas.clear();
+  corConhecida   = false;
+  blendConhecido = false;
+  larguraLinha   = -1.0f;
+  modoMatriz     = 0;
+}
+
+//-------------------desenho-------------------
+void GLInstrument::begin( GLenum mode, const char *file, int line ) {
+  conta( CALL_BEGIN, file, line );
+  lotesFrame++;
+  dentroBeginEnd = true;
+  glBegin( mode );
+}
+
+void GLInstrument::end( const char *file, int line ) {
+  conta( CALL_END, file, line );
+  dentroBeginEnd = false;
+  glEnd();
+}
+
+void GLInstrument::vertex2f( GLfloat x, GLfloat y, const char *file, int line ) {
+  conta( CALL_VERTEX, file, line );
+  verticesFrame += dentroBeginEnd;
+  glVertex2f( x, y );
+}
+
+void GLInstrument::vertex3f( GLfloat x, GLfloat y, GLfloat z, const char *file, int line ) {
+  conta( CALL_VERTEX, file, line );
+  verticesFrame += dentroBeginEnd;
+  glVertex3f( x, y, z );
+}
+
+void GLInstrument::vertex3d( GLdouble x, GLdouble y, GLdouble z, const char *file, int line ) {
+  conta( CALL_VERTEX, file, line );
+  verticesFrame += dentroBeginEnd;
+  glVertex3d( x, y, z );
+}
+
+void GLInstrument::vertex3fv( const GLfloat *v, const char *file, int line ) {
+  conta( CALL_VERTEX, file, line );
+  verticesFrame += dentroBeginEnd;
+  glVertex3fv( v );
+}
+
+void GLInstrument::vertex4fv( const GLfloat *v, const char *file, int line ) {
+  conta( CALL_VERTEX, file, line );
+  verticesFrame += dentroBeginEnd;
+  glVertex4fv( v );
+}
+
+void GLInstrument::normal3f( GLfloat x, GLfloat y, GLfloat z, const char *file, int line ) {
+  conta( CALL_NORMAL, file, line );
+  glNormal3f( x, y, z );
+}
+
+void GLInstrument::normal3fv( const GLfloat *v, const char *file, int line ) {
+  conta( CALL_NORMAL, file, line );
+  glNormal3fv( v );
+}
+
+void GLInstrument::texCoord2f( GLfloat s, GLfloat t, const char *file, int line ) {
+  conta( CALL_TEXCOORD, file, line );
+  glTexCoord2f( s, t );
+}
+
+void GLInstrument::color3f( GLfloat r, GLfloat g, GLfloat b, const char *file, int line ) {
+  conta( CALL_COLOR, file, line, corRedundante( r, g, b, 1.0f ) );
+  glColor3f( r, g, b );
+}
+
+void GLInstrument::color3d( GLdouble r, GLdouble g, GLdouble b, const char *file, int line ) {
+  conta( CALL_COLOR, file, line, corRedundante( r, g, b, 1.0f ) );
+  glColor3d( r, g, b );
+}
+
+void GLInstrument::color4f(
+  GLfloat r, GLfloat g, GLfloat b, GLfloat a, const char *file, int line ) {
+  conta( CALL_COLOR, file, line, corRedundante( r, g, b, a ) );
+  glColor4f( r, g, b, a );
+}
+
+void GLInstrument::color4fv( const GLfloat *v, const char *file, int line ) {
+  conta( CALL_COLOR, file, line, corRedundante( v[0], v[1], v[2], v[3] ) );
+  glColor4fv( v );
+}
+
+void GLInstrument::drawArrays(
+  GLenum mode, GLint first, GLsizei count, const char *file, int line ) {
+  conta( CALL_DRAW_ARRAYS, file, line );
+  lotesFrame++;
+  verticesFrame += count;
+  glDrawArrays( mode, first, count );
+}
+
+void GLInstrument::drawElements(
+  GLenum mode, GLsizei count, GLenum type, const void *indices, const char *file, int line ) {
+  conta( CALL_DRAW_ARRAYS, file, line );
+  lotesFrame++;
+  verticesFrame += count;
+  glDrawElements( mode, count, type, indices );
+}
+
+void GLInstrument::sphere(
+  GLUquadric *q, GLdouble r, GLint sl, GLint st, const char *file, int line ) {
+  conta( CALL_GLU_GLUT_SHAPE, file, line );
+  lotesFrame++;
+  verticesFrame += 2L * sl * st;
+  gluSphere( q, r, sl, st );
+}
+
+void GLInstrument::cylinder( GLUquadric *q,
+                             GLdouble    base,
+                             GLdouble    top,
+                             GLdouble    h,
+                             GLint       sl,
+                             GLint       st,
+                             const char *file,
+                             int         line ) {
+  conta( CALL_GLU_GLUT_SHAPE, file, line );
+  lotesFrame++;
+  verticesFrame += 2L * ( sl + 1 ) * st;
+  gluCylinder( q, base, top, h, sl, st );
+}
+
+void GLInstrument::disk(
+  GLUquadric *q, GLdouble in, GLdouble out, GLint sl, GLint lo, const char *file, int line ) {
+  conta( CALL_GLU_GLUT_SHAPE, file, line );
+  lotesFrame++;
+  verticesFrame += 2L * ( sl + 1 ) * lo;
+  gluDisk( q, in, out, sl, lo );
+}
+
+void GLInstrument::solidSphere( GLdouble r, GLint sl, GLint st, const char *file, int line ) {
+  conta( CALL_GLU_GLUT_SHAPE, file, line );
+  lotesFrame++;
+  verticesFrame += 2L * sl * st;
+  glutSolidSphere( r, sl, st );
+}
+
+//-------------------estado-------------------
+void GLInstrument::enable( GLenum cap, const char *file, int line ) {
+  conta( CALL_ENABLE, file, line, capRedundante( cap, true ) );
+  glEnable( cap );
+}
+
+void GLInstrument::disable( GLenum cap, const char *file, int line ) {
+  conta( CALL_DISABLE, file, line, capRedundante( cap, false ) );
+  glDisable( cap );
+}
+
+void GLInstrument::lightfv(
+  GLenum light, GLenum pname, const GLfloat *v, const char *file, int line ) {
+  // posicao e direcao sao transformadas pela modelview corrente: nunca sao redundantes
+  bool redundante = pname != GL_POSITION && pname != GL_SPOT_DIRECTION &&
+                    atualiza( luzes, light, pname, valor4( v, componentesLuz( pname ) ) );
+  conta( CALL_LIGHT, file, line, redundante );
+  glLightfv( light, pname, v );
+}
+
+void GLInstrument::lightf( GLenum light, GLenum pname, GLfloat v, const char *file, int line ) {
+  conta( CALL_LIGHT, file, line, atualiza( luzes, light, pname, valor4( &v, 1 ) ) );
+  glLightf( light, pname, v );
+}
+
+void GLInstrument::materialfv(
+  GLenum face, GLenum pname, const GLfloat *v, const char *file, int line ) {
+  conta( CALL_MATERIAL,
+         file,
+         line,
+         materialRedundante( face, pname, valor4( v, componentesMaterial( pname ) ) ) );
+  glMaterialfv( face, pname, v );
+}
+
+void GLInstrument::materialf( GLenum face, GLenum pname, GLfloat v, const char *file, int line ) {
+  conta( CALL_MATERIAL, file, line, materialRedundante( face, pname, valor4( &v, 1 ) ) );
+  glMaterialf( face, pname, v );
+}
+
+void GLInstrument::bindTexture( GLenum target, GLuint tex, const char *file, int line ) {
+  auto it         = texturas.find( target );
+  bool redundante = it != texturas.end() && it->second == tex;
+  texturas[target] = tex;
+  conta( CALL_BIND_TEXTURE, file, line, redundante );
+  glBindTexture( target, tex );
+}
+
+void GLInstrument::blendFunc( GLenum src, GLenum dst, const char *file, int line ) {
+  bool redundante = blendConhecido && blendAtual == std::make_pair( src, dst );
+  blendAtual      = std::make_pair( src, dst );
+  blendConhecido  = true;
+  conta( CALL_BLEND_FUNC, file, line, redundante );
+  glBlendFunc( src, dst );
+}
+
+void GLInstrument::lineWidth( GLfloat w, const char *file, int line ) {
+  conta( CALL_LINE_WIDTH, file, line, larguraLinha == w );
+  larguraLinha = w;
+  glLineWidth( w );
+}
+
+//-------------------matrizes-------------------
+void GLInstrument::pushMatrix( const char *file, int line ) {
+  conta( CALL_PUSH_MATRIX, file, line );
+  glPushMatrix();
+}
+
+void GLInstrument::popMatrix( const char *file, int line ) {
+  conta( CALL_POP_MATRIX, file, line );
+  glPopMatrix();
+}
+
+void GLInstrument::matrixMode( GLenum mode, const char *file, int line ) {
+  conta( CALL_MATRIX_MODE, file, line, modoMatriz == mode );
+  modoMatriz = mode;
+  glMatrixMode( mode );
+}
+
+void GLInstrument::loadIdentity( const char *file, int line ) {
+  conta( CALL_LOAD_MATRIX, file, line );
+  glLoadIdentity();
+}
+
+void GLInstrument::loadMatrixf( const GLfloat *m, const char *file, int line ) {
+  conta( CALL_LOAD_MATRIX, file, line );
+  glLoadMatrixf( m );
+}
+
+void GLInstrument::multMatrixf( const GLfloat *m, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glMultMatrixf( m );
+}
+
+void GLInstrument::multMatrixd( const GLdouble *m, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glMultMatrixd( m );
+}
+
+void GLInstrument::translatef( GLfloat x, GLfloat y, GLfloat z, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glTranslatef( x, y, z );
+}
+
+void GLInstrument::translated( GLdouble x, GLdouble y, GLdouble z, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glTranslated( x, y, z );
+}
+
+void GLInstrument::rotatef(
+  GLfloat a, GLfloat x, GLfloat y, GLfloat z, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glRotatef( a, x, y, z );
+}
+
+void GLInstrument::rotated(
+  GLdouble a, GLdouble x, GLdouble y, GLdouble z, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glRotated( a, x, y, z );
+}
+
+void GLInstrument::scalef( GLfloat x, GLfloat y, GLfloat z, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glScalef( x, y, z );
+}
+
+void GLInstrument::scaled( GLdouble x, GLdouble y, GLdouble z, const char *file, int line ) {
+  conta( CALL_MULT_MATRIX, file, line );
+  glScaled( x, y, z );
+}
+
+//-------------------framebuffer-------------------
+void GLInstrument::clear( GLbitfield mask, const char *file, int line ) {
+  conta( CALL_CLEAR, file, line );
+  glClear( mask );
+}
+
+void GLInstrument::viewport( GLint x, GLint y, GLsizei w, GLsizei h, const char *file, int line ) {
+  conta( CALL_VIEWPORT, file, line );
+  glViewport( x, y, w, h );
+}
+
+#endif  // QXGL_GL_INSTRUMENT
@@ -0,0 +1,227 @@
+/**
+ * @file GLInstrument.h
+ * @brief Camada opcional de instrumentação das chamadas OpenGL usadas pela QxGL.
+ *
+ * @details Quando a biblioteca é compilada com `QXGL_GL_INSTRUMENT` (opção do CMake de mesmo
+ * nome), este cabeçalho redefine, por macros, os pontos de entrada OpenGL/GLU/GLUT usados pela
+ * QxGL para wrappers que contam as chamadas por tipo, os vértices emitidos entre
+ * `glBegin`/`glEnd` e as mudanças de estado redundantes (valor idêntico ao atual, como o
+ * `glLightfv` que o GUI::setLight reenvia a cada frame). Os contadores são fechados a cada frame
+ * em GUI::displayEnd e podem ser consultados por tipo e por local de chamada (arquivo:linha).
+ *
+ * Sem `QXGL_GL_INSTRUMENT` nenhuma macro nem classe é definida e as chamadas vão direto ao driver.
+ */
+#ifndef GLINSTRUMENT_H
+#define GLINSTRUMENT_H
+
+#ifdef __APPLE__
+  #include <GLUT/glut.h>
+#else
+  #include <GL/glut.h>
+#endif
+
+#ifdef QXGL_GL_INSTRUMENT
+
+/**
+ * @class GLInstrument
+ * @brief Contadores de chamadas OpenGL por frame e por local de chamada.
+ */
+class GLInstrument {
+public:
+  /**
+   * @enum Call
+   * @brief Tipos de chamada interceptados.
+   */
+  enum Call {
+    CALL_BEGIN,
+    CALL_END,
+    CALL_VERTEX,
+    CALL_NORMAL,
+    CALL_TEXCOORD,
+    CALL_COLOR,
+    CALL_DRAW_ARRAYS,
+    CALL_GLU_GLUT_SHAPE,
+    CALL_ENABLE,
+    CALL_DISABLE,
+    CALL_LIGHT,
+    CALL_MATERIAL,
+    CALL_BIND_TEXTURE,
+    CALL_BLEND_FUNC,
+    CALL_LINE_WIDTH,
+    CALL_PUSH_MATRIX,
+    CALL_POP_MATRIX,
+    CALL_MATRIX_MODE,
+    CALL_LOAD_MATRIX,
+    CALL_MULT_MATRIX,
+    CALL_CLEAR,
+    CALL_VIEWPORT,
+    NUM_CALLS
+  };
+
+  /**
+   * @brief Fecha os contadores do frame atual (chamada por GUI::displayEnd).
+   */
+  static void endFrame();
+
+  /**
+   * @brief Quantidade de chamadas de um tipo no último frame fechado.
+   */
+  static long calls( Call c );
+
+  /**
+   * @brief Quantidade de chamadas redundantes de um tipo no último frame fechado.
+   */
+  static long redundant( Call c );
+
+  /**
+   * @brief Vértices emitidos no último frame fechado (imediato e glDrawArrays).
+   */
+  static long vertices();
+
+  /**
+   * @brief Lotes de desenho no último frame fechado (pares glBegin/glEnd, glDrawArrays, GLU e
+   * GLUT).
+   */
+  static long drawCalls();
+
+  /**
+   * @brief Nome legível de um tipo de chamada.
+   */
+  static const char *callName( Call c );
+
+  /**
+   * @brief Imprime o resumo do último frame e os locais com mais chamadas e redundâncias.
+   * @param topSites Quantidade de locais de chamada listados.
+   */
+  static void print( int topSites = 10 );
+
+  /**
+   * @brief Esquece o estado conhecido (usar após alterar estado OpenGL fora da QxGL sem passar
+   * pelos wrappers, ex.: glPushAttrib/glPopAttrib).
+   */
+  static void invalidateState();
+
+  // wrappers (usados pelas macros abaixo)
+  static void begin( GLenum mode, const char *file, int line );
+  static void end( const char *file, int line );
+  static void vertex2f( GLfloat x, GLfloat y, const char *file, int line );
+  static void vertex3f( GLfloat x, GLfloat y, GLfloat z, const char *file, int line );
+  static void vertex3d( GLdouble x, GLdouble y, GLdouble z, const char *file, int line );
+  static void vertex3fv( const GLfloat *v, const char *file, int line );
+  static void vertex4fv( const GLfloat *v, const char *file, int line );
+  static void normal3f( GLfloat x, GLfloat y, GLfloat z, const char *file, int line );
+  static void normal3fv( const GLfloat *v, const char *file, int line );
+  static void texCoord2f( GLfloat s, GLfloat t, const char *file, int line );
+  static void color3f( GLfloat r, GLfloat g, GLfloat b, const char *file, int line );
+  static void color3d( GLdouble r, GLdouble g, GLdouble b, const char *file, int line );
+  static void color4f( GLfloat r, GLfloat g, GLfloat b, GLfloat a, const char *file, int line );
+  static void color4fv( const GLfloat *v, const char *file, int line );
+  static void
+    drawArrays( GLenum mode, GLint first, GLsizei count, const char *file, int line );
+  static void drawElements( GLenum       mode,
+                            GLsizei      count,
+                            GLenum       type,
+                            const void  *indices,
+                            const char  *file,
+                            int          line );
+  static void
+    sphere( GLUquadric *q, GLdouble r, GLint sl, GLint st, const char *file, int line );
+  static void cylinder( GLUquadric *q,
+                        GLdouble    base,
+                        GLdouble    top,
+                        GLdouble    h,
+                        GLint       sl,
+                        GLint       st,
+                        const char *file,
+                        int         line );
+  static void disk( GLUquadric *q,
+                    GLdouble    in,
+                    GLdouble    out,
+                    GLint       sl,
+                    GLint       lo,
+                    const char *file,
+                    int         line );
+  static void solidSphere( GLdouble r, GLint sl, GLint st, const char *file, int line );
+  static void enable( GLenum cap, const char *file, int line );
+  static void disable( GLenum cap, const char *file, int line );
+  static void
+    lightfv( GLenum light, GLenum pname, const GLfloat *v, const char *file, int line );
+  static void lightf( GLenum light, GLenum pname, GLfloat v, const char *file, int line );
+  static void
+    materialfv( GLenum face, GLenum pname, const GLfloat *v, const char *file, int line );
+  static void materialf( GLenum face, GLenum pname, GLfloat v, const char *file, int line );
+  static void bindTexture( GLenum target, GLuint tex, const char *file, int line );
+  static void blendFunc( GLenum src, GLenum dst, const char *file, int line );
+  static void lineWidth( GLfloat w, const char *file, int line );
+  static void pushMatrix( const char *file, int line );
+  static void popMatrix( const char *file, int line );
+  static void matrixMode( GLenum mode, const char *file, int line );
+  static void loadIdentity( const char *file, int line );
+  static void loadMatrixf( const GLfloat *m, const char *file, int line );
+  static void multMatrixf( const GLfloat *m, const char *file, int line );
+  static void multMatrixd( const GLdouble *m, const char *file, int line );
+  static void translatef( GLfloat x, GLfloat y, GLfloat z, const char *file, int line );
+  static void translated( GLdouble x, GLdouble y, GLdouble z, const char *file, int line );
+  static void
+    rotatef( GLfloat a, GLfloat x, GLfloat y, GLfloat z, const char *file, int line );
+  static void
+    rotated( GLdouble a, GLdouble x, GLdouble y, GLdouble z, const char *file, int line );
+  static void scalef( GLfloat x, GLfloat y, GLfloat z, const char *file, int line );
+  static void scaled( GLdouble x, GLdouble y, GLdouble z, const char *file, int line );
+  static void clear( GLbitfield mask, const char *file, int line );
+  static void viewport( GLint x, GLint y, GLsizei w, GLsizei h, const char *file, int line );
+};
+
+  #ifndef QXGL_GL_INSTRUMENT_IMPL
+    #define QXGL_AT __FILE__, __LINE__
+
+    #define glBegin( m )                   GLInstrument::begin( m, QXGL_AT )
+    #define glEnd()                        GLInstrument::end( QXGL_AT )
+    #define glVertex2f( x, y )             GLInstrument::vertex2f( x, y, QXGL_AT )
+    #define glVertex3f( x, y, z )          GLInstrument::vertex3f( x, y, z, QXGL_AT )
+    #define glVertex3d( x, y, z )          GLInstrument::vertex3d( x, y, z, QXGL_AT )
+    #define glVertex3fv( v )               GLInstrument::vertex3fv( v, QXGL_AT )
+    #define glVertex4fv( v )               GLInstrument::vertex4fv( v, QXGL_AT )
+    #define glNormal3f( x, y, z )          GLInstrument::normal3f( x, y, z, QXGL_AT )
+    #define glNormal3fv( v )               GLInstrument::normal3fv( v, QXGL_AT )
+    #define glTexCoord2f( s, t )           GLInstrument::texCoord2f( s, t, QXGL_AT )
+    #define glColor3f( r, g, b )           GLInstrument::color3f( r, g, b, QXGL_AT )
+    #define glColor3d( r, g, b )           GLInstrument::color3d( r, g, b, QXGL_AT )
+    #define glColor4f( r, g, b, a )        GLInstrument::color4f( r, g, b, a, QXGL_AT )
+    #define glColor4fv( v )                GLInstrument::color4fv( v, QXGL_AT )
+    #define glDrawArrays( m, f, c )        GLInstrument::drawArrays( m, f, c, QXGL_AT )
+    #define glDrawElements( m, c, t, i )   GLInstrument::drawElements( m, c, t, i, QXGL_AT )
+    #define gluSphere( q, r, sl, st )      GLInstrument::sphere( q, r, sl, st, QXGL_AT )
+    #define gluCylinder( q, b, t, h, sl, st ) \
+      GLInstrument::cylinder( q, b, t, h, sl, st, QXGL_AT )
+    #define gluDisk( q, i, o, sl, lo )     GLInstrument::disk( q, i, o, sl, lo, QXGL_AT )
+    #define glutSolidSphere( r, sl, st )   GLInstrument::solidSphere( r, sl, st, QXGL_AT )
+    #define glEnable( c )                  GLInstrument::enable( c, QXGL_AT )
+    #define glDisable( c )                 GLInstrument::disable( c, QXGL_AT )
+    #define glLightfv( l, p, v )           GLInstrument::lightfv( l, p, v, QXGL_AT )
+    #define glLightf( l, p, v )            GLInstrument::lightf( l, p, v, QXGL_AT )
+    #define glMaterialfv( f, p, v )        GLInstrument::materialfv( f, p, v, QXGL_AT )
+    #define glMaterialf( f, p, v )         GLInstrument::materialf( f, p, v, QXGL_AT )
+    #define glBindTexture( t, id )         GLInstrument::bindTexture( t, id, QXGL_AT )
+    #define glBlendFunc( s, d )            GLInstrument::blendFunc( s, d, QXGL_AT )
+    #define glLineWidth( w )               GLInstrument::lineWidth( w, QXGL_AT )
+    #define glPushMatrix()                 GLInstrument::pushMatrix( QXGL_AT )
+    #define glPopMatrix()                  GLInstrument::popMatrix( QXGL_AT )
+    #define glMatrixMode( m )              GLInstrument::matrixMode( m, QXGL_AT )
+    #define glLoadIdentity()               GLInstrument::loadIdentity( QXGL_AT )
+    #define glLoadMatrixf( m )             GLInstrument::loadMatrixf( m, QXGL_AT )
+    #define glMultMatrixf( m )             GLInstrument::multMatrixf( m, QXGL_AT )
+    #define glMultMatrixd( m )             GLInstrument::multMatrixd( m, QXGL_AT )
+    #define glTranslatef( x, y, z )        GLInstrument::translatef( x, y, z, QXGL_AT )
+    #define glTranslated( x, y, z )        GLInstrument::translated( x, y, z, QXGL_AT )
+    #define glRotatef( a, x, y, z )        GLInstrument::rotatef( a, x, y, z, QXGL_AT )
+    #define glRotated( a, x, y, z )        GLInstrument::rotated( a, x, y, z, QXGL_AT )
+    #define glScalef( x, y, z )            GLInstrument::scalef( x, y, z, QXGL_AT )
+    #define glScaled( x, y, z )            GLInstrument::scaled( x, y, z, QXGL_AT )
+    #define glClear( m )                   GLInstrument::clear( m, QXGL_AT )
+    #define glViewport( x, y, w, h )       GLInstrument::viewport( x, y, w, h, QXGL_AT )
+  #endif
+
+#endif  // QXGL_GL_INSTRUMENT
+
+#endif  // GLINSTRUMENT_H
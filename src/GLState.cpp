@@ -0,0 +1,359 @@
+#include "GLState.h"
+
+#include "GLInstrument.h"
+
+#include <cstring>
+#include <unordered_map>
+
+bool GLState::enabled = true;
+
+static const int NUM_LUZES = 8, NUM_UNIDADES = 8;
+
+// parametros das luzes guardados (GL_POSITION e GL_SPOT_DIRECTION ficam de fora)
+static const GLenum PARAMS_LUZ[] = { GL_AMBIENT,
+                                     GL_DIFFUSE,
+                                     GL_SPECULAR,
+                                     GL_SPOT_EXPONENT,
+                                     GL_SPOT_CUTOFF,
+                                     GL_CONSTANT_ATTENUATION,
+                                     GL_LINEAR_ATTENUATION,
+                                     GL_QUADRATIC_ATTENUATION };
+static const int    NUM_PARAMS_LUZ = sizeof( PARAMS_LUZ ) / sizeof( PARAMS_LUZ[0] );
+
+static const GLenum PARAMS_MATERIAL[] = { GL_AMBIENT, GL_DIFFUSE, GL_SPECULAR, GL_EMISSION,
+                                          GL_SHININESS };
+static const int    NUM_PARAMS_MATERIAL =
+  sizeof( PARAMS_MATERIAL ) / sizeof( PARAMS_MATERIAL[0] );
+
+// valor guardado: ate 4 floats e se e conhecido
+struct ValorEstado {
+  GLfloat v[4];
+  bool    conhecido;
+};
+
+static std::unordered_map<GLenum, bool>   caps;
+static ValorEstado                        luzes[NUM_LUZES][NUM_PARAMS_LUZ];
+static ValorEstado                        materiais[2][NUM_PARAMS_MATERIAL];  // frente e verso
+static GLenum                             blend[2];
+static bool                               blendConhecido   = false;
+static GLenum                             unidadeAtiva     = GL_TEXTURE0;
+static bool                               unidadeConhecida = false;
+static std::unordered_map<GLenum, GLuint> texturas[NUM_UNIDADES];  // por unidade: alvo -> textura
+static ValorEstado                        programa;         // v[0]: nome do programa
+static ValorEstado                        mascaraProf;      // v[0]: GL_TRUE ou GL_FALSE
+static ValorEstado                        modoPoligono;     // v[0], v[1]: frente e verso
+static ValorEstado                        colorMaterialFP;  // v[0], v[1]: face e parametro
+static ValorEstado                        larguraLinha;
+static ValorEstado                        tamanhoPonto;
+
+static int indiceParam( const GLenum *lista, int n, GLenum pname ) {
+  for ( int i = 0; i < n; i++ ) {
+    if ( lista[i] == pname )
+      return i;
+  }
+  return -1;
+}
+
+// atualiza o valor guardado e diz se ele mudou
+static bool muda( ValorEstado &e, const GLfloat *v, int n ) {
+  if ( e.conhecido && memcmp( e.v, v, n * sizeof( GLfloat ) ) == 0 )
+    return false;
+  memcpy( e.v, v, n * sizeof( GLfloat ) );
+  e.conhecido = true;
+  return true;
+}
+
+// valor de um estado escalar: a copia, ou o OpenGL na primeira consulta
+static GLfloat consultaFloat( ValorEstado &e, GLenum pname ) {
+  if ( !GLState::enabled || !e.conhecido ) {
+    glGetFloatv( pname, e.v );
+    e.conhecido = GLState::enabled;
+  }
+  return e.v[0];
+}
+
+// estados inteiros guardados como float (nomes e enums cabem exatamente ate 2^24)
+static void consultaInt( ValorEstado &e, GLenum pname ) {
+  if ( GLState::enabled && e.conhecido )
+    return;
+  GLint v[2] = { 0, 0 };
+  glGetIntegerv( pname, v );
+  e.v[0]      = (GLfloat)v[0];
+  e.v[1]      = (GLfloat)v[1];
+  e.conhecido = GLState::enabled;
+}
+
+static int componentes( GLenum pname ) {
+  switch ( pname ) {
+  case GL_AMBIENT:
+  case GL_DIFFUSE:
+  case GL_SPECULAR:
+  case GL_EMISSION:
+    return 4;
+  default:
+    return 1;
+  }
+}
+
+void GLState::enable( GLenum cap ) {
+  set( cap, true );
+}
+
+void GLState::disable( GLenum cap ) {
+  set( cap, false );
+}
+
+void GLState::set( GLenum cap, bool on ) {
+  if ( enabled ) {
+    auto it = caps.find( cap );
+    if ( it != caps.end() && it->second == on )
+      return;
+    caps[cap] = on;
+  }
+  if ( on )
+    glEnable( cap );
+  else
+    glDisable( cap );
+}
+
+bool GLState::isEnabled( GLenum cap ) {
+  if ( !enabled )
+    return glIsEnabled( cap );
+  auto it = caps.find( cap );
+  if ( it == caps.end() )
+    it = caps.emplace( cap, glIsEnabled( cap ) == GL_TRUE ).first;
+  return it->second;
+}
+
+void GLState::light( GLenum light, GLenum pname, const GLfloat *params ) {
+  int l = (int)light - GL_LIGHT0;
+  int p = indiceParam( PARAMS_LUZ, NUM_PARAMS_LUZ, pname );
+  if ( !enabled || l < 0 || l >= NUM_LUZES || p < 0 ||
+       muda( luzes[l][p], params, componentes( pname ) ) )
+    glLightfv( light, pname, params );
+}
+
+void GLState::light( GLenum light, GLenum pname, GLfloat param ) {
+  GLState::light( light, pname, &param );
+}
+
+void GLState::material( GLenum face, GLenum pname, const GLfloat *params ) {
+  // com o material seguindo o glColor a copia nao pode ser mantida
+  if ( !enabled || isEnabled( GL_COLOR_MATERIAL ) ) {
+    for ( int f = 0; f < 2; f++ ) {
+      for ( int p = 0; p < NUM_PARAMS_MATERIAL; p++ )
+        materiais[f][p].conhecido = false;
+    }
+    glMaterialfv( face, pname, params );
+    return;
+  }
+
+  bool mudou = false;
+  for ( int f = 0; f < 2; f++ ) {
+    if ( ( f == 0 && face == GL_BACK ) || ( f == 1 && face == GL_FRONT ) )
+      continue;
+    if ( pname == GL_AMBIENT_AND_DIFFUSE ) {
+      mudou |= muda( materiais[f][0], params, 4 );
+      mudou |= muda( materiais[f][1], params, 4 );
+    } else {
+      int p = indiceParam( PARAMS_MATERIAL, NUM_PARAMS_MATERIAL, pname );
+      mudou |= p < 0 || muda( materiais[f][p], params, componentes( pname ) );
+    }
+  }
+  if ( mudou )
+    glMaterialfv( face, pname, params );
+}
+
+void GLState::material( GLenum face, GLenum pname, GLfloat param ) {
+  GLState::material( face, pname, &param );
+}
+
+void GLState::getMaterial( GLenum face, GLenum pname, GLfloat *params ) {
+  int f = face == GL_BACK ? 1 : 0;
+  int p = indiceParam( PARAMS_MATERIAL, NUM_PARAMS_MATERIAL, pname );
+  if ( !enabled || p < 0 || isEnabled( GL_COLOR_MATERIAL ) ) {
+    glGetMaterialfv( face, pname, params );
+    return;
+  }
+  ValorEstado &e = materiais[f][p];
+  if ( !e.conhecido ) {
+    glGetMaterialfv( face, pname, e.v );
+    e.conhecido = true;
+  }
+  memcpy( params, e.v, componentes( pname ) * sizeof( GLfloat ) );
+}
+
+void GLState::colorMaterial( GLenum face, GLenum mode ) {
+  GLfloat v[2] = { (GLfloat)face, (GLfloat)mode };
+  if ( !enabled || muda( colorMaterialFP, v, 2 ) )
+    glColorMaterial( face, mode );
+}
+
+void GLState::getColorMaterial( GLenum &face, GLenum &mode ) {
+  if ( !enabled || !colorMaterialFP.conhecido ) {
+    GLint f, m;
+    glGetIntegerv( GL_COLOR_MATERIAL_FACE, &f );
+    glGetIntegerv( GL_COLOR_MATERIAL_PARAMETER, &m );
+    colorMaterialFP.v[0]      = (GLfloat)f;
+    colorMaterialFP.v[1]      = (GLfloat)m;
+    colorMaterialFP.conhecido = enabled;
+  }
+  face = (GLenum)colorMaterialFP.v[0];
+  mode = (GLenum)colorMaterialFP.v[1];
+}
+
+void GLState::blendFunc( GLenum sfactor, GLenum dfactor ) {
+  if ( enabled ) {
+    if ( blendConhecido && blend[0] == sfactor && blend[1] == dfactor )
+      return;
+    blend[0]       = sfactor;
+    blend[1]       = dfactor;
+    blendConhecido = true;
+  }
+  glBlendFunc( sfactor, dfactor );
+}
+
+void GLState::getBlendFunc( GLenum &sfactor, GLenum &dfactor ) {
+  if ( !enabled || !blendConhecido ) {
+    GLint s, d;
+    glGetIntegerv( GL_BLEND_SRC, &s );
+    glGetIntegerv( GL_BLEND_DST, &d );
+    blend[0]       = (GLenum)s;
+    blend[1]       = (GLenum)d;
+    blendConhecido = enabled;
+  }
+  sfactor = blend[0];
+  dfactor = blend[1];
+}
+
+void GLState::activeTexture( GLenum texture ) {
+  if ( enabled ) {
+    if ( unidadeConhecida && unidadeAtiva == texture )
+      return;
+    unidadeAtiva     = texture;
+    unidadeConhecida = true;
+  }
+  glActiveTexture( texture );
+}
+
+static void leUnidadeAtiva() {
+  if ( GLState::enabled && !unidadeConhecida ) {
+    GLint unidade;
+    glGetIntegerv( GL_ACTIVE_TEXTURE, &unidade );
+    unidadeAtiva     = (GLenum)unidade;
+    unidadeConhecida = true;
+  }
+}
+
+void GLState::bindTexture( GLenum target, GLuint texture ) {
+  leUnidadeAtiva();
+  int u = (int)( unidadeAtiva - GL_TEXTURE0 );
+  if ( enabled && u >= 0 && u < NUM_UNIDADES ) {
+    auto it = texturas[u].find( target );
+    if ( it != texturas[u].end() && it->second == texture )
+      return;
+    texturas[u][target] = texture;
+  }
+  glBindTexture( target, texture );
+}
+
+GLuint GLState::getTexture( GLenum target ) {
+  GLenum ligacao;
+  switch ( target ) {
+  case GL_TEXTURE_1D:       ligacao = GL_TEXTURE_BINDING_1D; break;
+  case GL_TEXTURE_2D:       ligacao = GL_TEXTURE_BINDING_2D; break;
+  case GL_TEXTURE_3D:       ligacao = GL_TEXTURE_BINDING_3D; break;
+  case GL_TEXTURE_CUBE_MAP: ligacao = GL_TEXTURE_BINDING_CUBE_MAP; break;
+  case GL_TEXTURE_2D_ARRAY: ligacao = GL_TEXTURE_BINDING_2D_ARRAY; break;
+  case GL_TEXTURE_BUFFER:   ligacao = GL_TEXTURE_BINDING_BUFFER; break;
+  default:                  return 0;
+  }
+  leUnidadeAtiva();
+  int u = (int)( unidadeAtiva - GL_TEXTURE0 );
+  if ( enabled && u >= 0 && u < NUM_UNIDADES ) {
+    auto it = texturas[u].find( target );
+    if ( it != texturas[u].end() )
+      return it->second;
+  }
+  GLint textura = 0;
+  glGetIntegerv( ligacao, &textura );
+  if ( enabled && u >= 0 && u < NUM_UNIDADES )
+    texturas[u][target] = (GLuint)textura;
+  return (GLuint)textura;
+}
+
+void GLState::useProgram( GLuint program ) {
+  GLfloat v = (GLfloat)program;
+  if ( !enabled || muda( programa, &v, 1 ) )
+    glUseProgram( program );
+}
+
+GLuint GLState::getProgram() {
+  consultaInt( programa, GL_CURRENT_PROGRAM );
+  return (GLuint)programa.v[0];
+}
+
+void GLState::depthMask( GLboolean flag ) {
+  GLfloat v = flag ? 1.0f : 0.0f;
+  if ( !enabled || muda( mascaraProf, &v, 1 ) )
+    glDepthMask( flag );
+}
+
+GLboolean GLState::getDepthMask() {
+  consultaInt( mascaraProf, GL_DEPTH_WRITEMASK );
+  return mascaraProf.v[0] != 0.0f ? GL_TRUE : GL_FALSE;
+}
+
+void GLState::polygonMode( GLenum face, GLenum mode ) {
+  consultaInt( modoPoligono, GL_POLYGON_MODE );
+  GLfloat v[2] = { modoPoligono.v[0], modoPoligono.v[1] };
+  if ( face != GL_BACK )
+    v[0] = (GLfloat)mode;
+  if ( face != GL_FRONT )
+    v[1] = (GLfloat)mode;
+  if ( !enabled || muda( modoPoligono, v, 2 ) )
+    glPolygonMode( face, mode );
+}
+
+void GLState::getPolygonMode( GLenum mode[2] ) {
+  consultaInt( modoPoligono, GL_POLYGON_MODE );
+  mode[0] = (GLenum)modoPoligono.v[0];
+  mode[1] = (GLenum)modoPoligono.v[1];
+}
+
+void GLState::lineWidth( GLfloat width ) {
+  if ( !enabled || muda( larguraLinha, &width, 1 ) )
+    glLineWidth( width );
+}
+
+GLfloat GLState::getLineWidth() {
+  return consultaFloat( larguraLinha, GL_LINE_WIDTH );
+}
+
+void GLState::pointSize( GLfloat size ) {
+  if ( !enabled || muda( tamanhoPonto, &size, 1 ) )
+    glPointSize( size );
+}
+
+GLfloat GLState::getPointSize() {
+  return consultaFloat( tamanhoPonto, GL_POINT_SIZE );
+}
+
+void GLState::invalidate() {
+  caps.clear();
+  for ( int l = 0; l < NUM_LUZES; l++ ) {
+    for ( int p = 0; p < NUM_PARAMS_LUZ; p++ )
+      luzes[l][p].conhecido = false;
+  }
+  for ( int f = 0; f < 2; f++ ) {
+    for ( int p = 0; p < NUM_PARAMS_MATERIAL; p++ )
+      materiais[f][p].conhecido = false;
+  }
+  blendConhecido   = false;
+  unidadeConhecida = false;
+  for ( int u = 0; u < NUM_UNIDADES; u++ )
+    texturas[u].clear();
+  for ( ValorEstado *e :
+        { &programa, &mascaraProf, &modoPoligono, &colorMaterialFP, &larguraLinha, &tamanhoPonto } )
+    e->conhecido = false;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file GLState.h
+ * @brief Declaração da classe GLState, uma cópia na CPU de parte do estado OpenGL.
+ *
+ * @details GUI::setLight é chamada a cada frame para cada luz e GUI::setColor para cada objeto,
+ * quase sempre com os mesmos valores. Com GLState, cada chamada compara o valor pedido com o
+ * último enviado e só chega ao driver o que mudou. São guardados: capacidades (glEnable e
+ * glDisable), parâmetros das luzes (menos GL_POSITION e GL_SPOT_DIRECTION, que dependem da
+ * modelview no momento da chamada e são sempre enviados), materiais, a função de blend, a
+ * unidade de textura ativa, a textura ligada em cada unidade, o programa em uso, a máscara de
+ * profundidade, o modo de polígono, o glColorMaterial, a largura de linha e o tamanho de ponto.
+ * Os get* devolvem a cópia, consultando o OpenGL só na primeira vez (ou sempre, se desligada).
+ *
+ * A cópia só é confiável se todas as alterações desse estado passarem por esta classe. Depois
+ * de alterar algum desses estados diretamente com OpenGL (glMaterialfv, glEnable...) sem
+ * restaurá-lo, chame GLState::invalidate(). O glPopAttrib também altera o OpenGL sem passar por
+ * aqui: um bloco entre glPushAttrib e glPopAttrib que só usa chamadas diretas não precisa de
+ * invalidação, mas se algo dentro dele passar pelo GLState (GUI::setColor, GUI::setLight, as
+ * funções de desenho da cena...), a cópia fica com o valor de dentro do bloco e é preciso chamar
+ * GLState::invalidate() logo depois do glPopAttrib.
+ */
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <GL/gl.h>
+
+/**
+ * @class GLState
+ * @brief Filtro de chamadas redundantes de estado OpenGL.
+ */
+class GLState {
+public:
+  /**
+   * @brief Se falso, todas as chamadas vão direto para o OpenGL, sem consultar nem atualizar a
+   * cópia (ligado por padrão). Desligado durante a gravação de display lists.
+   */
+  static bool enabled;
+
+  static void enable( GLenum cap );
+  static void disable( GLenum cap );
+
+  /**
+   * @brief glEnable se `on`, glDisable caso contrário.
+   */
+  static void set( GLenum cap, bool on );
+
+  /**
+   * @brief Estado de uma capacidade (consulta o OpenGL apenas se ainda não for conhecido).
+   */
+  static bool isEnabled( GLenum cap );
+
+  static void light( GLenum light, GLenum pname, const GLfloat *params );
+  static void light( GLenum light, GLenum pname, GLfloat param );
+
+  /**
+   * @brief Equivalente a glMaterialfv. Com GL_COLOR_MATERIAL ligado o glColor altera o
+   * material sem passar por aqui, então as chamadas são enviadas sem filtro.
+   */
+  static void material( GLenum face, GLenum pname, const GLfloat *params );
+  static void material( GLenum face, GLenum pname, GLfloat param );
+
+  /**
+   * @brief Equivalente a glGetMaterialfv (GL_FRONT ou GL_BACK). Com GL_COLOR_MATERIAL ligado
+   * sempre consulta o OpenGL.
+   */
+  static void getMaterial( GLenum face, GLenum pname, GLfloat *params );
+
+  static void colorMaterial( GLenum face, GLenum mode );
+  static void getColorMaterial( GLenum &face, GLenum &mode );
+
+  static void blendFunc( GLenum sfactor, GLenum dfactor );
+  static void getBlendFunc( GLenum &sfactor, GLenum &dfactor );
+
+  static void   activeTexture( GLenum texture );
+  static void   bindTexture( GLenum target, GLuint texture );
+  static GLuint getTexture( GLenum target ); /**< @brief Textura ligada na unidade ativa. */
+
+  static void   useProgram( GLuint program );
+  static GLuint getProgram();
+
+  static void      depthMask( GLboolean flag );
+  static GLboolean getDepthMask();
+
+  static void polygonMode( GLenum face, GLenum mode );
+
+  /**
+   * @brief Modos de polígono da frente e do verso.
+   */
+  static void getPolygonMode( GLenum mode[2] );
+
+  static void    lineWidth( GLfloat width );
+  static GLfloat getLineWidth();
+  static void    pointSize( GLfloat size );
+  static GLfloat getPointSize();
+
+  /**
+   * @brief Esquece todo o estado conhecido (o próximo pedido de cada valor é enviado).
+   */
+  static void invalidate();
+};
+
+#endif  // GLSTATE_H
@@ -0,0 +1,180 @@
+#include "GpuTimer.h"
+
+#include "Stats.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+bool GpuTimer::enabled = false;
+
+// um escopo medido: par de timestamps (fim == 0 enquanto o escopo esta aberto)
+struct EscopoGpu {
+  const char *name;
+  GLuint      inicio;
+  GLuint      fim;
+};
+
+// queries emitidas em um frame do anel
+struct FrameGpu {
+  std::vector<GLuint>    pool;  // queries de timestamp, reutilizadas a cada volta do anel
+  int                    usadas = 0;
+  std::vector<EscopoGpu> escopos;
+  GLuint                 elapsed      = 0;
+  bool                   elapsedUsada = false;
+  bool                   pendente     = false;
+  long                   frame        = -1;  // Stats::frame() quando foi medido
+};
+
+static FrameGpu         anelGpu[GpuTimer::LATENCY];
+static int              frameAtual   = 0;
+static std::vector<int> pilhaGpu;              // escopos abertos no frame (-1: ignorado no begin)
+static bool             frameAberto  = false;  // GL_TIME_ELAPSED ativa
+static int              suporte      = -1;     // -1: ainda nao verificado
+static long             ultimoMedido = -1;     // frame do ultimo tempo "frame" coletado
+
+static GLuint proximaQuery( FrameGpu &f ) {
+  if ( f.usadas == (int)f.pool.size() ) {
+    GLuint q;
+    glGenQueries( 1, &q );
+    f.pool.push_back( q );
+  }
+  return f.pool[f.usadas++];
+}
+
+static bool disponivel( GLuint q ) {
+  GLint pronta = 0;
+  glGetQueryObjectiv( q, GL_QUERY_RESULT_AVAILABLE, &pronta );
+  return pronta != 0;
+}
+
+static void descarta( FrameGpu &f ) {
+  f.usadas = 0;
+  f.escopos.clear();
+  f.elapsedUsada = false;
+  f.pendente     = false;
+}
+
+// le os resultados de um frame sem bloquear; retorna false se ainda nao estao prontos
+static bool coleta( FrameGpu &f ) {
+  if ( f.elapsedUsada && !disponivel( f.elapsed ) )
+    return false;
+  if ( f.usadas > 0 && !disponivel( f.pool[f.usadas - 1] ) )
+    return false;
+
+  if ( f.elapsedUsada ) {
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v( f.elapsed, GL_QUERY_RESULT, &ns );
+    Stats::setGpuTime( "frame", ns / 1.0e6 );
+    ultimoMedido = f.frame;
+  }
+
+  // um mesmo passe pode executar varias vezes por frame (ex.: varios Model3D)
+  std::map<std::string, std::pair<double, int>> somas;
+  for ( const EscopoGpu &e : f.escopos ) {
+    if ( e.fim == 0 )
+      continue;
+    GLuint64 t0 = 0, t1 = 0;
+    glGetQueryObjectui64v( e.inicio, GL_QUERY_RESULT, &t0 );
+    glGetQueryObjectui64v( e.fim, GL_QUERY_RESULT, &t1 );
+    auto &s = somas[e.name];
+    s.first += t1 > t0 ? ( t1 - t0 ) / 1.0e6 : 0.0;
+    s.second++;
+  }
+  for ( const auto &[name, s] : somas )
+    Stats::setGpuTime( name, s.first, s.second );
+
+  descarta( f );
+  return true;
+}
+
+long GpuTimer::lastMeasuredFrame() {
+  return ultimoMedido;
+}
+
+bool GpuTimer::isSupported() {
+  if ( suporte != -1 )
+    return suporte == 1;
+
+  const char *versao = (const char *)glGetString( GL_VERSION );
+  if ( !versao )
+    return false;  // sem contexto ainda, verifica de novo depois
+
+  int major = 0, minor = 0;
+  sscanf( versao, "%d.%d", &major, &minor );
+  const char *ext = (const char *)glGetString( GL_EXTENSIONS );
+  suporte         = ( major > 3 || ( major == 3 && minor >= 3 ) ) ||
+            ( ext && strstr( ext, "GL_ARB_timer_query" ) );
+  if ( !suporte )
+    printf( "GpuTimer: timer queries nao suportadas (GL %s)\n", versao );
+  return suporte == 1;
+}
+
+void GpuTimer::beginFrame() {
+  if ( !enabled || frameAberto || !isSupported() )
+    return;
+  FrameGpu &f = anelGpu[frameAtual];
+  if ( f.elapsed == 0 )
+    glGenQueries( 1, &f.elapsed );
+  glBeginQuery( GL_TIME_ELAPSED, f.elapsed );
+  f.elapsedUsada = true;
+  f.frame        = Stats::frame();
+  frameAberto    = true;
+}
+
+void GpuTimer::endFrame() {
+  if ( suporte != 1 ) {
+    pilhaGpu.clear();  // so marcadores de escopos ignorados
+    return;
+  }
+
+  // fecha o que ficou aberto e o frame inteiro
+  while ( !pilhaGpu.empty() )
+    end();
+  if ( frameAberto ) {
+    glEndQuery( GL_TIME_ELAPSED );
+    frameAberto = false;
+  }
+
+  FrameGpu &f = anelGpu[frameAtual];
+  f.pendente  = f.elapsedUsada || !f.escopos.empty();
+  frameAtual  = ( frameAtual + 1 ) % LATENCY;
+
+  // coleta do mais antigo para o mais novo; resultados ficam prontos em ordem
+  for ( int i = 0; i < LATENCY; i++ ) {
+    FrameGpu &g = anelGpu[( frameAtual + i ) % LATENCY];
+    if ( g.pendente && !coleta( g ) )
+      break;
+  }
+
+  // o slot que sera reutilizado agora ainda nao ficou pronto: descarta em vez de esperar
+  if ( anelGpu[frameAtual].pendente )
+    descarta( anelGpu[frameAtual] );
+}
+
+void GpuTimer::begin( const char *name ) {
+  if ( !enabled || !isSupported() ) {
+    pilhaGpu.push_back( -1 );  // escopo ignorado: o end correspondente nao fecha nada
+    return;
+  }
+  FrameGpu &f = anelGpu[frameAtual];
+  EscopoGpu e = { name, proximaQuery( f ), 0 };
+  glQueryCounter( e.inicio, GL_TIMESTAMP );
+  pilhaGpu.push_back( (int)f.escopos.size() );
+  f.escopos.push_back( e );
+}
+
+void GpuTimer::end() {
+  if ( pilhaGpu.empty() )
+    return;
+  int indice = pilhaGpu.back();
+  pilhaGpu.pop_back();
+  if ( indice < 0 )
+    return;
+  FrameGpu  &f = anelGpu[frameAtual];
+  EscopoGpu &e = f.escopos[indice];
+  e.fim = proximaQuery( f );
+  glQueryCounter( e.fim, GL_TIMESTAMP );
+}
@@ -0,0 +1,77 @@
+/**
+ * @file GpuTimer.h
+ * @brief Declaração da classe GpuTimer, que mede o tempo de GPU de passes de renderização.
+ *
+ * @details As chamadas OpenGL são assíncronas, então cronômetros de CPU não dizem quanto tempo a
+ * GPU (ou o llvmpipe) gastou em um passe. Esta classe usa queries `GL_TIMESTAMP` (que podem ser
+ * aninhadas) para cada escopo e uma query `GL_TIME_ELAPSED` para o frame inteiro. As queries
+ * ficam em um anel de GpuTimer::LATENCY frames e os resultados só são lidos alguns frames depois,
+ * quando já estão disponíveis, sem bloquear o pipeline. Os tempos lidos vão para a classe Stats.
+ */
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+/**
+ * @class GpuTimer
+ * @brief Cronômetro de GPU baseado em timer queries, com leitura atrasada em anel.
+ */
+class GpuTimer {
+public:
+  static const int LATENCY = 4; /**< @brief Quantidade de frames no anel de queries. */
+
+  static bool enabled; /**< @brief Liga/desliga a medição (desligada por padrão). */
+
+  /**
+   * @class Scope
+   * @brief Mede o tempo de GPU do escopo C++ onde o objeto vive.
+   */
+  class Scope {
+  public:
+    explicit Scope( const char *name ) { GpuTimer::begin( name ); }
+
+    ~Scope() { GpuTimer::end(); }
+
+    Scope( const Scope & )            = delete;
+    Scope &operator=( const Scope & ) = delete;
+  };
+
+  /**
+   * @brief Inicia a query `GL_TIME_ELAPSED` do frame. Chamada por GUI::displayInit.
+   */
+  static void beginFrame();
+
+  /**
+   * @brief Finaliza o frame atual, avança o anel e coleta os resultados já disponíveis.
+   * @details Chamada por GUI::displayEnd, antes da troca de buffers.
+   */
+  static void endFrame();
+
+  /**
+   * @brief Abre um escopo de medição com o nome dado.
+   * @param name Nome do passe. Deve ser uma string de vida longa (normalmente um literal).
+   */
+  static void begin( const char *name );
+
+  /**
+   * @brief Fecha o escopo de medição aberto mais recentemente.
+   */
+  static void end();
+
+  /**
+   * @brief Indica se o driver suporta timer queries (GL_ARB_timer_query ou GL 3.3).
+   * @note Só pode ser chamada com um contexto OpenGL ativo.
+   */
+  static bool isSupported();
+
+  /**
+   * @brief Frame (Stats::frame) a que pertence o último tempo "frame" entregue a Stats, ou -1.
+   * @details Os resultados chegam até LATENCY frames depois da medição; use este índice para
+   * associar o tempo de GPU ao frame certo.
+   */
+  static long lastMeasuredFrame();
+};
+
+#endif  // GPUTIMER_H
@@ -0,0 +1,460 @@
+#include "Lighting.h"
+
+#include "Batch.h"
+#include "GLInstrument.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "Trace.h"
+#include "extra.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int   Lighting::dimX      = 16;
+int   Lighting::dimY      = 9;
+int   Lighting::dimZ      = 24;
+float Lighting::threshold = 1.0 / 256.0;
+
+// unidades de textura dos buffers (a 0 fica com a textura 2D)
+enum { UNIDADE_LUZES = 1, UNIDADE_GRADE = 2, UNIDADE_INDICES = 3 };
+static const int TEXELS_POR_LUZ = 6;
+
+static std::vector<Lighting::Light> luzes;
+
+static GLuint programa = 0;
+static bool   falhou   = false;
+static GLuint buffers[3], texturas[3];  // luzes, grade (inicio e quantidade) e indices
+static GLint  uGlobais = -1, uDims = -1, uViewport = -1, uZNear = -1, uZFar = -1, uLog = -1;
+static GLint  uUsaTextura = -1, uCorMaterial = -1, uIluminacao = -1;
+static int    atribuidas  = 0;
+
+// caixas dos clusters no espaco do olho, refeitas quando a projecao ou as dimensoes mudam
+static std::vector<float> caixas;  // 6 floats por cluster: min xyz e max xyz
+static float              projCaixas[16];
+static int                dimsCaixas[3] = { 0, 0, 0 };
+static float              zNear, zFar;
+static bool               fatiasLog;
+
+// listas por cluster e dados enviados (reaproveitados de um frame para o outro)
+static std::vector<std::vector<int>> porCluster;
+static std::vector<GLfloat>          dadosLuzes;
+static std::vector<GLint>            grade, indices;
+
+// GLSL 1.50 de compatibilidade: samplerBuffer e texelFetch sao do nucleo desde a 1.40, sem a
+// extensao GL_ARB_texture_buffer_object (recusada no fragment shader por alguns drivers, como o
+// Mesa), e as variaveis do pipeline fixo continuam disponiveis
+static const char *FONTE_VERTICE =
+  "#version 150 compatibility\n"
+  "out vec3 posOlho;\n"
+  "out vec3 normalOlho;\n"
+  "out vec4 corVertice;\n"
+  "void main() {\n"
+  "  vec4 pe      = gl_ModelViewMatrix * gl_Vertex;\n"
+  "  posOlho      = pe.xyz;\n"
+  "  normalOlho   = gl_NormalMatrix * gl_Normal;\n"
+  "  corVertice   = gl_Color;\n"
+  "  gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+  "  gl_ClipVertex  = pe;\n"
+  "  gl_Position    = gl_ProjectionMatrix * pe;\n"
+  "}\n";
+
+static const char *FONTE_FRAGMENTO =
+  "#version 150 compatibility\n"
+  "uniform samplerBuffer  luzes;\n"
+  "uniform isamplerBuffer grade;\n"
+  "uniform isamplerBuffer indices;\n"
+  "uniform sampler2D      textura;\n"
+  "uniform int   numGlobais;\n"
+  "uniform ivec3 dims;\n"
+  "uniform vec4  viewport;\n"
+  "uniform float zNear;\n"
+  "uniform float zFar;\n"
+  "uniform bool  fatiasLog;\n"
+  "uniform bool  usaTextura;\n"
+  "uniform bool  corMaterial;\n"
+  "uniform bool  iluminacao;\n"
+  "in vec3 posOlho;\n"
+  "in vec3 normalOlho;\n"
+  "in vec4 corVertice;\n"
+  // mesma equacao do pipeline fixo (observador no infinito), com os dados da luz i
+  "vec3 luz( int i, vec3 p, vec3 n, vec3 amb, vec3 dif, vec3 spec, float brilho ) {\n"
+  "  int  b  = i * 6;\n"
+  "  vec4 t0 = texelFetch( luzes, b );\n"      // posicao (w = 0: direcional)
+  "  vec4 t1 = texelFetch( luzes, b + 1 );\n"  // ambiente
+  "  vec4 t2 = texelFetch( luzes, b + 2 );\n"  // difusa, cosseno do corte do spot
+  "  vec4 t3 = texelFetch( luzes, b + 3 );\n"  // especular, expoente do spot
+  "  vec4 t4 = texelFetch( luzes, b + 4 );\n"  // direcao do spot
+  "  vec4 t5 = texelFetch( luzes, b + 5 );\n"  // atenuacao constante, linear e quadratica
+  "  vec3  L;\n"
+  "  float att = 1.0;\n"
+  "  if ( t0.w == 0.0 ) {\n"
+  "    L = normalize( t0.xyz );\n"
+  "  } else {\n"
+  "    vec3  d    = t0.xyz - p;\n"
+  "    float dist = length( d );\n"
+  "    L          = d / dist;\n"
+  "    att        = 1.0 / ( t5.x + t5.y * dist + t5.z * dist * dist );\n"
+  "    if ( t2.w >= -1.0 ) {\n"
+  "      float c = dot( -L, t4.xyz );\n"
+  "      att *= c < t2.w ? 0.0 : pow( max( c, 0.0 ), t3.w );\n"
+  "    }\n"
+  "  }\n"
+  "  float nl = max( dot( n, L ), 0.0 );\n"
+  "  vec3  c  = amb * t1.rgb + nl * dif * t2.rgb;\n"
+  "  if ( nl > 0.0 ) {\n"
+  "    vec3 h = normalize( L + vec3( 0.0, 0.0, 1.0 ) );\n"
+  "    c += pow( max( dot( n, h ), 0.0 ), brilho ) * spec * t3.rgb;\n"
+  "  }\n"
+  "  return att * c;\n"
+  "}\n"
+  "int fatia( float z ) {\n"
+  "  if ( z < zNear )\n"
+  "    return -1;\n"
+  "  float f = fatiasLog ? log( z / zNear ) / log( zFar / zNear )\n"
+  "                      : ( z - zNear ) / ( zFar - zNear );\n"
+  "  return int( floor( f * float( dims.z ) ) );\n"
+  "}\n"
+  "void main() {\n"
+  "  if ( !iluminacao ) {\n"  // GL_LIGHTING desligado: so a cor do vertice, como no pipeline fixo
+  "    gl_FragColor = corVertice;\n"
+  "    if ( usaTextura )\n"
+  "      gl_FragColor *= texture2D( textura, gl_TexCoord[0].st );\n"
+  "    return;\n"
+  "  }\n"
+  "  vec3  n      = normalize( normalOlho );\n"
+  "  vec4  amb    = corMaterial ? corVertice : gl_FrontMaterial.ambient;\n"
+  "  vec4  dif    = corMaterial ? corVertice : gl_FrontMaterial.diffuse;\n"
+  "  vec3  spec   = gl_FrontMaterial.specular.rgb;\n"
+  "  float brilho = gl_FrontMaterial.shininess;\n"
+  "  vec3  cor    = gl_FrontMaterial.emission.rgb + amb.rgb * gl_LightModel.ambient.rgb;\n"
+  "  for ( int k = 0; k < numGlobais; k++ )\n"
+  "    cor += luz( texelFetch( indices, k ).r, posOlho, n, amb.rgb, dif.rgb, spec, brilho );\n"
+  "  ivec2 bloco = ivec2( ( gl_FragCoord.xy - viewport.xy ) / viewport.zw * vec2( dims.xy ) );\n"
+  "  bloco       = clamp( bloco, ivec2( 0 ), dims.xy - 1 );\n"
+  "  int   s     = fatia( -posOlho.z );\n"
+  "  if ( s >= 0 && s < dims.z ) {\n"
+  "    ivec2 g = texelFetch( grade, ( s * dims.y + bloco.y ) * dims.x + bloco.x ).rg;\n"
+  "    for ( int k = 0; k < g.y; k++ ) {\n"
+  "      int i = texelFetch( indices, g.x + k ).r;\n"
+  "      cor += luz( i, posOlho, n, amb.rgb, dif.rgb, spec, brilho );\n"
+  "    }\n"
+  "  }\n"
+  "  vec4 res = vec4( clamp( cor, 0.0, 1.0 ), dif.a );\n"
+  "  if ( usaTextura )\n"
+  "    res *= texture2D( textura, gl_TexCoord[0].st );\n"
+  "  gl_FragColor = res;\n"
+  "}\n";
+
+static bool criaPrograma() {
+  programa = Shader::program( FONTE_VERTICE, FONTE_FRAGMENTO, "Lighting" );
+  if ( programa == 0 )
+    return false;
+  glGenBuffers( 3, buffers );
+  glGenTextures( 3, texturas );
+  const GLenum formatos[3] = { GL_RGBA32F, GL_RG32I, GL_R32I };
+  for ( int k = 0; k < 3; k++ ) {
+    glBindBuffer( GL_TEXTURE_BUFFER, buffers[k] );
+    glBufferData( GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW );
+    glBindTexture( GL_TEXTURE_BUFFER, texturas[k] );
+    glTexBuffer( GL_TEXTURE_BUFFER, formatos[k], buffers[k] );
+  }
+  glBindTexture( GL_TEXTURE_BUFFER, 0 );
+  glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+
+  GLState::useProgram( programa );
+  glUniform1i( glGetUniformLocation( programa, "luzes" ), UNIDADE_LUZES );
+  glUniform1i( glGetUniformLocation( programa, "grade" ), UNIDADE_GRADE );
+  glUniform1i( glGetUniformLocation( programa, "indices" ), UNIDADE_INDICES );
+  glUniform1i( glGetUniformLocation( programa, "textura" ), 0 );
+  GLState::useProgram( 0 );
+  uGlobais     = glGetUniformLocation( programa, "numGlobais" );
+  uDims        = glGetUniformLocation( programa, "dims" );
+  uViewport    = glGetUniformLocation( programa, "viewport" );
+  uZNear       = glGetUniformLocation( programa, "zNear" );
+  uZFar        = glGetUniformLocation( programa, "zFar" );
+  uLog         = glGetUniformLocation( programa, "fatiasLog" );
+  uUsaTextura  = glGetUniformLocation( programa, "usaTextura" );
+  uCorMaterial = glGetUniformLocation( programa, "corMaterial" );
+  uIluminacao  = glGetUniformLocation( programa, "iluminacao" );
+  return true;
+}
+
+// fatia de uma distancia ao olho (a mesma conta do shader), sem limitar ao intervalo
+static int fatia( float z ) {
+  if ( z < zNear )
+    return -1;
+  float f = fatiasLog ? log( z / zNear ) / log( zFar / zNear ) : ( z - zNear ) / ( zFar - zNear );
+  return (int)floor( f * Lighting::dimZ );
+}
+
+static float distanciaFatia( int s ) {
+  float f = (float)s / Lighting::dimZ;
+  return fatiasLog ? zNear * pow( zFar / zNear, f ) : zNear + ( zFar - zNear ) * f;
+}
+
+// caixas envolventes dos clusters: cada vertice da grade da tela vira um raio (do plano near ao
+// far, pela inversa da projecao), cortado nas profundidades das fatias
+static void montaCaixas( const Matriz4 &proj ) {
+  int nx = Lighting::dimX, ny = Lighting::dimY, nz = Lighting::dimZ;
+  if ( !caixas.empty() && memcmp( projCaixas, proj.m, sizeof( projCaixas ) ) == 0 &&
+       dimsCaixas[0] == nx && dimsCaixas[1] == ny && dimsCaixas[2] == nz )
+    return;
+  memcpy( projCaixas, proj.m, sizeof( projCaixas ) );
+  dimsCaixas[0] = nx;
+  dimsCaixas[1] = ny;
+  dimsCaixas[2] = nz;
+
+  // near e far da matriz de projecao (perspectiva ou ortografica)
+  bool perspectiva = proj.m[11] != 0.0f;
+  if ( perspectiva ) {
+    zNear = proj.m[14] / ( proj.m[10] - 1.0f );
+    zFar  = proj.m[14] / ( proj.m[10] + 1.0f );
+  } else {
+    zNear = ( proj.m[14] + 1.0f ) / proj.m[10];
+    zFar  = ( proj.m[14] - 1.0f ) / proj.m[10];
+  }
+  fatiasLog = perspectiva && zNear > 0.0f;
+
+  Matriz4              inv = proj.inverse();
+  std::vector<Vetor3D> origem( ( nx + 1 ) * ( ny + 1 ) ), destino( origem.size() );
+  for ( int y = 0; y <= ny; y++ ) {
+    for ( int x = 0; x <= nx; x++ ) {
+      float ndcX = -1.0f + 2.0f * x / nx, ndcY = -1.0f + 2.0f * y / ny;
+      origem[y * ( nx + 1 ) + x]  = inv.transformPoint( Vetor3D( ndcX, ndcY, -1.0 ) );
+      destino[y * ( nx + 1 ) + x] = inv.transformPoint( Vetor3D( ndcX, ndcY, 1.0 ) );
+    }
+  }
+
+  caixas.assign( (size_t)nx * ny * nz * 6, 0.0f );
+  std::vector<Vetor3D> corte[2] = { std::vector<Vetor3D>( origem.size() ),
+                                    std::vector<Vetor3D>( origem.size() ) };
+  for ( int s = 0; s < nz; s++ ) {
+    for ( int k = 0; k < 2; k++ ) {
+      float z = -distanciaFatia( s + k );
+      for ( size_t v = 0; v < origem.size(); v++ ) {
+        Vetor3D a = origem[v], d = destino[v] - origem[v];
+        float   t = d.z != 0.0 ? ( z - a.z ) / d.z : 0.0f;
+        corte[k][v] = a + d * t;
+      }
+    }
+    for ( int y = 0; y < ny; y++ ) {
+      for ( int x = 0; x < nx; x++ ) {
+        float *c = &caixas[( ( (size_t)s * ny + y ) * nx + x ) * 6];
+        c[0] = c[1] = c[2] = HUGE_VALF;
+        c[3] = c[4] = c[5] = -HUGE_VALF;
+        for ( int k = 0; k < 2; k++ ) {
+          for ( int q = 0; q < 4; q++ ) {
+            Vetor3D p = corte[k][( y + ( q >> 1 ) ) * ( nx + 1 ) + x + ( q & 1 )];
+            float   v[3] = { (float)p.x, (float)p.y, (float)p.z };
+            for ( int e = 0; e < 3; e++ ) {
+              c[e]     = std::min( c[e], v[e] );
+              c[e + 3] = std::max( c[e + 3], v[e] );
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+static float maiorComponente( Vetor3D v ) {
+  return std::max( (float)v.x, std::max( (float)v.y, (float)v.z ) );
+}
+
+int Lighting::addLight( const Light &light ) {
+  luzes.push_back( light );
+  return (int)luzes.size() - 1;
+}
+
+Lighting::Light &Lighting::light( int i ) {
+  return luzes[i];
+}
+
+int Lighting::lightCount() {
+  return (int)luzes.size();
+}
+
+void Lighting::clearLights() {
+  luzes.clear();
+}
+
+Lighting::Light Lighting::fromSetLight(
+  float posx, float posy, float posz, bool attenuated, bool low, bool pontual, bool spot ) {
+  Light l;
+  l.position    = Vetor3D( posx + glutGUI::lx, posy + glutGUI::ly, posz + glutGUI::lz );
+  l.directional = !pontual;
+  if ( low ) {
+    l.ambient  = Vetor3D( 0.02, 0.02, 0.02 );
+    l.diffuse  = Vetor3D( 0.4, 0.4, 0.4 );
+    l.specular = Vetor3D( 0.5, 0.5, 0.5 );
+  }
+  if ( spot ) {
+    l.spotDirection = Vetor3D( 0, 0, -1 );
+    l.spotCutoff    = glutGUI::spot_angle;
+  }
+  if ( attenuated ) {
+    l.constantAttenuation  = 2.0;
+    l.linearAttenuation    = 1.0;
+    l.quadraticAttenuation = 0.5;
+  }
+  return l;
+}
+
+float Lighting::rangeFromAttenuation(
+  float constant, float linear, float quadratic, float intensity, float threshold ) {
+  // constant + linear d + quadratic d^2 = alvo
+  float alvo = intensity / threshold;
+  if ( constant >= alvo )
+    return 0.0f;  // nunca chega ao limite
+  if ( quadratic > 0.0f ) {
+    float delta = linear * linear - 4.0f * quadratic * ( constant - alvo );
+    return ( -linear + sqrt( delta ) ) / ( 2.0f * quadratic );
+  }
+  if ( linear > 0.0f )
+    return ( alvo - constant ) / linear;
+  return HUGE_VALF;
+}
+
+bool Lighting::begin() {
+  Batch::flush();  // o que foi agrupado antes e da iluminacao fixa
+  if ( glutGUI::picking || falhou )
+    return false;
+  if ( programa == 0 && !criaPrograma() ) {
+    // o log do shader ja foi impresso por Shader::program; falhou evita repetir a cada frame
+    printf( "Lighting: programa indisponivel, usando a iluminacao fixa\n" );
+    falhou = true;
+    return false;
+  }
+  QXGL_TRACE_ZONE( "Lighting::begin" );
+
+  int nx = std::max( dimX, 1 ), ny = std::max( dimY, 1 ), nz = std::max( dimZ, 1 );
+  dimX = nx;
+  dimY = ny;
+  dimZ = nz;
+  const Matriz4 &view = glutGUI::cam->view();
+  montaCaixas( glutGUI::cam->projection() );
+
+  // luzes no espaco do olho: 6 texels cada (ver o fragment shader)
+  size_t nClusters = (size_t)nx * ny * nz;
+  porCluster.resize( nClusters );
+  for ( auto &lista : porCluster )
+    lista.clear();
+  dadosLuzes.resize( std::max<size_t>( luzes.size(), 1 ) * TEXELS_POR_LUZ * 4 );
+  indices.clear();
+  for ( size_t i = 0; i < luzes.size(); i++ ) {
+    const Light &l = luzes[i];
+    GLfloat     *d = &dadosLuzes[i * TEXELS_POR_LUZ * 4];
+    float        pos[4], v[4] = { (float)l.position.x, (float)l.position.y, (float)l.position.z,
+                                  l.directional ? 0.0f : 1.0f };
+    view.transform( pos, v );
+    float spot[4], s[4] = { (float)l.spotDirection.x, (float)l.spotDirection.y,
+                            (float)l.spotDirection.z, 0.0f };
+    view.transform( spot, s );
+    float ns = sqrt( spot[0] * spot[0] + spot[1] * spot[1] + spot[2] * spot[2] );
+    ns       = ns > 0.0f ? ns : 1.0f;
+    GLfloat texels[TEXELS_POR_LUZ][4] = {
+      { pos[0], pos[1], pos[2], v[3] },
+      { (float)l.ambient.x, (float)l.ambient.y, (float)l.ambient.z, 0.0f },
+      { (float)l.diffuse.x,
+        (float)l.diffuse.y,
+        (float)l.diffuse.z,
+        l.spotCutoff <= 90.0f ? (float)cos( l.spotCutoff * M_PI / 180.0 ) : -2.0f },
+      { (float)l.specular.x, (float)l.specular.y, (float)l.specular.z, l.spotExponent },
+      { spot[0] / ns, spot[1] / ns, spot[2] / ns, 0.0f },
+      { l.constantAttenuation, l.linearAttenuation, l.quadraticAttenuation, 0.0f } };
+    memcpy( d, texels, sizeof( texels ) );
+
+    float alcance = l.range;
+    if ( alcance <= 0.0f && !l.directional )
+      alcance = rangeFromAttenuation( l.constantAttenuation,
+                                      l.linearAttenuation,
+                                      l.quadraticAttenuation,
+                                      std::max( maiorComponente( l.diffuse ),
+                                                maiorComponente( l.specular ) ),
+                                      threshold );
+    if ( l.directional || std::isinf( alcance ) ) {
+      indices.push_back( (GLint)i );  // global: vale para todos os pixels
+      continue;
+    }
+    if ( alcance <= 0.0f )
+      continue;
+
+    // fatias e clusters tocados pela esfera de alcance
+    float z  = -pos[2];
+    int   s0 = std::max( fatia( std::max( z - alcance, zNear ) ), 0 );
+    int   s1 = std::min( fatia( z + alcance ), nz - 1 );
+    for ( int sl = s0; sl <= s1; sl++ ) {
+      for ( int c = sl * nx * ny; c < ( sl + 1 ) * nx * ny; c++ ) {
+        const float *b  = &caixas[(size_t)c * 6];
+        float        d2 = 0.0f;
+        for ( int e = 0; e < 3; e++ ) {
+          float q = pos[e] < b[e] ? b[e] - pos[e] : pos[e] > b[e + 3] ? pos[e] - b[e + 3] : 0.0f;
+          d2 += q * q;
+        }
+        if ( d2 <= alcance * alcance )
+          porCluster[c].push_back( (int)i );
+      }
+    }
+  }
+
+  // indices: globais primeiro, depois as listas dos clusters; grade: (inicio, quantidade)
+  int numGlobais = (int)indices.size();
+  grade.resize( nClusters * 2 );
+  atribuidas = 0;
+  for ( size_t c = 0; c < nClusters; c++ ) {
+    grade[2 * c]     = (GLint)indices.size();
+    grade[2 * c + 1] = (GLint)porCluster[c].size();
+    indices.insert( indices.end(), porCluster[c].begin(), porCluster[c].end() );
+    atribuidas += (int)porCluster[c].size();
+  }
+  if ( indices.empty() )
+    indices.push_back( 0 );
+
+  glBindBuffer( GL_TEXTURE_BUFFER, buffers[0] );
+  glBufferData(
+    GL_TEXTURE_BUFFER, dadosLuzes.size() * sizeof( GLfloat ), dadosLuzes.data(), GL_STREAM_DRAW );
+  glBindBuffer( GL_TEXTURE_BUFFER, buffers[1] );
+  glBufferData( GL_TEXTURE_BUFFER, grade.size() * sizeof( GLint ), grade.data(), GL_STREAM_DRAW );
+  glBindBuffer( GL_TEXTURE_BUFFER, buffers[2] );
+  glBufferData(
+    GL_TEXTURE_BUFFER, indices.size() * sizeof( GLint ), indices.data(), GL_STREAM_DRAW );
+  glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+
+  for ( int k = 0; k < 3; k++ ) {
+    GLState::activeTexture( GL_TEXTURE0 + UNIDADE_LUZES + k );
+    GLState::bindTexture( GL_TEXTURE_BUFFER, texturas[k] );
+  }
+  GLState::activeTexture( GL_TEXTURE0 );
+
+  GLint vp[4];
+  glGetIntegerv( GL_VIEWPORT, vp );
+  GLState::useProgram( programa );
+  glUniform1i( uGlobais, numGlobais );
+  glUniform3i( uDims, nx, ny, nz );
+  glUniform4f( uViewport, vp[0], vp[1], vp[2], vp[3] );
+  glUniform1f( uZNear, zNear );
+  glUniform1f( uZFar, zFar );
+  glUniform1i( uLog, fatiasLog );
+  sync();
+  return true;
+}
+
+void Lighting::sync() {
+  glUniform1i( uUsaTextura, GLState::isEnabled( GL_TEXTURE_2D ) );
+  glUniform1i( uCorMaterial, GLState::isEnabled( GL_COLOR_MATERIAL ) );
+  glUniform1i( uIluminacao, GLState::isEnabled( GL_LIGHTING ) );
+}
+
+void Lighting::end() {
+  if ( programa == 0 )
+    return;
+  Batch::flush();  // o que foi agrupado entre begin() e end() ainda precisa do programa
+  GLState::useProgram( 0 );
+}
+
+int Lighting::assignedCount() {
+  return atribuidas;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file Lighting.h
+ * @brief Declaração da classe Lighting, iluminação por pixel em GLSL com centenas de luzes.
+ *
+ * @details A iluminação fixa é limitada a GL_LIGHT0..7 e é calculada por vértice. Este caminho
+ * opcional guarda as luzes em um texture buffer e as distribui, na CPU, por clusters (froxels):
+ * o volume de visão é dividido em dimX x dimY blocos da tela e dimZ fatias de profundidade
+ * (exponenciais em perspectiva), e cada cluster recebe só as luzes cuja esfera de alcance o
+ * toca. No fragment shader, cada pixel percorre apenas a lista do seu cluster, mais as luzes sem
+ * alcance definido (direcionais ou sem atenuação), aplicadas em todos os pixels.
+ *
+ * Entre Lighting::begin() e Lighting::end() os desenhos usuais (GUI::drawBox, Primitives,
+ * Model3D...) são iluminados pelas luzes desta classe, com o material corrente (glMaterial,
+ * GUI::setColor), a textura 2D e a mesma equação do pipeline fixo. GL_LIGHT0..7 são ignoradas.
+ */
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include "Vetor3D.h"
+
+/**
+ * @class Lighting
+ * @brief Lista de luzes e programa de iluminação por clusters.
+ */
+class Lighting {
+public:
+  /**
+   * @struct Light
+   * @brief Luz pontual, spot ou direcional, com os parâmetros de glLight (no espaço do mundo).
+   */
+  struct Light {
+    Vetor3D position = Vetor3D( 0, 1, 0 ); /**< @brief Posição (ou direção, se directional). */
+    bool    directional = false;           /**< @brief Luz no infinito (como w = 0). */
+    Vetor3D ambient  = Vetor3D( 0.2, 0.2, 0.2 );
+    Vetor3D diffuse  = Vetor3D( 0.7, 0.7, 0.7 );
+    Vetor3D specular = Vetor3D( 0.7, 0.7, 0.7 );
+    Vetor3D spotDirection        = Vetor3D( 0, 0, -1 );
+    float   spotCutoff           = 180.0; /**< @brief Em graus; 180 desliga o spot. */
+    float   spotExponent         = 0.0;
+    float   constantAttenuation  = 1.0;
+    float   linearAttenuation    = 0.0;
+    float   quadraticAttenuation = 0.0;
+    float   range = 0.0; /**< @brief Alcance; 0 calcula pela atenuação (rangeFromAttenuation). */
+  };
+
+  static int   dimX;      /**< @brief Clusters na horizontal da tela (padrão 16). */
+  static int   dimY;      /**< @brief Clusters na vertical da tela (padrão 9). */
+  static int   dimZ;      /**< @brief Fatias de profundidade (padrão 24). */
+  static float threshold; /**< @brief Fração da intensidade abaixo da qual a luz é desprezada no
+                             cálculo do alcance (padrão 1/256). */
+
+  /**
+   * @brief Acrescenta uma luz e retorna o seu índice.
+   */
+  static int addLight( const Light &light );
+
+  /**
+   * @brief Luz de índice i (pode ser alterada livremente entre os frames).
+   */
+  static Light &light( int i );
+
+  static int  lightCount();
+  static void clearLights();
+
+  /**
+   * @brief Luz equivalente a GUI::setLight com os mesmos parâmetros.
+   * @details Usa as mesmas intensidades (e as reduzidas de `low`), a translação glutGUI::lx,
+   * ly, lz, o spot com glutGUI::spot_angle e a atenuação (2, 1, 0.5) de `attenuated`.
+   */
+  static Light fromSetLight( float posx,
+                             float posy,
+                             float posz,
+                             bool  attenuated = false,
+                             bool  low        = false,
+                             bool  pontual    = true,
+                             bool  spot       = false );
+
+  /**
+   * @brief Distância em que a atenuação reduz a intensidade a `threshold` dela.
+   * @details Resolve constant + linear d + quadratic d² = intensity / threshold.
+   * @param intensity Maior componente da cor da luz.
+   * @return O alcance, ou infinito se a luz não é atenuada.
+   */
+  static float rangeFromAttenuation( float constant,
+                                     float linear,
+                                     float quadratic,
+                                     float intensity = 1.0,
+                                     float threshold = 1.0 / 256.0 );
+
+  /**
+   * @brief Distribui as luzes pelos clusters da câmera glutGUI::cam e ativa o programa.
+   * @details Usa as matrizes da câmera e a viewport corrente. Lê neste momento se GL_LIGHTING,
+   * GL_TEXTURE_2D e GL_COLOR_MATERIAL estão ligados (chame sync() se mudá-los antes de end());
+   * com GL_LIGHTING desligado os desenhos ficam com a cor do vértice, como na iluminação fixa.
+   * Exige GLSL 1.50 com o perfil de compatibilidade (OpenGL 3.2).
+   * @return Falso durante o picking ou se o programa não puder ser criado (nada é alterado e os
+   * desenhos usam a iluminação fixa; o log do shader é impresso uma vez).
+   */
+  static bool begin();
+
+  /**
+   * @brief Relê GL_LIGHTING, GL_TEXTURE_2D e GL_COLOR_MATERIAL entre begin() e end().
+   */
+  static void sync();
+
+  /**
+   * @brief Volta ao pipeline fixo.
+   */
+  static void end();
+
+  /**
+   * @brief Quantidade de pares (cluster, luz) do último begin(), para avaliar a distribuição.
+   */
+  static int assignedCount();
+};
+
+#endif  // LIGHTING_H
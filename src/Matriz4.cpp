@@ -0,0 +1,150 @@
+#include "Matriz4.h"
+
+//---------------------------------------------------------------------------
+// Construtor (identidade)
+Matriz4::Matriz4() {
+  for ( int i = 0; i < 16; i++ )
+    m[i] = ( i % 5 == 0 ) ? 1.0f : 0.0f;
+}
+
+//---------------------------------------------------------------------------
+Matriz4 Matriz4::operator*( const Matriz4 &b ) const {
+  Matriz4 r;
+  for ( int j = 0; j < 4; j++ ) {
+    for ( int i = 0; i < 4; i++ ) {
+      float s = 0.0f;
+      for ( int k = 0; k < 4; k++ )
+        s += ( *this )( i, k ) * b( k, j );
+      r( i, j ) = s;
+    }
+  }
+  return r;
+}
+
+//---------------------------------------------------------------------------
+// inversa pela matriz adjunta (cofatores 2x2), como no gluInvertMatrix do MESA
+Matriz4 Matriz4::inverse() const {
+  const float *a = m;
+  float        inv[16];
+
+  inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] +
+           a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+  inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] -
+           a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+  inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] +
+           a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+  inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] -
+            a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+  inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] -
+           a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+  inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] +
+           a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+  inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] -
+           a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+  inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] +
+            a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+  inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] +
+           a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+  inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] -
+           a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+  inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] +
+            a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+  inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] -
+            a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+  inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] -
+           a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+  inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] +
+           a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+  inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] -
+            a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+  inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] +
+            a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+  float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+
+  Matriz4 r;
+  if ( det == 0.0f )
+    return r;
+  det = 1.0f / det;
+  for ( int i = 0; i < 16; i++ )
+    r.m[i] = inv[i] * det;
+  return r;
+}
+
+//---------------------------------------------------------------------------
+Vetor3D Matriz4::transformPoint( Vetor3D p ) const {
+  float v[4] = { p.x, p.y, p.z, 1.0f };
+  float r[4];
+  transform( r, v );
+  if ( r[3] != 0.0f && r[3] != 1.0f ) {
+    r[0] /= r[3];
+    r[1] /= r[3];
+    r[2] /= r[3];
+  }
+  return Vetor3D( r[0], r[1], r[2] );
+}
+
+//---------------------------------------------------------------------------
+void Matriz4::transform( float res[4], const float v[4] ) const {
+  for ( int i = 0; i < 4; i++ )
+    res[i] = m[i] * v[0] + m[4 + i] * v[1] + m[8 + i] * v[2] + m[12 + i] * v[3];
+}
+
+//---------------------------------------------------------------------------
+Matriz4 Matriz4::perspective( float fovy, float aspect, float zNear, float zFar ) {
+  float   f = 1.0f / tan( grauToRad( fovy ) / 2.0 );
+  Matriz4 r;
+  r( 0, 0 ) = f / aspect;
+  r( 1, 1 ) = f;
+  r( 2, 2 ) = ( zFar + zNear ) / ( zNear - zFar );
+  r( 2, 3 ) = ( 2.0f * zFar * zNear ) / ( zNear - zFar );
+  r( 3, 2 ) = -1.0f;
+  r( 3, 3 ) = 0.0f;
+  return r;
+}
+
+//---------------------------------------------------------------------------
+Matriz4
+  Matriz4::ortho( float left, float right, float bottom, float top, float zNear, float zFar ) {
+  Matriz4 r;
+  r( 0, 0 ) = 2.0f / ( right - left );
+  r( 1, 1 ) = 2.0f / ( top - bottom );
+  r( 2, 2 ) = -2.0f / ( zFar - zNear );
+  r( 0, 3 ) = -( right + left ) / ( right - left );
+  r( 1, 3 ) = -( top + bottom ) / ( top - bottom );
+  r( 2, 3 ) = -( zFar + zNear ) / ( zFar - zNear );
+  return r;
+}
+
+//---------------------------------------------------------------------------
+Matriz4 Matriz4::lookAt( Vetor3D e, Vetor3D c, Vetor3D u ) {
+  Vetor3D f = c - e;
+  !f;
+  Vetor3D s = f ^ u;
+  !s;
+  Vetor3D v = s ^ f;
+
+  Matriz4 r;
+  r( 0, 0 ) = s.x;
+  r( 0, 1 ) = s.y;
+  r( 0, 2 ) = s.z;
+  r( 1, 0 ) = v.x;
+  r( 1, 1 ) = v.y;
+  r( 1, 2 ) = v.z;
+  r( 2, 0 ) = -f.x;
+  r( 2, 1 ) = -f.y;
+  r( 2, 2 ) = -f.z;
+  r( 0, 3 ) = -( s * e );
+  r( 1, 3 ) = -( v * e );
+  r( 2, 3 ) = f * e;
+  return r;
+}
+
+//---------------------------------------------------------------------------
+Matriz4 Matriz4::translation( float x, float y, float z ) {
+  Matriz4 r;
+  r( 0, 3 ) = x;
+  r( 1, 3 ) = y;
+  r( 2, 3 ) = z;
+  return r;
+}
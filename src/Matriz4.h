@@ -0,0 +1,80 @@
+/**
+ * @file Matriz4.h
+ * @brief Declaração da classe Matriz4, uma matriz 4x4 no formato usado pelo OpenGL.
+ */
+#ifndef MATRIZ4_H
+#define MATRIZ4_H
+
+#include "Vetor3D.h"
+
+/**
+ * @class Matriz4
+ * @brief Matriz 4x4 de floats armazenada por colunas (column-major), como em glLoadMatrixf.
+ *
+ * O elemento da linha i e coluna j fica em m[4 * j + i]. As funções de construção reproduzem as
+ * matrizes de gluPerspective, glOrtho e gluLookAt.
+ */
+class Matriz4 {
+public:
+  float m[16]; /**< @brief Elementos da matriz (por colunas). */
+
+  /**
+   * @brief Construtor padrão. Inicializa com a identidade.
+   */
+  Matriz4();
+
+  /**
+   * @brief Acesso ao elemento da linha i e coluna j.
+   */
+  float &operator()( int i, int j ) { return m[4 * j + i]; }
+  float  operator()( int i, int j ) const { return m[4 * j + i]; }
+
+  /**
+   * @brief Produto de matrizes (this * b).
+   */
+  Matriz4 operator*( const Matriz4 &b ) const;
+
+  /**
+   * @brief Retorna a inversa da matriz (a identidade se ela for singular).
+   */
+  Matriz4 inverse() const;
+
+  /**
+   * @brief Transforma um ponto (w = 1), dividindo pelo w resultante.
+   */
+  Vetor3D transformPoint( Vetor3D p ) const;
+
+  /**
+   * @brief Transforma um vetor homogêneo de 4 componentes.
+   * @param res Resultado (4 floats).
+   * @param v Vetor de entrada (4 floats).
+   */
+  void transform( float res[4], const float v[4] ) const;
+
+  /**
+   * @brief Matriz equivalente a gluPerspective.
+   * @param fovy Abertura vertical em graus.
+   */
+  static Matriz4 perspective( float fovy, float aspect, float zNear, float zFar );
+
+  /**
+   * @brief Matriz equivalente a glOrtho.
+   */
+  static Matriz4
+    ortho( float left, float right, float bottom, float top, float zNear, float zFar );
+
+  /**
+   * @brief Matriz equivalente a gluLookAt.
+   * @param e Posição do olho.
+   * @param c Ponto observado.
+   * @param u Vetor "up".
+   */
+  static Matriz4 lookAt( Vetor3D e, Vetor3D c, Vetor3D u );
+
+  /**
+   * @brief Matriz de translação.
+   */
+  static Matriz4 translation( float x, float y, float z );
+};
+
+#endif  // MATRIZ4_H
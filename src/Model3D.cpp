@@ -1,6 +1,13 @@
 #include "Model3D.h"
 
+#include "GLState.h"
+#include "GpuTimer.h"
+#include "Trace.h"
+#include "gui.h"
+
+#include <algorithm>
 #include <cstdio>
+#include <thread>
 
 // Aplica materiais do modelo ao OpenGL
 void Model3D::applyMaterial( const aiMaterial *material ) {
@@ -8,15 +15,15 @@ void Model3D::applyMaterial( const aiMaterial *material ) {
   float     shininess = 1.0;
 
   if ( AI_SUCCESS == aiGetMaterialColor( material, AI_MATKEY_COLOR_DIFFUSE, &diffuse ) )
-    glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, (float *)&diffuse );
+    GLState::material( GL_FRONT_AND_BACK, GL_DIFFUSE, (float *)&diffuse );
   if ( AI_SUCCESS == aiGetMaterialColor( material, AI_MATKEY_COLOR_SPECULAR, &specular ) )
-    glMaterialfv( GL_FRONT_AND_BACK, GL_SPECULAR, (float *)&specular );
+    GLState::material( GL_FRONT_AND_BACK, GL_SPECULAR, (float *)&specular );
   if ( AI_SUCCESS == aiGetMaterialColor( material, AI_MATKEY_COLOR_AMBIENT, &ambient ) )
-    glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, (float *)&ambient );
+    GLState::material( GL_FRONT_AND_BACK, GL_AMBIENT, (float *)&ambient );
   if ( AI_SUCCESS == aiGetMaterialColor( material, AI_MATKEY_COLOR_EMISSIVE, &emissive ) )
-    glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, (float *)&emissive );
+    GLState::material( GL_FRONT_AND_BACK, GL_EMISSION, (float *)&emissive );
   if ( AI_SUCCESS == aiGetMaterialFloat( material, AI_MATKEY_SHININESS, &shininess ) )
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, shininess );
+    GLState::material( GL_FRONT_AND_BACK, GL_SHININESS, shininess );
 }
 
 // Desenha os vértices de um mesh
@@ -66,6 +73,7 @@ void Model3D::drawNode( const aiNode *node, bool useOriginalColors ) {
 
 // Construtor
 Model3D::Model3D( const char *filepath ) {
+  QXGL_TRACE_ZONE( "Model3D::load" );
   scene =
     importer.ReadFile( filepath,
                        aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals |
@@ -86,15 +94,177 @@ Model3D::Model3D( const char *filepath ) {
       printf( "Erro ao carregar o modelo: %s\n", importer.GetErrorString() );
     }
   }
+
+  // caixa envolvente (os vertices ja vem pre-transformados, aiProcess_PreTransformVertices)
+  if ( scene ) {
+    boundsMin = Vetor3D( 1e30, 1e30, 1e30 );
+    boundsMax = Vetor3D( -1e30, -1e30, -1e30 );
+    for ( unsigned int i = 0; i < scene->mNumMeshes; i++ ) {
+      const aiMesh *mesh = scene->mMeshes[i];
+      for ( unsigned int j = 0; j < mesh->mNumVertices; j++ ) {
+        const aiVector3D &v = mesh->mVertices[j];
+        boundsMin.x         = fmin( boundsMin.x, v.x );
+        boundsMin.y         = fmin( boundsMin.y, v.y );
+        boundsMin.z         = fmin( boundsMin.z, v.z );
+        boundsMax.x         = fmax( boundsMax.x, v.x );
+        boundsMax.y         = fmax( boundsMax.y, v.y );
+        boundsMax.z         = fmax( boundsMax.z, v.z );
+      }
+    }
+  }
 }
 
 // Método para desenhar o modelo
 void Model3D::draw( bool useOriginalColors ) {
+  GpuTimer::Scope gpuScope( "Model3D::draw" );
+  QXGL_TRACE_ZONE( "Model3D::draw" );
   if ( scene ) {
+    if ( GUI::lightSelection )
+      GUI::selectLights( boundsMin, boundsMax );
     drawNode( scene->mRootNode, useOriginalColors );
+    if ( GUI::lightSelection )
+      GUI::restoreLights();
   }
 }
 
+bool Model3D::getBounds( Vetor3D &min, Vetor3D &max ) const {
+  if ( !scene )
+    return false;
+  min = boundsMin;
+  max = boundsMax;
+  return true;
+}
+
+// triangulos das malhas no formato da BVH (9 floats cada); faces com menos de 3 indices (pontos
+// e linhas) ficam de fora
+static void
+  trianglesDaMalha( const aiMesh *mesh, std::vector<float> &tris, std::vector<unsigned> &faces ) {
+  tris.clear();
+  faces.clear();
+  for ( unsigned int i = 0; i < mesh->mNumFaces; i++ ) {
+    const aiFace &face = mesh->mFaces[i];
+    if ( face.mNumIndices != 3 )
+      continue;
+    for ( unsigned int j = 0; j < 3; j++ ) {
+      const aiVector3D &v = mesh->mVertices[face.mIndices[j]];
+      tris.push_back( v.x );
+      tris.push_back( v.y );
+      tris.push_back( v.z );
+    }
+    faces.push_back( i );
+  }
+}
+
+void Model3D::constroiBVHs( const char *cachePath ) {
+  if ( !scene )
+    return;
+  QXGL_TRACE_ZONE( "Model3D::buildBVH" );
+  bvhs.resize( scene->mNumMeshes );
+  bvhFaces.resize( scene->mNumMeshes );
+
+  FILE *cache = cachePath ? fopen( cachePath, "rb" ) : nullptr;
+  bool  lido  = cache != nullptr;
+  if ( cache ) {
+    unsigned int nMeshes = 0;
+    lido = fread( &nMeshes, sizeof( nMeshes ), 1, cache ) == 1 && nMeshes == scene->mNumMeshes;
+  }
+
+  std::vector<float> tris;
+  for ( unsigned int i = 0; i < scene->mNumMeshes; i++ ) {
+    trianglesDaMalha( scene->mMeshes[i], tris, bvhFaces[i] );
+    lido = lido && bvhs[i].load( cache, tris );
+    if ( !lido )
+      bvhs[i].build( tris );
+  }
+  if ( cache )
+    fclose( cache );
+  if ( lido || !cachePath )
+    return;
+
+  cache = fopen( cachePath, "wb" );
+  if ( !cache ) {
+    printf( "Model3D: nao foi possivel gravar o cache da BVH em %s\n", cachePath );
+    return;
+  }
+  unsigned int nMeshes = scene->mNumMeshes;
+  bool         ok      = fwrite( &nMeshes, sizeof( nMeshes ), 1, cache ) == 1;
+  for ( unsigned int i = 0; ok && i < nMeshes; i++ )
+    ok = bvhs[i].save( cache );
+  fclose( cache );
+  if ( !ok )
+    remove( cachePath );
+}
+
+void Model3D::buildBVH( const char *cachePath ) {
+  std::call_once( bvhOnce, [&] { constroiBVHs( cachePath ); } );
+}
+
+bool Model3D::raycast( const Ray &ray, RayHit &hit ) {
+  buildBVH();
+  hit.mesh = -1;
+  hit.face = -1;
+  hit.t    = 1e30f;
+
+  float    t, u = 0.0f, v = 0.0f, tu, tv;
+  uint32_t tri = 0;
+  for ( size_t i = 0; i < bvhs.size(); i++ ) {
+    if ( bvhs[i].intersect( ray, hit.t, t, tri, tu, tv ) ) {
+      hit.t    = t;
+      hit.mesh = (int)i;
+      hit.face = (int)bvhFaces[i][tri];
+      u        = tu;
+      v        = tv;
+    }
+  }
+  if ( hit.mesh < 0 )
+    return false;
+
+  const aiMesh *mesh = scene->mMeshes[hit.mesh];
+  const aiFace &face = mesh->mFaces[hit.face];
+  hit.point          = ray.pointAt( hit.t );
+  const aiVector3D *vs = mesh->HasNormals() ? mesh->mNormals : mesh->mVertices;
+  Vetor3D           p[3];
+  for ( int j = 0; j < 3; j++ )
+    p[j].setVetor3D( vs[face.mIndices[j]].x, vs[face.mIndices[j]].y, vs[face.mIndices[j]].z );
+  if ( mesh->HasNormals() )
+    hit.normal = p[0] * ( 1.0f - u - v ) + p[1] * u + p[2] * v;
+  else
+    hit.normal = ( p[1] - p[0] ) ^ ( p[2] - p[0] );
+  hit.normal.normaliza();
+  return true;
+}
+
+void Model3D::raycast( const std::vector<Ray> &rays, std::vector<RayHit> &hits, int nThreads ) {
+  QXGL_TRACE_ZONE( "Model3D::raycastBatch" );
+  buildBVH();  // antes das threads, para nao serializar a construcao
+  hits.resize( rays.size() );
+  if ( nThreads <= 0 )
+    nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+  nThreads = (int)std::min<size_t>( nThreads, ( rays.size() + 63 ) / 64 );  // >= 64 raios cada
+  if ( nThreads <= 1 ) {
+    for ( size_t i = 0; i < rays.size(); i++ )
+      raycast( rays[i], hits[i] );
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  size_t                   porThread = ( rays.size() + nThreads - 1 ) / nThreads;
+  for ( int k = 0; k < nThreads; k++ ) {
+    size_t inicio = k * porThread, fim = std::min( rays.size(), inicio + porThread );
+    threads.emplace_back( [&, inicio, fim] {
+      QXGL_TRACE_ZONE( "Model3D::raycastBatch" );
+      for ( size_t i = inicio; i < fim; i++ )
+        raycast( rays[i], hits[i] );
+    } );
+  }
+  for ( std::thread &t : threads )
+    t.join();
+}
+
+bool Model3D::pick( Camera *cam, float x, float y, RayHit &hit ) {
+  return raycast( cam->screenRay( x, y ), hit );
+}
+
 // #include "Model3D.h"
 // //---------------------------------------------------------------------------
 // void Model3D::processNode(aiNode *node, const aiScene *scene) {
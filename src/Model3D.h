@@ -12,6 +12,26 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include "BVH.h"
+#include "Camera.h"
+#include "GLInstrument.h"
+#include "Vetor3D.h"
+
+#include <mutex>
+#include <vector>
+
+/**
+ * @struct RayHit
+ * @brief Resultado de um raio lançado contra um Model3D (Model3D::raycast).
+ */
+struct RayHit {
+  float   t;      /**< @brief Distância ao longo do raio. */
+  Vetor3D point;  /**< @brief Ponto de acerto. */
+  Vetor3D normal; /**< @brief Normal no ponto (interpolada se a malha tiver normais). */
+  int     mesh;   /**< @brief Índice da malha em `aiScene::mMeshes`, ou -1 se não acertou. */
+  int     face;   /**< @brief Índice da face na malha. */
+};
+
 /**
  * @class Model3D
  * @brief Responsável por carregar e renderizar um modelo 3D a partir de um arquivo.
@@ -22,6 +42,14 @@ private:
                            contém todos os dados do modelo. */
   Assimp::Importer
     importer; /**< @brief Objeto do Assimp que gerencia o processo de importação do arquivo. */
+  Vetor3D boundsMin; /**< @brief Canto mínimo da caixa envolvente do modelo. */
+  Vetor3D boundsMax; /**< @brief Canto máximo da caixa envolvente do modelo. */
+
+  std::vector<BVH>                   bvhs;      // uma por malha
+  std::vector<std::vector<unsigned>> bvhFaces;  // triangulo da BVH -> face da malha
+  std::once_flag                     bvhOnce;
+
+  void constroiBVHs( const char *cachePath );
 
   /**
    * @brief Aplica as propriedades de um material (cores, brilho) ao estado atual do OpenGL.
@@ -80,6 +108,44 @@ public:
    * definidos no estado do OpenGL.
    */
   void draw( bool useOriginalColors = true );
+
+  /**
+   * @brief Caixa envolvente alinhada aos eixos do modelo, no seu espaço local (para
+   * Frustum::testAABB e AABBSet).
+   * @return `false` se o modelo não foi carregado.
+   */
+  bool getBounds( Vetor3D &min, Vetor3D &max ) const;
+
+  /**
+   * @brief Constrói as BVHs das malhas (uma vez; chamadas seguintes não fazem nada).
+   *
+   * @details Se não for chamada, a construção acontece no primeiro raycast. Com `cachePath`, as
+   * árvores são lidas desse arquivo quando ele corresponde às malhas carregadas; senão são
+   * construídas e gravadas nele.
+   */
+  void buildBVH( const char *cachePath = nullptr );
+
+  /**
+   * @brief Lança um raio contra os triângulos do modelo, sem usar a GPU.
+   * @param ray Raio no espaço local do modelo (o mesmo de getBounds). Se o modelo é desenhado sob
+   * uma transformação, leve o raio para o espaço do modelo com a inversa dela.
+   * @param hit Recebe o acerto mais próximo.
+   * @return `false` se o raio não acerta o modelo (`hit.mesh` fica -1).
+   */
+  bool raycast( const Ray &ray, RayHit &hit );
+
+  /**
+   * @brief Lança vários raios, divididos entre threads.
+   * @param hits Recebe um resultado por raio.
+   * @param nThreads Quantidade de threads (0 usa o número de núcleos).
+   */
+  void raycast( const std::vector<Ray> &rays, std::vector<RayHit> &hits, int nThreads = 0 );
+
+  /**
+   * @brief Raycast pelo pixel (x, y) da janela com o raio de Camera::screenRay, para um modelo
+   * desenhado sem transformação.
+   */
+  bool pick( Camera *cam, float x, float y, RayHit &hit );
 };
 
 #endif  // MODEL3D_H
@@ -1,5 +1,7 @@
 #include "OpenTextures.h"
 
+#include "Trace.h"
+
 //---------------------------------------------------------------------------
 /*
 struct my_error_mgr
@@ -44,6 +46,7 @@ ILuint OpenTextures::LoadImage( const char *filename ) {
 
 //---------------------------------------------------------------------------
 void OpenTextures::loadTexture( const char *filename, int wrap ) {
+  QXGL_TRACE_ZONE( "OT::loadTexture" );
   //*
   /* load the file picture with DevIL */
   ILuint image = LoadImage( filename );
@@ -93,6 +96,7 @@ void OpenTextures::loadTexture( const char *filename, int wrap ) {
 
 //---------------------------------------------------------------------------
 void OpenTextures::loadTextureRAW( const char *filename, int wrap ) {
+  QXGL_TRACE_ZONE( "OT::loadTextureRAW" );
   //*
   // carrega a imagem
   int   width, height;
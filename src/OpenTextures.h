@@ -22,6 +22,8 @@
 
 #include <IL/il.h>
 
+#include "GLInstrument.h"
+
 /**
  * @class OpenTextures
  * @brief Um conjunto de ferramentas estáticas para carregar texturas em OpenGL.
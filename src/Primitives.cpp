@@ -0,0 +1,326 @@
+#include "Primitives.h"
+
+#include "GLInstrument.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const int SLICES_LOD[Primitives::NUM_LODS] = { 8, 16, 32, 64, 128 };
+
+// intervalo de vertices desenhado com uma chamada
+struct Parte {
+  GLenum  mode;
+  GLint   first;
+  GLsizei count;
+};
+
+static std::vector<Parte> partes[Primitives::NUM_SHAPES][Primitives::NUM_LODS];
+static GLuint             vbo     = 0;
+static GLUquadric        *quadGLU = nullptr;  // troncos de cone que a biblioteca nao cobre
+
+//---------------------------------------------------------------------------
+// geracao das malhas (formato GL_T2F_N3F_V3F)
+
+struct Gerador {
+  std::vector<float>  dados;
+  std::vector<Parte> *destino = nullptr;
+
+  // escala, rotacao (3x3, por linhas) e deslocamento aplicados aos vertices (usados pelos eixos)
+  float escala[3] = { 1, 1, 1 };
+  float rot[9]    = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+  float desloc[3] = { 0, 0, 0 };
+
+  GLint nVertices() const { return (GLint)( dados.size() / 8 ); }
+
+  void reinicia() {
+    Gerador padrao;
+    std::copy( padrao.escala, padrao.escala + 3, escala );
+    std::copy( padrao.rot, padrao.rot + 9, rot );
+    std::copy( padrao.desloc, padrao.desloc + 3, desloc );
+  }
+
+  void vertice( float s, float t, float nx, float ny, float nz, float x, float y, float z ) {
+    // a normal usa a inversa da escala (inversa transposta)
+    float p[3] = { x * escala[0], y * escala[1], z * escala[2] };
+    float n[3] = { nx / escala[0], ny / escala[1], nz / escala[2] };
+    float len  = sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    float v[8] = { s, t, 0, 0, 0, 0, 0, 0 };
+    for ( int k = 0; k < 3; k++ ) {
+      v[2 + k] = ( rot[3 * k] * n[0] + rot[3 * k + 1] * n[1] + rot[3 * k + 2] * n[2] ) / len;
+      v[5 + k] = rot[3 * k] * p[0] + rot[3 * k + 1] * p[1] + rot[3 * k + 2] * p[2] + desloc[k];
+    }
+    dados.insert( dados.end(), v, v + 8 );
+  }
+
+  void abreParte( GLenum mode ) { destino->push_back( { mode, nVertices(), 0 } ); }
+
+  void fechaParte() { destino->back().count = nVertices() - destino->back().first; }
+};
+
+static void geraEsfera( Gerador &g, int slices, int stacks ) {
+  g.abreParte( GL_TRIANGLES );
+  auto v = [&]( int i, int j ) {
+    float phi = M_PI * i / stacks, theta = 2.0 * M_PI * j / slices;
+    float nx = sin( theta ) * sin( phi ), ny = cos( theta ) * sin( phi ), nz = cos( phi );
+    g.vertice( (float)j / slices, 1.0f - (float)i / stacks, nx, ny, nz, nx, ny, nz );
+  };
+  for ( int i = 0; i < stacks; i++ ) {
+    for ( int j = 0; j < slices; j++ ) {
+      v( i, j );
+      v( i, j + 1 );
+      v( i + 1, j );
+      v( i, j + 1 );
+      v( i + 1, j + 1 );
+      v( i + 1, j );
+    }
+  }
+  g.fechaParte();
+}
+
+// disco de raio r em z, com normal +Z (sinal 1) ou -Z (sinal -1)
+static void geraDisco( Gerador &g, int slices, float r, float z, float sinal ) {
+  g.abreParte( GL_TRIANGLES );
+  auto v = [&]( int j ) {
+    float theta = 2.0 * M_PI * j / slices, x = sin( theta ), y = cos( theta );
+    g.vertice( 0.5f + 0.5f * x, 0.5f + 0.5f * y, 0, 0, sinal, r * x, r * y, z );
+  };
+  for ( int j = 0; j < slices; j++ ) {
+    g.vertice( 0.5f, 0.5f, 0, 0, sinal, 0, 0, z );
+    v( sinal > 0 ? j + 1 : j );
+    v( sinal > 0 ? j : j + 1 );
+  }
+  g.fechaParte();
+}
+
+// lateral de z = 0 (raio base) a z = 1 (raio top), com as normais da gluCylinder
+static void geraLateral( Gerador &g, int slices, int stacks, float base, float top ) {
+  g.abreParte( GL_TRIANGLES );
+  float inclinacao = base - top, norma = sqrt( 1.0f + inclinacao * inclinacao );
+  auto  v          = [&]( int i, int j ) {
+    float z = (float)i / stacks, r = base + ( top - base ) * z, theta = 2.0 * M_PI * j / slices;
+    float x = sin( theta ), y = cos( theta );
+    g.vertice( (float)j / slices, z, x / norma, y / norma, inclinacao / norma, r * x, r * y, z );
+  };
+  for ( int i = 0; i < stacks; i++ ) {
+    for ( int j = 0; j < slices; j++ ) {
+      v( i, j );
+      v( i + 1, j );
+      v( i, j + 1 );
+      v( i, j + 1 );
+      v( i + 1, j );
+      v( i + 1, j + 1 );
+    }
+  }
+  g.fechaParte();
+}
+
+static void geraCaixa( Gerador &g ) {
+  // mesmas faces, normais e coordenadas de textura de Desenha::drawBox
+  static const float faces[6][4][3] = {
+    { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } },
+    { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } },
+    { { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 }, { 0, 0, 1 } },
+    { { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 }, { 0, 0, 0 } },
+    { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+    { { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 }, { 0, 0, 0 } },
+  };
+  static const float normais[6][3] = { { 0, 0, -1 }, { 1, 0, 0 },  { 0, 0, 1 },
+                                       { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+  static const float tex[4][2]     = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+  g.abreParte( GL_QUADS );
+  for ( int f = 0; f < 6; f++ )
+    for ( int k = 0; k < 4; k++ )
+      g.vertice( tex[k][0],
+                 tex[k][1],
+                 normais[f][0],
+                 normais[f][1],
+                 normais[f][2],
+                 faces[f][k][0] - 0.5f,
+                 faces[f][k][1] - 0.5f,
+                 faces[f][k][2] - 0.5f );
+  g.fechaParte();
+}
+
+// eixos de Desenha::drawEixos com tamanho 1: linha e cone (raio 0.1, altura 0.2) na ponta
+static void geraEixos( Gerador &g, int slices ) {
+  // rotacoes de drawEixos: X = glRotated(90, 0,1,0), Y = glRotated(90, -1,0,0), Z = identidade
+  static const float rotacoes[3][9] = {
+    { 0, 0, 1, 0, 1, 0, -1, 0, 0 },
+    { 1, 0, 0, 0, 0, 1, 0, -1, 0 },
+    { 1, 0, 0, 0, 1, 0, 0, 0, 1 },
+  };
+  for ( int k = 0; k < 3; k++ ) {
+    float ponta[3] = { 0, 0, 0 };
+    ponta[k]       = 1.0f;
+    g.abreParte( GL_LINES );
+    g.vertice( 0, 0, 0, 0, 1, 0, 0, 0 );
+    g.vertice( 1, 0, 0, 0, 1, ponta[0], ponta[1], ponta[2] );
+    g.fechaParte();
+
+    std::copy( rotacoes[k], rotacoes[k] + 9, g.rot );
+    std::copy( ponta, ponta + 3, g.desloc );
+    g.escala[0] = g.escala[1] = 0.1f;
+    g.escala[2]               = 0.2f;
+    geraLateral( g, slices, 1, 1.0f, 0.0f );
+    geraDisco( g, slices, 1.0f, 0.0f, -1.0f );
+    g.reinicia();
+  }
+}
+
+static bool preparaBuffer() {
+  if ( vbo != 0 )
+    return true;
+  QXGL_TRACE_ZONE( "Primitives::build" );
+  Gerador g;
+  for ( int lod = 0; lod < Primitives::NUM_LODS; lod++ ) {
+    int slices  = SLICES_LOD[lod];
+    int stacks  = slices / 2;
+    int stacksC = slices / 8 > 1 ? slices / 8 : 1;  // a lateral do cilindro so varia ao longo de Z
+    for ( int s = 0; s < Primitives::NUM_SHAPES; s++ )
+      partes[s][lod].clear();
+
+    g.destino = &partes[Primitives::SPHERE][lod];
+    geraEsfera( g, slices, stacks );
+
+    g.destino = &partes[Primitives::CYLINDER][lod];
+    geraLateral( g, slices, stacksC, 1.0f, 1.0f );
+    geraDisco( g, slices, 1.0f, 1.0f, 1.0f );
+    geraDisco( g, slices, 1.0f, 0.0f, -1.0f );
+
+    g.destino = &partes[Primitives::CONE][lod];
+    geraLateral( g, slices, stacksC, 1.0f, 0.0f );
+    geraDisco( g, slices, 1.0f, 0.0f, -1.0f );
+
+    g.destino = &partes[Primitives::DISK][lod];
+    geraDisco( g, slices, 1.0f, 0.0f, 1.0f );
+
+    g.destino = &partes[Primitives::BOX][lod];
+    geraCaixa( g );
+
+    g.destino = &partes[Primitives::AXES][lod];
+    geraEixos( g, slices );
+  }
+
+  glGenBuffers( 1, &vbo );
+  glBindBuffer( GL_ARRAY_BUFFER, vbo );
+  glBufferData(
+    GL_ARRAY_BUFFER, g.dados.size() * sizeof( float ), g.dados.data(), GL_STATIC_DRAW );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  return vbo != 0;
+}
+
+static GLUquadric *quadricInterno() {
+  if ( !quadGLU ) {
+    quadGLU = gluNewQuadric();
+    gluQuadricNormals( quadGLU, GLU_SMOOTH );
+    gluQuadricTexture( quadGLU, GL_TRUE );
+  }
+  return quadGLU;
+}
+
+//---------------------------------------------------------------------------
+
+int Primitives::lodFor( int slices ) {
+  for ( int lod = 0; lod < NUM_LODS; lod++ )
+    if ( SLICES_LOD[lod] >= slices )
+      return lod;
+  return NUM_LODS - 1;
+}
+
+int Primitives::slicesOf( int lod ) {
+  return SLICES_LOD[lod < 0 ? 0 : ( lod >= NUM_LODS ? NUM_LODS - 1 : lod )];
+}
+
+void Primitives::draw( Shape shape, int lod, int firstPart, int nParts ) {
+  if ( !preparaBuffer() )
+    return;
+  lod                          = lod < 0 ? 0 : ( lod >= NUM_LODS ? NUM_LODS - 1 : lod );
+  const std::vector<Parte> &ps = partes[shape][lod];
+  int                       fim = nParts < 0 ? (int)ps.size() : firstPart + nParts;
+  fim                           = fim > (int)ps.size() ? (int)ps.size() : fim;
+
+  // GL_ARRAY_BUFFER_BINDING faz parte de GL_CLIENT_VERTEX_ARRAY_BIT: o pop devolve o buffer que
+  // estava ligado antes, sem consulta ao driver
+  glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+  glBindBuffer( GL_ARRAY_BUFFER, vbo );
+  glInterleavedArrays( GL_T2F_N3F_V3F, 0, (void *)0 );
+  for ( int p = firstPart; p < fim; p++ )
+    glDrawArrays( ps[p].mode, ps[p].first, ps[p].count );
+  glPopClientAttrib();
+}
+
+void Primitives::sphere( float radius, int slices ) {
+  glPushMatrix();
+  glScalef( radius, radius, radius );
+  draw( SPHERE, lodFor( slices ) );
+  glPopMatrix();
+}
+
+void Primitives::cylinder(
+  float base, float top, float height, int slices, bool closed, GLUquadric *quad, int stacks ) {
+  if ( base <= 0.0f || height == 0.0f || ( top != base && top != 0.0f ) ) {
+    // tronco de cone: sem malha unitaria equivalente
+    quad   = quad ? quad : quadricInterno();
+    stacks = stacks > 0 ? stacks : ( slices / 8 > 1 ? slices / 8 : 1 );
+    glPushMatrix();
+    gluCylinder( quad, base, top, height, slices, stacks );
+    if ( closed ) {
+      glTranslated( 0, 0, height );
+      gluDisk( quad, 0, top, slices, 1 );
+      glRotated( 180, 0, 1, 0 );
+      glTranslated( 0, 0, height );
+      gluDisk( quad, 0, base, slices, 1 );
+    }
+    glPopMatrix();
+    return;
+  }
+  glPushMatrix();
+  glScalef( base, base, height );
+  draw( top == base ? CYLINDER : CONE, lodFor( slices ), 0, closed ? -1 : 1 );
+  glPopMatrix();
+}
+
+void Primitives::disk( float radius, int slices ) {
+  glPushMatrix();
+  glScalef( radius, radius, radius );
+  draw( DISK, lodFor( slices ) );
+  glPopMatrix();
+}
+
+void Primitives::capsule(
+  float base, float top, float height, int slices, GLUquadric *quad, int stacks ) {
+  cylinder( base, top, height, slices, false, quad, stacks );
+  sphere( base, slices );
+  glPushMatrix();
+  glTranslatef( 0, 0, height );
+  sphere( top, slices );
+  glPopMatrix();
+}
+
+void Primitives::box( float xmin, float ymin, float zmin, float xmax, float ymax, float zmax ) {
+  // escala minima: com GL_NORMALIZE as normais continuam corretas em caixas achatadas
+  const float minimo = 1e-6f;
+  float       sx = xmax - xmin, sy = ymax - ymin, sz = zmax - zmin;
+  glPushMatrix();
+  glTranslatef( 0.5f * ( xmin + xmax ), 0.5f * ( ymin + ymax ), 0.5f * ( zmin + zmax ) );
+  glScalef( fabsf( sx ) < minimo ? minimo : sx,
+            fabsf( sy ) < minimo ? minimo : sy,
+            fabsf( sz ) < minimo ? minimo : sz );
+  draw( BOX, 0 );
+  glPopMatrix();
+}
+
+void Primitives::axis( int axis, int lod ) {
+  draw( AXES, lod, 3 * axis, 3 );
+}
+
+void Primitives::release() {
+  if ( vbo != 0 )
+    glDeleteBuffers( 1, &vbo );
+  vbo = 0;
+  if ( quadGLU )
+    gluDeleteQuadric( quadGLU );
+  quadGLU = nullptr;
+}
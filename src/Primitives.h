@@ -0,0 +1,109 @@
+/**
+ * @file Primitives.h
+ * @brief Declaração da classe Primitives, uma biblioteca de malhas unitárias na GPU.
+ *
+ * @details Esfera, cilindro, cone, disco, caixa e eixos são gerados uma única vez, em vários
+ * níveis de detalhe (LODs), em um vertex buffer compartilhado. Cada desenho só aplica uma
+ * translação e uma escala à malha unitária, sem criar quadrics nem reenviar vértices. As malhas
+ * seguem as convenções da GLU (eixo Z, normais suaves e coordenadas de textura), então substituem
+ * gluSphere, gluCylinder e gluDisk diretamente. Requer o contexto OpenGL criado (o buffer é
+ * criado no primeiro desenho) e GL_NORMALIZE ligado quando a escala não é uniforme.
+ */
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <GL/gl.h>
+#include <GL/glu.h>
+
+/**
+ * @class Primitives
+ * @brief Malhas unitárias pré-construídas, em vários níveis de detalhe.
+ */
+class Primitives {
+public:
+  /**
+   * @enum Shape
+   * @brief Malhas disponíveis (todas no espaço unitário).
+   */
+  enum Shape {
+    SPHERE,   /**< @brief Esfera de raio 1 centrada na origem, polos no eixo Z. */
+    CYLINDER, /**< @brief Cilindro de raio 1 de z = 0 a z = 1, com as tampas como partes 1 e 2. */
+    CONE,     /**< @brief Cone de raio 1 em z = 0 e ponta em z = 1, com a base como parte 1. */
+    DISK,     /**< @brief Disco de raio 1 no plano z = 0, com normal +Z. */
+    BOX,      /**< @brief Caixa de -0.5 a 0.5, com as faces e texturas de Desenha::drawBox. */
+    AXES,     /**< @brief Eixos X, Y e Z de tamanho 1 com cones nas pontas (3 partes por eixo:
+                 linha, cone e base do cone). */
+    NUM_SHAPES
+  };
+
+  static const int NUM_LODS = 5; /**< @brief Níveis de detalhe: 8, 16, 32, 64 e 128 fatias. */
+
+  /**
+   * @brief Menor LOD com pelo menos `slices` fatias (ou o maior LOD).
+   */
+  static int lodFor( int slices );
+
+  /**
+   * @brief Quantidade de fatias de um LOD.
+   */
+  static int slicesOf( int lod );
+
+  /**
+   * @brief Desenha partes de uma malha unitária com a matriz atual.
+   * @param firstPart Primeira parte desenhada.
+   * @param nParts Quantidade de partes (-1 desenha até a última).
+   */
+  static void draw( Shape shape, int lod, int firstPart = 0, int nParts = -1 );
+
+  /**
+   * @brief Esfera (substitui gluSphere).
+   */
+  static void sphere( float radius, int slices );
+
+  /**
+   * @brief Cilindro ao longo de +Z (substitui gluCylinder e Desenha::gluClosedCylinder).
+   * @details Cilindros (base == top) e cones (top == 0) usam as malhas da biblioteca; os demais
+   * troncos de cone são desenhados pela GLU com um quadric interno, reaproveitado.
+   * @param closed Se verdadeiro, desenha também os discos das extremidades.
+   * @param stacks Pilhas ao longo de Z, usadas só nos troncos de cone desenhados pela GLU (0: um
+   * oitavo das fatias). Nas malhas da biblioteca o raio varia linearmente em Z e as pilhas são as
+   * do LOD.
+   */
+  static void cylinder( float       base,
+                        float       top,
+                        float       height,
+                        int         slices,
+                        bool        closed,
+                        GLUquadric *quad   = 0,
+                        int         stacks = 0 );
+
+  /**
+   * @brief Disco no plano z = 0 (substitui gluDisk com raio interno 0).
+   */
+  static void disk( float radius, int slices );
+
+  /**
+   * @brief Cápsula: cilindro ao longo de +Z com uma esfera em cada ponta.
+   * @details As esferas usam as pilhas do LOD (metade das fatias); `stacks` vale como em
+   * cylinder.
+   */
+  static void capsule(
+    float base, float top, float height, int slices, GLUquadric *quad = 0, int stacks = 0 );
+
+  /**
+   * @brief Caixa com os cantos dados (substitui Desenha::drawBox).
+   */
+  static void box( float xmin, float ymin, float zmin, float xmax, float ymax, float zmax );
+
+  /**
+   * @brief Desenha um dos eixos (0 = X, 1 = Y, 2 = Z) da malha AXES, com a matriz atual.
+   */
+  static void axis( int axis, int lod );
+
+  /**
+   * @brief Libera o buffer (é recriado no próximo desenho).
+   */
+  static void release();
+};
+
+#endif  // PRIMITIVES_H
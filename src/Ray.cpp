@@ -0,0 +1,97 @@
+#include "Ray.h"
+
+//---------------------------------------------------------------------------
+Ray::Ray() : origin( 0, 0, 0 ), direction( 0, 0, -1 ) {}
+
+//---------------------------------------------------------------------------
+Ray::Ray( Vetor3D origin, Vetor3D direction ) : origin( origin ), direction( direction ) {
+  this->direction.normaliza();
+}
+
+//---------------------------------------------------------------------------
+Vetor3D Ray::pointAt( float t ) const {
+  return Vetor3D(
+    origin.x + direction.x * t, origin.y + direction.y * t, origin.z + direction.z * t );
+}
+
+//---------------------------------------------------------------------------
+bool Ray::intersectSphere( Vetor3D center, float radius, float &t ) const {
+  float ox = origin.x - center.x, oy = origin.y - center.y, oz = origin.z - center.z;
+  float b  = ox * direction.x + oy * direction.y + oz * direction.z;
+  float c  = ox * ox + oy * oy + oz * oz - radius * radius;
+  if ( c > 0.0f && b > 0.0f )
+    return false;  // fora e apontando para longe
+  float disc = b * b - c;
+  if ( disc < 0.0f )
+    return false;
+  t = -b - sqrt( disc );
+  if ( t < 0.0f )
+    t = 0.0f;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool Ray::intersectAABB( Vetor3D min, Vetor3D max, float &t ) const {
+  float tmin = 0.0f, tmax = 1e30f;
+  float o[3]  = { origin.x, origin.y, origin.z };
+  float d[3]  = { direction.x, direction.y, direction.z };
+  float mn[3] = { min.x, min.y, min.z };
+  float mx[3] = { max.x, max.y, max.z };
+  for ( int i = 0; i < 3; i++ ) {
+    if ( fabs( d[i] ) < 1e-12f ) {
+      if ( o[i] < mn[i] || o[i] > mx[i] )
+        return false;
+      continue;
+    }
+    float inv = 1.0f / d[i];
+    float t0  = ( mn[i] - o[i] ) * inv;
+    float t1  = ( mx[i] - o[i] ) * inv;
+    if ( t0 > t1 ) {
+      float tmp = t0;
+      t0        = t1;
+      t1        = tmp;
+    }
+    tmin = t0 > tmin ? t0 : tmin;
+    tmax = t1 < tmax ? t1 : tmax;
+    if ( tmin > tmax )
+      return false;
+  }
+  t = tmin;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool Ray::intersectPlane( const float plane[4], float &t ) const {
+  float den = plane[0] * direction.x + plane[1] * direction.y + plane[2] * direction.z;
+  if ( fabs( den ) < 1e-12f )
+    return false;
+  float num = plane[0] * origin.x + plane[1] * origin.y + plane[2] * origin.z + plane[3];
+  t         = -num / den;
+  return t >= 0.0f;
+}
+
+//---------------------------------------------------------------------------
+bool Ray::intersectTriangle( Vetor3D a, Vetor3D b, Vetor3D c, float &t ) const {
+  Vetor3D e1  = b - a;
+  Vetor3D e2  = c - a;
+  Vetor3D d   = direction;
+  Vetor3D s   = origin;
+  Vetor3D p   = d ^ e2;
+  float   det = e1 * p;
+  if ( fabs( det ) < 1e-12f )
+    return false;
+  float inv = 1.0f / det;
+  s         = s - a;
+  float u   = ( s * p ) * inv;
+  if ( u < 0.0f || u > 1.0f )
+    return false;
+  Vetor3D q = s ^ e1;
+  float   v = ( d * q ) * inv;
+  if ( v < 0.0f || u + v > 1.0f )
+    return false;
+  float tt = ( e2 * q ) * inv;
+  if ( tt < 0.0f )
+    return false;
+  t = tt;
+  return true;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file Ray.h
+ * @brief Declaração da classe Ray, um raio no espaço do mundo (usado no picking pela CPU).
+ */
+#ifndef RAY_H
+#define RAY_H
+
+#include "Vetor3D.h"
+
+/**
+ * @class Ray
+ * @brief Raio com origem e direção unitária, com testes de interseção básicos.
+ *
+ * Os testes retornam a distância t ao longo do raio (ponto = origin + direction * t) do primeiro
+ * ponto de interseção com t >= 0.
+ */
+class Ray {
+public:
+  Vetor3D origin;    /**< @brief Origem do raio. */
+  Vetor3D direction; /**< @brief Direção do raio (unitária). */
+
+  Ray();
+
+  /**
+   * @brief Construtor. A direção é normalizada.
+   */
+  Ray( Vetor3D origin, Vetor3D direction );
+
+  /**
+   * @brief Ponto do raio na distância t.
+   */
+  Vetor3D pointAt( float t ) const;
+
+  /**
+   * @brief Interseção com uma esfera.
+   * @param t Recebe a distância até o ponto de entrada (ou 0 se a origem estiver dentro).
+   */
+  bool intersectSphere( Vetor3D center, float radius, float &t ) const;
+
+  /**
+   * @brief Interseção com uma caixa alinhada aos eixos (método dos slabs).
+   * @param t Recebe a distância até o ponto de entrada (ou 0 se a origem estiver dentro).
+   */
+  bool intersectAABB( Vetor3D min, Vetor3D max, float &t ) const;
+
+  /**
+   * @brief Interseção com o plano ax + by + cz + d = 0.
+   */
+  bool intersectPlane( const float plane[4], float &t ) const;
+
+  /**
+   * @brief Interseção com um triângulo (Möller-Trumbore), dos dois lados.
+   */
+  bool intersectTriangle( Vetor3D a, Vetor3D b, Vetor3D c, float &t ) const;
+};
+
+#endif  // RAY_H
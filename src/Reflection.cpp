@@ -0,0 +1,252 @@
+#include "Reflection.h"
+
+#include "Batch.h"
+#include "GLInstrument.h"
+#include "GLState.h"
+#include "GpuTimer.h"
+#include "Matriz4.h"
+#include "Trace.h"
+#include "extra.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+float Reflection::resolutionScale = 0.5;
+
+struct Espelho {
+  float                 plano[4];  // (a, b, c, d) com normal unitaria
+  std::function<void()> desenho;
+  GLuint                fbo = 0, cor = 0, prof = 0;
+  int                   w = 0, h = 0;  // tamanho da textura
+  unsigned              versao = 0;    // versaoCena do ultimo desenho (0: refazer)
+  float                 viewProj[16];  // camera do ultimo desenho
+};
+
+static std::vector<Espelho> espelhos;
+static unsigned             versaoCena    = 1;
+static int                  desenhados    = 0;
+static bool                 texturaLigada = false;
+
+static void definePlano( Espelho &e, Vetor3D ponto, Vetor3D normal ) {
+  normal.normaliza();
+  e.plano[0] = normal.x;
+  e.plano[1] = normal.y;
+  e.plano[2] = normal.z;
+  e.plano[3] = -( normal * ponto );
+  e.versao   = 0;
+}
+
+// reflexao no plano: I - 2 n n^T, com translacao -2 d n
+static Matriz4 matrizReflexao( const float p[4] ) {
+  Matriz4 r;
+  for ( int i = 0; i < 3; i++ ) {
+    for ( int j = 0; j < 3; j++ )
+      r( i, j ) = ( i == j ? 1.0f : 0.0f ) - 2.0f * p[i] * p[j];
+    r( i, 3 ) = -2.0f * p[3] * p[i];
+  }
+  return r;
+}
+
+// troca o plano near da projecao pelo plano c (espaco do olho, com o olho do lado negativo),
+// mantendo o far o mais proximo possivel do original (E. Lengyel, "Oblique View Frustum Depth
+// Projection and Clipping")
+static Matriz4 nearObliquo( Matriz4 proj, const float c[4] ) {
+  // canto do frustum oposto ao plano, em coordenadas de clip
+  float   canto[4] = { c[0] > 0.0f ? 1.0f : -1.0f, c[1] > 0.0f ? 1.0f : -1.0f, 1.0f, 1.0f };
+  float   q[4];
+  Matriz4 inv = proj.inverse();
+  inv.transform( q, canto );
+  float escala = 2.0f / ( c[0] * q[0] + c[1] * q[1] + c[2] * q[2] + c[3] * q[3] );
+  // terceira linha = c escalado - quarta linha
+  for ( int j = 0; j < 4; j++ )
+    proj( 2, j ) = c[j] * escala - proj( 3, j );
+  return proj;
+}
+
+static void criaFramebuffer( Espelho &e, int w, int h ) {
+  if ( e.fbo == 0 ) {
+    glGenFramebuffers( 1, &e.fbo );
+    glGenTextures( 1, &e.cor );
+    glGenRenderbuffers( 1, &e.prof );
+  }
+  GLState::bindTexture( GL_TEXTURE_2D, e.cor );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  GLState::bindTexture( GL_TEXTURE_2D, 0 );
+  glBindRenderbuffer( GL_RENDERBUFFER, e.prof );
+  glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h );
+  glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+  glBindFramebuffer( GL_FRAMEBUFFER, e.fbo );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, e.cor, 0 );
+  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, e.prof );
+  if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+    printf( "Reflection: framebuffer incompleto\n" );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  e.w      = w;
+  e.h      = h;
+  e.versao = 0;
+}
+
+// desenha a cena refletida na textura do espelho
+static void desenhaReflexo( Espelho &e, const Matriz4 &view, const Matriz4 &proj ) {
+  GpuTimer::Scope gpuScope( "Reflection::desenhaReflexo" );
+  QXGL_TRACE_ZONE( "Reflection::desenhaReflexo" );
+
+  Matriz4 viewReflexo = view * matrizReflexao( e.plano );
+  // plano do espelho no espaco do olho refletido: (V R)^-T p
+  Matriz4 inv = viewReflexo.inverse();
+  float   c[4];
+  for ( int j = 0; j < 4; j++ )
+    c[j] = inv( 0, j ) * e.plano[0] + inv( 1, j ) * e.plano[1] + inv( 2, j ) * e.plano[2] +
+           inv( 3, j ) * e.plano[3];
+  Matriz4 projReflexo = nearObliquo( proj, c );
+
+  // o Batch adiaria os desenhos da cena para depois da troca de framebuffer
+  Batch::flush();
+  bool batch     = Batch::enabled;
+  Batch::enabled = false;
+
+  glPushAttrib( GL_VIEWPORT_BIT | GL_POLYGON_BIT | GL_ENABLE_BIT );
+  glMatrixMode( GL_PROJECTION );
+  glPushMatrix();
+  glLoadMatrixf( projReflexo.m );
+  glMatrixMode( GL_MODELVIEW );
+  glPushMatrix();
+  glLoadMatrixf( viewReflexo.m );
+
+  glBindFramebuffer( GL_FRAMEBUFFER, e.fbo );
+  glViewport( 0, 0, e.w, e.h );
+  glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+  glFrontFace( GL_CW );  // a reflexao inverte o sentido dos poligonos
+  e.desenho();
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+  glMatrixMode( GL_PROJECTION );
+  glPopMatrix();
+  glMatrixMode( GL_MODELVIEW );
+  glPopMatrix();
+  glPopAttrib();
+  Batch::enabled = batch;
+  // a cena pode ter alterado estados pelo GLState dentro do glPushAttrib
+  GLState::invalidate();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();
+#endif
+  desenhados++;
+}
+
+int Reflection::addMirror( const Vetor3D               &point,
+                           const Vetor3D               &normal,
+                           const std::function<void()> &drawScene ) {
+  Espelho e;
+  definePlano( e, point, normal );
+  e.desenho = drawScene;
+  espelhos.push_back( e );
+  return (int)espelhos.size() - 1;
+}
+
+void Reflection::setMirror( int i, const Vetor3D &point, const Vetor3D &normal ) {
+  definePlano( espelhos[i], point, normal );
+}
+
+void Reflection::clearMirrors() {
+  for ( Espelho &e : espelhos ) {
+    if ( e.fbo != 0 ) {
+      glDeleteFramebuffers( 1, &e.fbo );
+      glDeleteTextures( 1, &e.cor );
+      glDeleteRenderbuffers( 1, &e.prof );
+    }
+  }
+  espelhos.clear();
+  GLState::invalidate();  // a textura apagada pode estar ligada na copia do GLState
+}
+
+void Reflection::invalidate() {
+  versaoCena++;
+}
+
+bool Reflection::begin( int i ) {
+  if ( glutGUI::picking || i < 0 || i >= (int)espelhos.size() )
+    return false;
+  Espelho &e = espelhos[i];
+
+  // camera atras do espelho: nao ha o que refletir
+  const Matriz4 &invView = glutGUI::cam->inverseView();
+  float          lado    = e.plano[0] * invView( 0, 3 ) + e.plano[1] * invView( 1, 3 ) +
+                 e.plano[2] * invView( 2, 3 ) + e.plano[3];
+  if ( lado <= 0.0f )
+    return false;
+
+  GLint vp[4];
+  glGetIntegerv( GL_VIEWPORT, vp );
+  float escala = resolutionScale > 0.0f ? std::min( resolutionScale, 1.0f ) : 1.0f;
+  int   w = std::max( (int)( vp[2] * escala ), 1 ), h = std::max( (int)( vp[3] * escala ), 1 );
+  if ( w != e.w || h != e.h )
+    criaFramebuffer( e, w, h );
+
+  const Matriz4 &view = glutGUI::cam->view(), &proj = glutGUI::cam->projection();
+  const Matriz4 &vpCam = glutGUI::cam->viewProjection();
+  if ( e.versao != versaoCena || memcmp( e.viewProj, vpCam.m, sizeof( e.viewProj ) ) != 0 ) {
+    desenhaReflexo( e, view, proj );
+    memcpy( e.viewProj, vpCam.m, sizeof( e.viewProj ) );
+    e.versao = versaoCena;
+  }
+
+  // coordenadas de textura = posicao na tela: s, t, r, q = olho; matriz de textura = escala e
+  // translacao para [0, 1] * projecao
+  Batch::flush();  // o que veio antes nao usa a textura do espelho
+  glPushAttrib( GL_TEXTURE_BIT | GL_ENABLE_BIT | GL_TRANSFORM_BIT );
+  glBindTexture( GL_TEXTURE_2D, e.cor );
+  glEnable( GL_TEXTURE_2D );
+  glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+  glMatrixMode( GL_MODELVIEW );
+  glPushMatrix();
+  glLoadIdentity();  // planos GL_EYE_PLANE dados direto no espaco do olho
+  const GLenum coords[4]  = { GL_S, GL_T, GL_R, GL_Q };
+  const GLenum geracao[4] = { GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T, GL_TEXTURE_GEN_R,
+                              GL_TEXTURE_GEN_Q };
+  for ( int k = 0; k < 4; k++ ) {
+    GLfloat plano[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    plano[k]         = 1.0f;
+    glTexGeni( coords[k], GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR );
+    glTexGenfv( coords[k], GL_EYE_PLANE, plano );
+    glEnable( geracao[k] );
+  }
+  glPopMatrix();
+  Matriz4 escalaTextura;
+  escalaTextura( 0, 0 ) = escalaTextura( 1, 1 ) = escalaTextura( 2, 2 ) = 0.5f;
+  escalaTextura( 0, 3 ) = escalaTextura( 1, 3 ) = escalaTextura( 2, 3 ) = 0.5f;
+  glMatrixMode( GL_TEXTURE );
+  glPushMatrix();
+  glLoadMatrixf( ( escalaTextura * proj ).m );
+  glMatrixMode( GL_MODELVIEW );
+  GLState::invalidate();  // textura alterada direto: o Batch precisa ler o estado do OpenGL
+  texturaLigada = true;
+  return true;
+}
+
+void Reflection::end() {
+  if ( !texturaLigada )
+    return;
+  Batch::flush();  // a superficie do espelho ainda precisa da textura
+  glMatrixMode( GL_TEXTURE );
+  glPopMatrix();
+  glMatrixMode( GL_MODELVIEW );
+  glPopAttrib();
+  GLState::invalidate();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();
+#endif
+  texturaLigada = false;
+}
+
+int Reflection::renderCount() {
+  return desenhados;
+}
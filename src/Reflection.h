@@ -0,0 +1,77 @@
+/**
+ * @file Reflection.h
+ * @brief Declaração da classe Reflection, reflexos planos renderizados em textura.
+ *
+ * @details Com GUI::glReflectPlaneXYf (e XZf, YZf) o espelho é feito desenhando a cena inteira
+ * refletida, na resolução da janela, a cada frame. Aqui cada espelho tem uma textura fora da
+ * tela, com uma fração da resolução da viewport (resolutionScale), onde a cena é desenhada com a
+ * câmera refletida no plano. O plano do espelho vira o plano near da projeção (near oblíquo), de
+ * modo que o que está atrás do espelho não aparece no reflexo, sem gastar um plano de recorte.
+ *
+ * A textura é reaproveitada enquanto a câmera, o plano, a viewport e a cena não mudarem; chame
+ * invalidate() quando algo na cena se mover.
+ */
+#ifndef REFLECTION_H
+#define REFLECTION_H
+
+#include "Vetor3D.h"
+
+#include <functional>
+
+/**
+ * @class Reflection
+ * @brief Espelhos planos com textura em cache.
+ */
+class Reflection {
+public:
+  /**
+   * @brief Fração da viewport usada na textura de cada espelho (padrão 0.5).
+   */
+  static float resolutionScale;
+
+  /**
+   * @brief Registra um espelho.
+   * @param point Um ponto do plano (espaço do mundo).
+   * @param normal Normal do plano, apontando para o lado refletido (onde a câmera fica).
+   * @param drawScene Desenha a cena no espaço do mundo (sem o próprio espelho). É chamada com a
+   * modelview da câmera refletida já carregada; luzes definidas dentro dela também são refletidas.
+   * @return Índice do espelho.
+   */
+  static int addMirror( const Vetor3D               &point,
+                        const Vetor3D               &normal,
+                        const std::function<void()> &drawScene );
+
+  /**
+   * @brief Move o plano do espelho i (o reflexo é refeito).
+   */
+  static void setMirror( int i, const Vetor3D &point, const Vetor3D &normal );
+
+  static void clearMirrors();
+
+  /**
+   * @brief Força todos os reflexos a serem refeitos (a cena mudou).
+   */
+  static void invalidate();
+
+  /**
+   * @brief Refaz o reflexo do espelho i, se necessário, e liga a sua textura para desenhar a
+   * superfície do espelho.
+   * @details As coordenadas de textura são geradas (GL_EYE_LINEAR) a partir da posição na tela,
+   * então basta desenhar a superfície do espelho com a câmera normal; a textura é combinada com
+   * a cor do material (GL_MODULATE), como as demais texturas.
+   * @return Falso durante o picking ou se a câmera estiver atrás do espelho (nada é ligado).
+   */
+  static bool begin( int i );
+
+  /**
+   * @brief Desliga a textura e a geração de coordenadas do begin().
+   */
+  static void end();
+
+  /**
+   * @brief Quantidade de reflexos redesenhados desde o início (para avaliar o cache).
+   */
+  static int renderCount();
+};
+
+#endif  // REFLECTION_H
@@ -0,0 +1,121 @@
+#include "Shader.h"
+
+#include "GLState.h"
+
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+// posicao de qxglLuzAtiva em cada programa (os nomes so sao reaproveitados por Shader::program)
+static std::unordered_map<GLuint, GLint> locaisLuzAtiva;
+
+static GLuint compila( GLenum tipo, const char *fonte, const char *nome ) {
+  GLuint s = glCreateShader( tipo );
+  glShaderSource( s, 1, &fonte, NULL );
+  glCompileShader( s );
+  GLint ok = 0;
+  glGetShaderiv( s, GL_COMPILE_STATUS, &ok );
+  if ( !ok ) {
+    GLint tam = 0;
+    glGetShaderiv( s, GL_INFO_LOG_LENGTH, &tam );
+    std::vector<char> log( tam > 1 ? tam : 1, '\0' );
+    glGetShaderInfoLog( s, (GLsizei)log.size(), NULL, log.data() );
+    printf( "%s: falha ao compilar o %s shader\n%s\n",
+            nome,
+            tipo == GL_VERTEX_SHADER ? "vertex" : "fragment",
+            log.data() );
+    glDeleteShader( s );
+    return 0;
+  }
+  return s;
+}
+
+GLuint Shader::program( const char                                             *vertex,
+                        const char                                             *fragment,
+                        const char                                             *name,
+                        std::initializer_list<std::pair<GLuint, const char *>> attributes ) {
+  GLuint vs = vertex ? compila( GL_VERTEX_SHADER, vertex, name ) : 0;
+  GLuint fs = fragment ? compila( GL_FRAGMENT_SHADER, fragment, name ) : 0;
+  if ( ( vertex && vs == 0 ) || ( fragment && fs == 0 ) ) {
+    glDeleteShader( vs );
+    glDeleteShader( fs );
+    return 0;
+  }
+
+  GLuint p = glCreateProgram();
+  if ( vs )
+    glAttachShader( p, vs );
+  if ( fs )
+    glAttachShader( p, fs );
+  for ( const auto &a : attributes )
+    glBindAttribLocation( p, a.first, a.second );
+  glLinkProgram( p );
+  // os shaders so sao liberados de fato junto com o programa
+  glDeleteShader( vs );
+  glDeleteShader( fs );
+
+  GLint ok = 0;
+  glGetProgramiv( p, GL_LINK_STATUS, &ok );
+  if ( !ok ) {
+    GLint tam = 0;
+    glGetProgramiv( p, GL_INFO_LOG_LENGTH, &tam );
+    std::vector<char> log( tam > 1 ? tam : 1, '\0' );
+    glGetProgramInfoLog( p, (GLsizei)log.size(), NULL, log.data() );
+    printf( "%s: falha ao ligar o programa\n%s\n", name, log.data() );
+    glDeleteProgram( p );
+    return 0;
+  }
+  locaisLuzAtiva.erase( p );  // o nome pode ser de um programa apagado
+  return p;
+}
+
+// mesma equacao do pipeline fixo (especificacao do OpenGL 2.1, secao 2.14.1), por vertice
+const char *Shader::fixedLighting =
+  "uniform float qxglLuzAtiva[8];\n"
+  "vec4 qxglLuz( int i, vec3 p, vec3 n, vec4 ambient, vec4 diffuse, vec4 specular,\n"
+  "              float shininess, float shadow ) {\n"
+  "  vec3  L;\n"
+  "  float att = 1.0;\n"
+  "  if ( gl_LightSource[i].position.w == 0.0 ) {\n"
+  "    L = normalize( gl_LightSource[i].position.xyz );\n"
+  "  } else {\n"
+  "    vec3  d    = gl_LightSource[i].position.xyz - p;\n"
+  "    float dist = length( d );\n"
+  "    L          = d / dist;\n"
+  "    att        = 1.0 / ( gl_LightSource[i].constantAttenuation +\n"
+  "                         gl_LightSource[i].linearAttenuation * dist +\n"
+  "                         gl_LightSource[i].quadraticAttenuation * dist * dist );\n"
+  "    if ( gl_LightSource[i].spotCutoff <= 90.0 ) {\n"
+  "      float c = dot( -L, normalize( gl_LightSource[i].spotDirection ) );\n"
+  "      att *= c < gl_LightSource[i].spotCosCutoff ? 0.0\n"
+  "                                                 : pow( c, gl_LightSource[i].spotExponent );\n"
+  "    }\n"
+  "  }\n"
+  "  float nl = max( dot( n, L ), 0.0 );\n"
+  "  vec4  c  = nl * diffuse * gl_LightSource[i].diffuse;\n"
+  "  if ( nl > 0.0 ) {\n"
+  "    vec3 h = normalize( L + vec3( 0.0, 0.0, 1.0 ) );\n"
+  "    c += pow( max( dot( n, h ), 0.0 ), shininess ) * specular * gl_LightSource[i].specular;\n"
+  "  }\n"
+  "  return att * ( ambient * gl_LightSource[i].ambient + shadow * c );\n"
+  "}\n"
+  "vec4 qxglIluminacao( vec3 p, vec3 n, vec4 ambient, vec4 diffuse, vec4 specular,\n"
+  "                     float shininess, vec4 emission ) {\n"
+  "  vec4 cor = emission + ambient * gl_LightModel.ambient;\n"
+  "  for ( int i = 0; i < 8; i++ ) {\n"
+  "    if ( qxglLuzAtiva[i] != 0.0 )\n"
+  "      cor += qxglLuz( i, p, n, ambient, diffuse, specular, shininess, 1.0 );\n"
+  "  }\n"
+  "  cor.a = diffuse.a;\n"
+  "  return clamp( cor, 0.0, 1.0 );\n"
+  "}\n";
+
+void Shader::setFixedLighting( GLuint program ) {
+  auto it = locaisLuzAtiva.find( program );
+  if ( it == locaisLuzAtiva.end() )
+    it = locaisLuzAtiva.emplace( program, glGetUniformLocation( program, "qxglLuzAtiva" ) ).first;
+  GLfloat ativa[8];
+  for ( int i = 0; i < 8; i++ )
+    ativa[i] = GLState::isEnabled( GL_LIGHT0 + i ) ? 1.0f : 0.0f;
+  glUniform1fv( it->second, 8, ativa );
+}
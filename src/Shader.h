@@ -0,0 +1,58 @@
+/**
+ * @file Shader.h
+ * @brief Declaração da classe Shader, com utilitários para criar programas GLSL.
+ *
+ * @details Os programas da biblioteca usam GLSL 1.20 com as variáveis embutidas do pipeline fixo
+ * (gl_ModelViewMatrix, gl_LightSource, gl_FrontMaterial...), então leem as matrizes, as luzes e os
+ * materiais definidos normalmente com glLightfv, glMaterialfv e GUI::setColor. O trecho
+ * fixedLighting reproduz a iluminação fixa por vértice (até 8 luzes, com atenuação e spot) para
+ * que o que é desenhado por shaders combine com o resto da cena.
+ */
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <GL/gl.h>
+#include <initializer_list>
+#include <utility>
+
+/**
+ * @class Shader
+ * @brief Compilação de programas GLSL e emulação da iluminação fixa.
+ */
+class Shader {
+public:
+  /**
+   * @brief Compila e liga um programa.
+   * @param vertex Código do vertex shader (nulo para usar o pipeline fixo nos vértices).
+   * @param fragment Código do fragment shader (nulo para usar o pipeline fixo nos fragmentos).
+   * @param name Nome usado nas mensagens de erro.
+   * @param attributes Pares (posição, nome) de atributos com posição fixa.
+   * @return O programa, ou 0 se a compilação ou a ligação falhar (o log é impresso).
+   */
+  static GLuint program( const char                                             *vertex,
+                         const char                                             *fragment,
+                         const char                                             *name,
+                         std::initializer_list<std::pair<GLuint, const char *>> attributes = {} );
+
+  /**
+   * @brief Código GLSL (1.20) da função de iluminação fixa, para concatenar antes do main.
+   * @details Declara o uniform `qxglLuzAtiva[8]` e a função
+   * `vec4 qxglIluminacao( vec3 p, vec3 n, vec4 ambient, vec4 diffuse, vec4 specular,
+   * float shininess, vec4 emission )`, com `p` e `n` (unitária) no espaço do olho. Usa o modelo
+   * de iluminação padrão do OpenGL (observador no infinito, uma face). A contribuição de uma
+   * luz sozinha é `vec4 qxglLuz( int i, vec3 p, vec3 n, vec4 ambient, vec4 diffuse,
+   * vec4 specular, float shininess, float shadow )`, com as parcelas difusa e especular
+   * multiplicadas por `shadow` (1 = iluminado).
+   */
+  static const char *fixedLighting;
+
+  /**
+   * @brief Atualiza `qxglLuzAtiva` com as luzes GL_LIGHT0..7 ligadas (o programa deve estar em
+   * uso).
+   * @details As luzes ligadas vêm de GLState::isEnabled, e a posição do uniform é guardada por
+   * programa na primeira chamada.
+   */
+  static void setFixedLighting( GLuint program );
+};
+
+#endif  // SHADER_H
@@ -0,0 +1,424 @@
+#include "ShadowMap.h"
+
+#include "Batch.h"
+#include "Culling.h"
+#include "GLInstrument.h"
+#include "GLState.h"
+#include "GpuTimer.h"
+#include "Matriz4.h"
+#include "Shader.h"
+#include "Trace.h"
+#include "extra.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int   ShadowMap::resolution   = 1024;
+int   ShadowMap::pcfRadius    = 1;
+float ShadowMap::slopeBias    = 2.0;
+float ShadowMap::constantBias = 4.0;
+
+static const int NUM_LUZES     = 8;
+static const int UNIDADE_MAPAS = 1;  // a unidade 0 fica com a textura 2D dos objetos
+
+// casters: caixas (para o recorte) e funcoes de desenho
+static AABBSet                            caixas;
+static std::vector<std::function<void()>> desenhos;
+static unsigned                           versaoCasters = 1;  // muda a cada alteracao
+static std::vector<int>                   visiveis;
+
+// um mapa por luz que projeta sombra, cada um em uma camada da textura
+struct MapaLuz {
+  bool     sombra    = false;  // castShadows
+  int      camada    = -1;
+  unsigned versao    = 0;   // versaoCasters do ultimo desenho (0: nunca desenhado)
+  int      desenhada = -1;  // camada do ultimo desenho
+  float    luz[8];          // posicao, direcao (mundo) e corte da luz do ultimo desenho
+  Matriz4  viewProj;        // mundo -> clip da luz, do ultimo desenho
+};
+static MapaLuz mapas[NUM_LUZES];
+
+static GLuint textura = 0, fbo = 0;
+static int    resTextura = 0, camadasTextura = 0;
+static GLuint programa = 0;
+static bool   falhou   = false;
+static GLint  uMatrizes = -1, uCamadas = -1, uRaio = -1, uTexel = -1;
+static GLint  uUsaTextura = -1, uCorMaterial = -1, uIluminacao = -1;
+static int    refeitos    = 0;
+
+static const char *FONTE_VERTICE = "#version 130\n"
+                                   "out vec3 posOlho;\n"
+                                   "out vec3 normalOlho;\n"
+                                   "out vec4 corVertice;\n"
+                                   "void main() {\n"
+                                   "  vec4 pe        = gl_ModelViewMatrix * gl_Vertex;\n"
+                                   "  posOlho        = pe.xyz;\n"
+                                   "  normalOlho     = gl_NormalMatrix * gl_Normal;\n"
+                                   "  corVertice     = gl_Color;\n"
+                                   "  gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+                                   "  gl_ClipVertex  = pe;\n"
+                                   "  gl_Position    = gl_ProjectionMatrix * pe;\n"
+                                   "}\n";
+
+// iluminacao fixa por pixel, com as parcelas difusa e especular de cada luz multiplicadas pela
+// fracao iluminada (PCF: media de comparacoes de profundidade em volta do ponto)
+static const char *FONTE_FRAGMENTO =
+  "uniform sampler2DArrayShadow mapas;\n"
+  "uniform sampler2D            textura;\n"
+  "uniform mat4  matrizSombra[8];\n"  // olho -> coordenadas do mapa em [0, 1]
+  "uniform float camadaSombra[8];\n"  // camada do mapa da luz, -1 sem sombra
+  "uniform int   raioPCF;\n"
+  "uniform float texel;\n"
+  "uniform bool  usaTextura;\n"
+  "uniform bool  corMaterial;\n"
+  "uniform bool  iluminacao;\n"
+  "in vec3 posOlho;\n"
+  "in vec3 normalOlho;\n"
+  "in vec4 corVertice;\n"
+  "float iluminado( int i ) {\n"
+  "  if ( camadaSombra[i] < 0.0 )\n"
+  "    return 1.0;\n"
+  "  vec4 s = matrizSombra[i] * vec4( posOlho, 1.0 );\n"
+  "  if ( s.w <= 0.0 )\n"
+  "    return 1.0;\n"
+  "  s.xyz /= s.w;\n"
+  "  if ( any( lessThan( s.xyz, vec3( 0.0 ) ) ) || any( greaterThan( s.xyz, vec3( 1.0 ) ) ) )\n"
+  "    return 1.0;\n"  // fora do volume da luz
+  "  float soma = 0.0;\n"
+  "  for ( int y = -raioPCF; y <= raioPCF; y++ )\n"
+  "    for ( int x = -raioPCF; x <= raioPCF; x++ )\n"
+  "      soma += texture( mapas, vec4( s.xy + vec2( x, y ) * texel, camadaSombra[i], s.z ) );\n"
+  "  float lado = float( 2 * raioPCF + 1 );\n"
+  "  return soma / ( lado * lado );\n"
+  "}\n"
+  "void main() {\n"
+  "  if ( !iluminacao ) {\n"  // GL_LIGHTING desligado: so a cor do vertice, como no pipeline fixo
+  "    gl_FragColor = corVertice;\n"
+  "    if ( usaTextura )\n"
+  "      gl_FragColor *= texture2D( textura, gl_TexCoord[0].st );\n"
+  "    return;\n"
+  "  }\n"
+  "  vec3 n    = normalize( normalOlho );\n"
+  "  vec4 amb  = corMaterial ? corVertice : gl_FrontMaterial.ambient;\n"
+  "  vec4 dif  = corMaterial ? corVertice : gl_FrontMaterial.diffuse;\n"
+  "  vec4 spec = gl_FrontMaterial.specular;\n"
+  "  vec4 cor  = gl_FrontMaterial.emission + amb * gl_LightModel.ambient;\n"
+  "  for ( int i = 0; i < 8; i++ ) {\n"
+  "    if ( qxglLuzAtiva[i] != 0.0 )\n"
+  "      cor += qxglLuz( i, posOlho, n, amb, dif, spec, gl_FrontMaterial.shininess,\n"
+  "                      iluminado( i ) );\n"
+  "  }\n"
+  "  cor   = clamp( cor, 0.0, 1.0 );\n"
+  "  cor.a = dif.a;\n"
+  "  if ( usaTextura )\n"
+  "    cor *= texture2D( textura, gl_TexCoord[0].st );\n"
+  "  gl_FragColor = cor;\n"
+  "}\n";
+
+static bool criaPrograma() {
+  std::string fragmento =
+    std::string( "#version 130\n" ) + Shader::fixedLighting + FONTE_FRAGMENTO;
+  programa = Shader::program( FONTE_VERTICE, fragmento.c_str(), "ShadowMap" );
+  if ( programa == 0 )
+    return false;
+  GLState::useProgram( programa );
+  glUniform1i( glGetUniformLocation( programa, "mapas" ), UNIDADE_MAPAS );
+  glUniform1i( glGetUniformLocation( programa, "textura" ), 0 );
+  GLState::useProgram( 0 );
+  uMatrizes    = glGetUniformLocation( programa, "matrizSombra" );
+  uCamadas     = glGetUniformLocation( programa, "camadaSombra" );
+  uRaio        = glGetUniformLocation( programa, "raioPCF" );
+  uTexel       = glGetUniformLocation( programa, "texel" );
+  uUsaTextura  = glGetUniformLocation( programa, "usaTextura" );
+  uCorMaterial = glGetUniformLocation( programa, "corMaterial" );
+  uIluminacao  = glGetUniformLocation( programa, "iluminacao" );
+  glGenFramebuffers( 1, &fbo );
+  glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+  glDrawBuffer( GL_NONE );  // so profundidade
+  glReadBuffer( GL_NONE );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  return true;
+}
+
+// textura de profundidade com uma camada por luz que projeta sombra (refeita se mudar o tamanho)
+static void criaTextura( int res, int camadas ) {
+  if ( textura == 0 )
+    glGenTextures( 1, &textura );
+  GLState::activeTexture( GL_TEXTURE0 + UNIDADE_MAPAS );
+  GLState::bindTexture( GL_TEXTURE_2D_ARRAY, textura );
+  glTexImage3D( GL_TEXTURE_2D_ARRAY,
+                0,
+                GL_DEPTH_COMPONENT24,
+                res,
+                res,
+                camadas,
+                0,
+                GL_DEPTH_COMPONENT,
+                GL_FLOAT,
+                NULL );
+  // GL_LINEAR com comparacao: cada amostra ja e a media de 4 comparacoes
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+  glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+  GLState::activeTexture( GL_TEXTURE0 );
+  resTextura     = res;
+  camadasTextura = camadas;
+  for ( int i = 0; i < NUM_LUZES; i++ )
+    mapas[i].versao = 0;
+}
+
+// caixa que envolve todos os casters
+static void caixaCena( Vetor3D &min, Vetor3D &max ) {
+  min = Vetor3D( HUGE_VAL, HUGE_VAL, HUGE_VAL );
+  max = Vetor3D( -HUGE_VAL, -HUGE_VAL, -HUGE_VAL );
+  for ( int i = 0; i < caixas.size(); i++ ) {
+    min.x = std::min<double>( min.x, caixas.minX[i] );
+    min.y = std::min<double>( min.y, caixas.minY[i] );
+    min.z = std::min<double>( min.z, caixas.minZ[i] );
+    max.x = std::max<double>( max.x, caixas.maxX[i] );
+    max.y = std::max<double>( max.y, caixas.maxY[i] );
+    max.z = std::max<double>( max.z, caixas.maxZ[i] );
+  }
+}
+
+// up que nao seja paralelo a direcao de visao
+static Vetor3D upPara( Vetor3D direcao ) {
+  direcao.normaliza();
+  return fabs( direcao.y ) > 0.99 ? Vetor3D( 1, 0, 0 ) : Vetor3D( 0, 1, 0 );
+}
+
+// posicao (4), direcao (3) no espaco do mundo e corte do spot de GL_LIGHT0 + id, a partir do
+// estado da luz (no espaco do olho)
+static void parametrosLuz( int id, float luz[8] ) {
+  GLfloat pos[4], dir[4], dm[4];
+  glGetLightfv( GL_LIGHT0 + id, GL_POSITION, pos );
+  glGetLightfv( GL_LIGHT0 + id, GL_SPOT_DIRECTION, dir );
+  glGetLightfv( GL_LIGHT0 + id, GL_SPOT_CUTOFF, &luz[7] );
+  dir[3]             = 0.0f;
+  const Matriz4 &inv = glutGUI::cam->inverseView();
+  inv.transform( luz, pos );
+  inv.transform( dm, dir );
+  std::copy( dm, dm + 3, luz + 4 );
+}
+
+// a volta do espaco do olho para o do mundo muda os ultimos bits a cada movimento da camera:
+// a luz so conta como movida acima dessa tolerancia
+static bool mesmaLuz( const float a[8], const float b[8] ) {
+  for ( int k = 0; k < 8; k++ ) {
+    float escala = std::max( { 1.0f, fabsf( a[k] ), fabsf( b[k] ) } );
+    if ( fabsf( a[k] - b[k] ) > 1e-4f * escala )
+      return false;
+  }
+  return true;
+}
+
+// matriz mundo -> clip da luz
+static Matriz4 matrizLuz( const float luz[8], Vetor3D min, Vetor3D max ) {
+  const float *pm = luz, *dm = luz + 4;
+  float        corte = luz[7];
+
+  Vetor3D centro = ( min + max ) * 0.5;
+  float   raio   = std::max<float>( ( max - min ).modulo() * 0.5, 1e-3 );
+  if ( pm[3] == 0.0f ) {
+    // direcional: ortografica envolvendo a caixa dos casters
+    Vetor3D d( pm[0], pm[1], pm[2] );
+    d.normaliza();
+    Vetor3D olho = centro + d * ( 2.0 * raio );
+    return Matriz4::ortho( -raio, raio, -raio, raio, raio * 0.5, raio * 3.5 ) *
+           Matriz4::lookAt( olho, centro, upPara( d ) );
+  }
+
+  Vetor3D p( pm[0] / pm[3], pm[1] / pm[3], pm[2] / pm[3] );
+  Vetor3D ate  = centro - p;
+  float   dist = ate.modulo();
+  Vetor3D alvo;
+  float   abertura;
+  if ( corte <= 90.0f ) {
+    alvo     = p + Vetor3D( dm[0], dm[1], dm[2] );
+    abertura = 2.0f * corte;
+  } else {
+    // sem cube map: cone da luz ate a caixa dos casters
+    alvo     = dist > 1e-4 ? centro : p + Vetor3D( 0, -1, 0 );
+    abertura = dist > raio ? 2.0 * asin( raio / dist ) * 180.0 / M_PI : 150.0f;
+  }
+  abertura    = std::min( abertura, 170.0f );
+  float longe = dist + raio;
+  float perto = std::max( dist - raio, longe * 0.001f );
+  return Matriz4::perspective( abertura, 1.0, perto, longe ) *
+         Matriz4::lookAt( p, alvo, upPara( alvo - p ) );
+}
+
+// desenha os casters no volume de cada luz em 'pendentes' (pares luz, matriz)
+static void desenhaMapas( const std::vector<std::pair<int, Matriz4>> &pendentes ) {
+  GpuTimer::Scope gpuScope( "ShadowMap::desenhaMapas" );
+  QXGL_TRACE_ZONE( "ShadowMap::desenhaMapas" );
+
+  // o Batch adiaria os desenhos dos casters para depois da troca de framebuffer
+  Batch::flush();
+  bool batch     = Batch::enabled;
+  Batch::enabled = false;
+
+  glPushAttrib( GL_VIEWPORT_BIT | GL_ENABLE_BIT | GL_POLYGON_BIT | GL_COLOR_BUFFER_BIT |
+                GL_DEPTH_BUFFER_BIT | GL_LIGHTING_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT );
+  glMatrixMode( GL_PROJECTION );
+  glPushMatrix();
+  glMatrixMode( GL_MODELVIEW );
+  glPushMatrix();
+
+  glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+  glViewport( 0, 0, resTextura, resTextura );
+  glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+  glDepthMask( GL_TRUE );
+  glEnable( GL_DEPTH_TEST );
+  glDisable( GL_LIGHTING );
+  glDisable( GL_TEXTURE_2D );
+  glDisable( GL_BLEND );
+  glDisable( GL_CULL_FACE );  // modelos abertos tambem precisam das faces de tras
+  glEnable( GL_POLYGON_OFFSET_FILL );
+  glPolygonOffset( ShadowMap::slopeBias, ShadowMap::constantBias );
+
+  for ( const auto &p : pendentes ) {
+    MapaLuz &m = mapas[p.first];
+    glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textura, 0, m.camada );
+    glClear( GL_DEPTH_BUFFER_BIT );
+    // tudo na projecao: os casters desenham no espaco do mundo com a modelview identidade
+    glMatrixMode( GL_PROJECTION );
+    glLoadMatrixf( p.second.m );
+    glMatrixMode( GL_MODELVIEW );
+    glLoadIdentity();
+    Culling::cull( Frustum::fromMatrix( p.second ), caixas, visiveis );
+    for ( int i : visiveis )
+      desenhos[i]();
+    m.viewProj  = p.second;
+    m.versao    = versaoCasters;
+    m.desenhada = m.camada;
+  }
+
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  glMatrixMode( GL_PROJECTION );
+  glPopMatrix();
+  glMatrixMode( GL_MODELVIEW );
+  glPopMatrix();
+  glPopAttrib();
+  Batch::enabled = batch;
+  // os casters podem ter alterado estados pelo GLState dentro do glPushAttrib
+  GLState::invalidate();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();
+#endif
+}
+
+int ShadowMap::addCaster( const Vetor3D               &min,
+                          const Vetor3D               &max,
+                          const std::function<void()> &draw ) {
+  desenhos.push_back( draw );
+  versaoCasters++;
+  return caixas.add( min, max );
+}
+
+void ShadowMap::setCaster( int i, const Vetor3D &min, const Vetor3D &max ) {
+  caixas.set( i, min, max );
+  versaoCasters++;
+}
+
+void ShadowMap::clearCasters() {
+  caixas.clear();
+  desenhos.clear();
+  versaoCasters++;
+}
+
+void ShadowMap::castShadows( int id, bool on ) {
+  if ( id >= 0 && id < NUM_LUZES )
+    mapas[id].sombra = on;
+}
+
+void ShadowMap::invalidate() {
+  versaoCasters++;
+}
+
+bool ShadowMap::begin() {
+  Batch::flush();  // o que foi agrupado antes e da iluminacao fixa
+  refeitos = 0;
+  if ( glutGUI::picking || falhou )
+    return false;
+  if ( programa == 0 && !criaPrograma() ) {
+    falhou = true;
+    return false;
+  }
+
+  // camadas: uma por luz ligada que projeta sombra
+  int camadas = 0;
+  for ( int i = 0; i < NUM_LUZES; i++ ) {
+    bool usa        = mapas[i].sombra && GLState::isEnabled( GL_LIGHT0 + i ) && caixas.size() > 0;
+    mapas[i].camada = usa ? camadas++ : -1;
+  }
+  int res = std::max( resolution, 1 );
+  if ( camadas > camadasTextura || res != resTextura )
+    criaTextura( res, std::max( camadas, 1 ) );
+
+  // mapas desatualizados: casters mudaram (a caixa da cena junto) ou a luz se moveu
+  std::vector<std::pair<int, Matriz4>> pendentes;
+  Vetor3D                              min, max;
+  caixaCena( min, max );
+  for ( int i = 0; i < NUM_LUZES; i++ ) {
+    MapaLuz &m = mapas[i];
+    if ( m.camada < 0 )
+      continue;
+    float luz[8];
+    parametrosLuz( i, luz );
+    if ( m.versao == versaoCasters && m.camada == m.desenhada && mesmaLuz( luz, m.luz ) )
+      continue;
+    std::copy( luz, luz + 8, m.luz );
+    pendentes.push_back( { i, matrizLuz( luz, min, max ) } );
+  }
+  if ( !pendentes.empty() )
+    desenhaMapas( pendentes );
+  refeitos = (int)pendentes.size();
+
+  // olho -> [0, 1] do mapa: escala e translacao * clip da luz * inversa da view da camera
+  Matriz4 escala;
+  escala( 0, 0 ) = escala( 1, 1 ) = escala( 2, 2 ) = 0.5f;
+  escala( 0, 3 ) = escala( 1, 3 ) = escala( 2, 3 ) = 0.5f;
+  GLfloat matrizes[NUM_LUZES * 16], camadasLuz[NUM_LUZES];
+  for ( int i = 0; i < NUM_LUZES; i++ ) {
+    Matriz4 s = escala * mapas[i].viewProj * glutGUI::cam->inverseView();
+    memcpy( &matrizes[16 * i], s.m, sizeof( s.m ) );
+    camadasLuz[i] = (GLfloat)mapas[i].camada;
+  }
+
+  GLState::activeTexture( GL_TEXTURE0 + UNIDADE_MAPAS );
+  GLState::bindTexture( GL_TEXTURE_2D_ARRAY, textura );
+  GLState::activeTexture( GL_TEXTURE0 );
+  GLState::useProgram( programa );
+  glUniformMatrix4fv( uMatrizes, NUM_LUZES, GL_FALSE, matrizes );
+  glUniform1fv( uCamadas, NUM_LUZES, camadasLuz );
+  glUniform1i( uRaio, std::max( pcfRadius, 0 ) );
+  glUniform1f( uTexel, 1.0f / resTextura );
+  sync();
+  return true;
+}
+
+void ShadowMap::sync() {
+  Shader::setFixedLighting( programa );
+  glUniform1i( uUsaTextura, GLState::isEnabled( GL_TEXTURE_2D ) );
+  glUniform1i( uCorMaterial, GLState::isEnabled( GL_COLOR_MATERIAL ) );
+  glUniform1i( uIluminacao, GLState::isEnabled( GL_LIGHTING ) );
+}
+
+void ShadowMap::end() {
+  if ( programa == 0 )
+    return;
+  Batch::flush();  // o que foi agrupado entre begin() e end() ainda precisa do programa
+  GLState::useProgram( 0 );
+}
+
+int ShadowMap::renderedMaps() {
+  return refeitos;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file ShadowMap.h
+ * @brief Declaração da classe ShadowMap, sombras por mapas de profundidade.
+ *
+ * @details GUI::shadowMatrix e GUI::shadowMatrixYk achatam os objetos sobre um único plano, e
+ * cada plano que recebe sombra exige desenhar todos os objetos de novo. Com ShadowMap, os objetos
+ * que projetam sombra (casters) são registrados uma vez com a sua caixa envolvente e uma função
+ * de desenho; para cada luz escolhida com castShadows, a cena é desenhada do ponto de vista da
+ * luz em uma textura de profundidade, e tudo o que for desenhado entre begin() e end() (planos,
+ * modelos, os próprios casters) recebe as sombras, com filtragem PCF.
+ *
+ * A projeção da luz segue o tipo dela: ortográfica para luzes direcionais, perspectiva com a
+ * abertura do spot para spots, e perspectiva apontada para a caixa dos casters para as demais
+ * luzes pontuais (sem cube map, a sombra só existe dentro desse cone). Apenas os casters dentro
+ * do volume de visão da luz são desenhados, e o mapa só é refeito quando a luz se move, um caster
+ * muda (setCaster, addCaster, invalidate) ou a resolução muda.
+ */
+#ifndef SHADOWMAP_H
+#define SHADOWMAP_H
+
+#include "Vetor3D.h"
+
+#include <functional>
+
+/**
+ * @class ShadowMap
+ * @brief Mapas de sombra das luzes GL_LIGHT0..7 e programa dos objetos que recebem sombra.
+ */
+class ShadowMap {
+public:
+  static int   resolution;   /**< @brief Largura e altura de cada mapa em texels (padrão 1024). */
+  static int   pcfRadius;    /**< @brief Amostras do PCF: (2r + 1)² em volta do texel (padrão 1). */
+  static float slopeBias;    /**< @brief Fator do glPolygonOffset no mapa (padrão 2). */
+  static float constantBias; /**< @brief Unidades do glPolygonOffset no mapa (padrão 4). */
+
+  /**
+   * @brief Registra um objeto que projeta sombra.
+   * @param min, max Caixa envolvente no espaço do mundo (usada no recorte pelo volume da luz).
+   * @param draw Desenha o objeto no espaço do mundo (com a modelview da luz já carregada).
+   * @return Índice do caster.
+   */
+  static int addCaster( const Vetor3D &min, const Vetor3D &max, const std::function<void()> &draw );
+
+  /**
+   * @brief Atualiza a caixa de um caster que se moveu (os mapas são refeitos).
+   */
+  static void setCaster( int i, const Vetor3D &min, const Vetor3D &max );
+
+  static void clearCasters();
+
+  /**
+   * @brief Escolhe se a luz GL_LIGHT0 + id projeta sombra (nenhuma por padrão).
+   */
+  static void castShadows( int id, bool on = true );
+
+  /**
+   * @brief Força os mapas a serem refeitos (algo mudou sem passar por setCaster).
+   */
+  static void invalidate();
+
+  /**
+   * @brief Refaz os mapas desatualizados e ativa o programa dos objetos que recebem sombra.
+   * @details Chame depois do GUI::setLight das luzes, com a câmera já aplicada (displayInit): a
+   * posição das luzes é lida de GL_POSITION, no espaço do olho. O material corrente (glMaterial,
+   * GUI::setColor), GL_COLOR_MATERIAL, a textura 2D e GL_LIGHTING desligado (só a cor do
+   * vértice) são respeitados, como na iluminação fixa.
+   * @return Falso durante o picking ou se o programa não puder ser criado (desenha sem sombras).
+   */
+  static bool begin();
+
+  /**
+   * @brief Relê as luzes ligadas, GL_LIGHTING, GL_TEXTURE_2D e GL_COLOR_MATERIAL entre begin() e
+   * end().
+   */
+  static void sync();
+
+  /**
+   * @brief Volta ao pipeline fixo.
+   */
+  static void end();
+
+  /**
+   * @brief Quantidade de mapas refeitos no último begin() (0 quando nada mudou).
+   */
+  static int renderedMaps();
+};
+
+#endif  // SHADOWMAP_H
@@ -0,0 +1,95 @@
+#include "Stats.h"
+
+#include <cstdio>
+
+bool  Stats::inFrame       = false;
+long  Stats::frames        = 0;
+float Stats::cpuMs         = 0.0;
+float Stats::intervalMs    = 0.0;
+float Stats::avgIntervalMs = 0.0;
+
+std::chrono::steady_clock::time_point Stats::frameStart   = std::chrono::steady_clock::now();
+std::chrono::steady_clock::time_point Stats::lastFrameEnd = std::chrono::steady_clock::now();
+
+std::map<std::string, Stats::GpuPass> Stats::gpu;
+
+// peso da amostra nova na media movel exponencial
+static const float SUAVIZACAO = 0.1f;
+
+static float msEntre( std::chrono::steady_clock::time_point a,
+                      std::chrono::steady_clock::time_point b ) {
+  return std::chrono::duration<float, std::milli>( b - a ).count();
+}
+
+void Stats::beginFrame() {
+  if ( inFrame )
+    return;  // displayInit chamado mais de uma vez no mesmo frame (varias viewports)
+  inFrame    = true;
+  frameStart = std::chrono::steady_clock::now();
+}
+
+void Stats::endFrame() {
+  auto now = std::chrono::steady_clock::now();
+  if ( inFrame )
+    cpuMs = msEntre( frameStart, now );
+  inFrame = false;
+
+  intervalMs = msEntre( lastFrameEnd, now );
+  if ( frames == 0 )
+    avgIntervalMs = intervalMs;
+  else
+    avgIntervalMs += SUAVIZACAO * ( intervalMs - avgIntervalMs );
+  lastFrameEnd = now;
+  frames++;
+}
+
+long Stats::frame() {
+  return frames;
+}
+
+float Stats::cpuFrameMs() {
+  return cpuMs;
+}
+
+float Stats::frameIntervalMs() {
+  return intervalMs;
+}
+
+float Stats::averageFrameIntervalMs() {
+  return avgIntervalMs;
+}
+
+void Stats::setGpuTime( const std::string &name, float ms, int count ) {
+  GpuPass &p = gpu[name];
+  if ( p.count == 0 && p.average == 0.0f )
+    p.average = ms;
+  else
+    p.average += SUAVIZACAO * ( ms - p.average );
+  p.last  = ms;
+  p.count = count;
+}
+
+float Stats::gpuTime( const std::string &name ) {
+  auto it = gpu.find( name );
+  return it == gpu.end() ? 0.0f : it->second.average;
+}
+
+const std::map<std::string, Stats::GpuPass> &Stats::gpuPasses() {
+  return gpu;
+}
+
+void Stats::print() {
+  printf( "frame %ld: cpu %.3f ms, intervalo %.3f ms (media %.3f ms, %.1f fps)\n",
+          frames,
+          cpuMs,
+          intervalMs,
+          avgIntervalMs,
+          avgIntervalMs > 0.0f ? 1000.0f / avgIntervalMs : 0.0f );
+  for ( const auto &[name, p] : gpu ) {
+    printf( "  gpu %-24s %8.3f ms (media %8.3f ms, x%d)\n",
+            name.c_str(),
+            p.last,
+            p.average,
+            p.count );
+  }
+}
@@ -0,0 +1,99 @@
+/**
+ * @file Stats.h
+ * @brief Declaração da classe Stats, que concentra as estatísticas de desempenho por frame.
+ *
+ * @details Esta classe estática mede o tempo de CPU de cada frame (entre GUI::displayInit e
+ * GUI::displayEnd) e armazena os tempos de GPU por passe de renderização reportados pelo
+ * GpuTimer. Os valores podem ser consultados pela aplicação ou impressos no console.
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <map>
+#include <string>
+
+/**
+ * @class Stats
+ * @brief Estatísticas de desempenho do frame atual e médias suavizadas.
+ */
+class Stats {
+public:
+  /**
+   * @struct GpuPass
+   * @brief Tempo de GPU de um passe de renderização (em milissegundos).
+   */
+  struct GpuPass {
+    float last    = 0.0f; /**< @brief Tempo do último frame medido. */
+    float average = 0.0f; /**< @brief Média móvel exponencial do tempo. */
+    int   count   = 0;    /**< @brief Quantidade de vezes que o passe executou no último frame. */
+  };
+
+  /**
+   * @brief Marca o início do trabalho de CPU do frame. Chamada por GUI::displayInit.
+   * @details Chamadas repetidas dentro do mesmo frame (múltiplas viewports) são ignoradas.
+   */
+  static void beginFrame();
+
+  /**
+   * @brief Marca o fim do frame. Chamada por GUI::displayEnd.
+   */
+  static void endFrame();
+
+  /**
+   * @brief Retorna o número de frames finalizados desde o início da aplicação.
+   */
+  static long frame();
+
+  /**
+   * @brief Tempo de CPU gasto entre displayInit e displayEnd no último frame (ms).
+   */
+  static float cpuFrameMs();
+
+  /**
+   * @brief Intervalo entre os dois últimos displayEnd (ms), incluindo o tempo ocioso.
+   */
+  static float frameIntervalMs();
+
+  /**
+   * @brief Média móvel exponencial do intervalo entre frames (ms).
+   */
+  static float averageFrameIntervalMs();
+
+  /**
+   * @brief Registra o tempo de GPU de um passe para um frame já concluído.
+   * @param name Nome do passe (ex.: "frame", "Model3D::draw").
+   * @param ms Tempo total do passe no frame, em milissegundos.
+   * @param count Quantas vezes o passe foi executado no frame.
+   */
+  static void setGpuTime( const std::string &name, float ms, int count = 1 );
+
+  /**
+   * @brief Retorna a média do tempo de GPU de um passe (ms), ou 0 se ele nunca foi medido.
+   */
+  static float gpuTime( const std::string &name );
+
+  /**
+   * @brief Retorna todos os passes de GPU medidos.
+   */
+  static const std::map<std::string, GpuPass> &gpuPasses();
+
+  /**
+   * @brief Imprime as estatísticas atuais no console.
+   */
+  static void print();
+
+private:
+  static bool  inFrame;
+  static long  frames;
+  static float cpuMs;
+  static float intervalMs;
+  static float avgIntervalMs;
+
+  static std::chrono::steady_clock::time_point frameStart;
+  static std::chrono::steady_clock::time_point lastFrameEnd;
+
+  static std::map<std::string, GpuPass> gpu;
+};
+
+#endif  // STATS_H
@@ -0,0 +1,47 @@
+#include "Tessellation.h"
+
+#include "extra.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool  Tessellation::autoLOD          = false;
+int   Tessellation::minSlices        = 8;
+int   Tessellation::minStacks        = 6;
+float Tessellation::pixelsPerSegment = 4.0;
+
+float Tessellation::projectedRadius( float radius, float cx, float cy, float cz ) {
+  // matrizes e viewport ativas, como no Batch: sub-viewports, picking e as passadas de reflexo e
+  // de sombra tem projecoes diferentes da camera e da janela
+  GLfloat mv[16], p[16];
+  GLint   vp[4];
+  glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+  glGetFloatv( GL_PROJECTION_MATRIX, p );
+  glGetIntegerv( GL_VIEWPORT, vp );
+
+  // centro no espaco do olho e maior escala da modelview
+  float ez     = mv[2] * cx + mv[6] * cy + mv[10] * cz + mv[14];
+  float escala = 0.0f;
+  for ( int c = 0; c < 3; c++ )
+    escala = std::max(
+      escala, sqrtf( mv[4 * c] * mv[4 * c] + mv[4 * c + 1] * mv[4 * c + 1] +
+                     mv[4 * c + 2] * mv[4 * c + 2] ) );
+  float r = radius * escala;
+
+  // p[5]: escala vertical da projecao; p[11] == -1 na perspectiva (divide por -z)
+  float w = p[11] * ez + p[15];
+  if ( w <= 0.0f || ( p[11] != 0.0f && -ez <= r ) )
+    return 1e9f;  // atras do olho ou o olho dentro do objeto: detalhe maximo
+  return r * fabsf( p[5] ) * 0.5f * vp[3] / w;
+}
+
+void Tessellation::adjust(
+  float radius, GLint &slices, GLint &stacks, float cx, float cy, float cz ) {
+  if ( !autoLOD )
+    return;
+  float rPixels   = projectedRadius( radius, cx, cy, cz );
+  float nSlices   = 2.0f * (float)M_PI * rPixels / std::max( pixelsPerSegment, 0.5f );
+  int   maxSlices = slices, maxStacks = stacks;
+  slices = (GLint)std::clamp( nSlices, (float)std::min( minSlices, maxSlices ), (float)maxSlices );
+  stacks = std::clamp( slices / 2, std::min( minStacks, maxStacks ), maxStacks );
+}
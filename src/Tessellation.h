@@ -0,0 +1,49 @@
+/**
+ * @file Tessellation.h
+ * @brief Declaração da classe Tessellation, que escolhe o nível de detalhe das primitivas GLU.
+ *
+ * @details Com glutGUI::slices e glutGUI::stacks fixos em 200, uma esfera que ocupa poucos
+ * pixels é desenhada com dezenas de milhares de triângulos. No modo automático (autoLOD), o
+ * número de fatias é escolhido pelo tamanho projetado na tela (cerca de pixelsPerSegment pixels
+ * por segmento do contorno), entre os mínimos desta classe e os valores globais, que passam a
+ * ser o máximo. Desligado (padrão), os valores globais são usados como antes.
+ */
+#ifndef TESSELLATION_H
+#define TESSELLATION_H
+
+#include <GL/gl.h>
+
+/**
+ * @class Tessellation
+ * @brief Nível de detalhe das primitivas pelo tamanho na tela.
+ */
+class Tessellation {
+public:
+  static bool  autoLOD;          /**< @brief Liga/desliga a escolha automática (desligada por
+                                    padrão). */
+  static int   minSlices;        /**< @brief Mínimo de fatias (padrão 8). */
+  static int   minStacks;        /**< @brief Mínimo de pilhas (padrão 6). */
+  static float pixelsPerSegment; /**< @brief Comprimento desejado, em pixels, de cada segmento do
+                                    contorno (padrão 4). */
+
+  /**
+   * @brief Ajusta slices e stacks para um objeto de raio `radius` centrado em (cx, cy, cz) no
+   * espaço local atual (usa a modelview, a projeção e a viewport correntes, então também vale em
+   * sub-viewports e nas passadas de picking, reflexo e sombra).
+   * @param slices, stacks Na entrada, o máximo (normalmente glutGUI::slices e glutGUI::stacks);
+   * na saída, os valores a usar. Sem autoLOD não são alterados.
+   */
+  static void adjust( float  radius,
+                      GLint &slices,
+                      GLint &stacks,
+                      float  cx = 0.0,
+                      float  cy = 0.0,
+                      float  cz = 0.0 );
+
+  /**
+   * @brief Raio projetado em pixels de uma esfera no espaço local atual.
+   */
+  static float projectedRadius( float radius, float cx = 0.0, float cy = 0.0, float cz = 0.0 );
+};
+
+#endif  // TESSELLATION_H
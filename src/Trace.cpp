@@ -0,0 +1,220 @@
+#include "Trace.h"
+
+#include "Stats.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+std::atomic<bool> Trace::capturing( false );
+
+enum TipoEvento : uint8_t { EVENTO_INICIO, EVENTO_FIM, EVENTO_CONTADOR };
+
+struct EventoTrace {
+  uint64_t    ns;
+  const char *name;
+  double      value;
+  TipoEvento  tipo;
+};
+
+// evento ja retirado de um buffer, com a thread de origem
+struct EventoColetado {
+  EventoTrace evento;
+  int         tid;
+};
+
+// buffer circular de uma thread: so a propria thread escreve (head) e so a thread principal le
+// (tail), entao basta a ordenacao acquire/release entre os dois indices
+struct BufferThread {
+  static const uint32_t CAPACIDADE = 1u << 15;  // potencia de 2
+
+  EventoTrace           eventos[CAPACIDADE];
+  std::atomic<uint32_t> head{ 0 };
+  std::atomic<uint32_t> tail{ 0 };
+  std::atomic<uint32_t> descartados{ 0 };
+  int                   tid;
+  std::string           nome;
+
+  void push( const EventoTrace &e ) {
+    uint32_t h = head.load( std::memory_order_relaxed );
+    if ( h - tail.load( std::memory_order_acquire ) >= CAPACIDADE ) {
+      descartados.fetch_add( 1, std::memory_order_relaxed );  // cheio: perde o evento
+      return;
+    }
+    eventos[h & ( CAPACIDADE - 1 )] = e;
+    head.store( h + 1, std::memory_order_release );
+  }
+
+  template <typename F>
+  void drain( F &&consome ) {
+    uint32_t t = tail.load( std::memory_order_relaxed );
+    uint32_t h = head.load( std::memory_order_acquire );
+    for ( ; t != h; t++ )
+      consome( eventos[t & ( CAPACIDADE - 1 )] );
+    tail.store( t, std::memory_order_release );
+  }
+};
+
+// a lista de buffers so e alterada quando uma thread grava pela primeira vez
+static std::mutex                  mutexBuffers;
+static std::vector<BufferThread *> buffers;
+static thread_local BufferThread  *bufferLocal = nullptr;
+
+static std::vector<EventoColetado> coletados;
+static int                         framesRestantes = 0;
+static std::string                 arquivoSaida;
+static uint64_t                    inicioCaptura = 0;
+static bool                        frameAberto   = false;
+
+static uint64_t agoraNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch() )
+    .count();
+}
+
+static BufferThread *bufferDaThread() {
+  if ( !bufferLocal ) {
+    BufferThread               *b = new BufferThread();  // vive ate o fim do programa
+    std::lock_guard<std::mutex> lock( mutexBuffers );
+    b->tid = (int)buffers.size() + 1;
+    b->nome = b->tid == 1 ? "main" : "thread " + std::to_string( b->tid );
+    buffers.push_back( b );
+    bufferLocal = b;
+  }
+  return bufferLocal;
+}
+
+static void coletaBuffers( bool guardar ) {
+  std::lock_guard<std::mutex> lock( mutexBuffers );
+  for ( BufferThread *b : buffers ) {
+    b->drain( [&]( const EventoTrace &e ) {
+      if ( guardar )
+        coletados.push_back( { e, b->tid } );
+    } );
+  }
+}
+
+static void escreveString( FILE *f, const char *s ) {
+  fputc( '"', f );
+  for ( ; *s; s++ ) {
+    if ( *s == '"' || *s == '\\' )
+      fputc( '\\', f );
+    fputc( *s, f );
+  }
+  fputc( '"', f );
+}
+
+static void gravaArquivo() {
+  FILE *f = fopen( arquivoSaida.c_str(), "w" );
+  if ( !f ) {
+    printf( "Trace: nao foi possivel criar %s\n", arquivoSaida.c_str() );
+    return;
+  }
+  fprintf( f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+  bool primeiro = true;
+  {
+    std::lock_guard<std::mutex> lock( mutexBuffers );
+    for ( BufferThread *b : buffers ) {
+      fprintf( f,
+               "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,",
+               primeiro ? "" : ",\n",
+               b->tid );
+      fprintf( f, "\"args\":{\"name\":" );
+      escreveString( f, b->nome.c_str() );
+      fprintf( f, "}}" );
+      primeiro = false;
+      uint32_t perdidos = b->descartados.exchange( 0 );
+      if ( perdidos > 0 )
+        printf( "Trace: %u eventos descartados na thread %s (buffer cheio)\n",
+                perdidos,
+                b->nome.c_str() );
+    }
+  }
+  for ( const EventoColetado &c : coletados ) {
+    const EventoTrace &e  = c.evento;
+    double             us = e.ns >= inicioCaptura ? ( e.ns - inicioCaptura ) / 1000.0 : 0.0;
+    fprintf( f, "%s{\"name\":", primeiro ? "" : ",\n" );
+    escreveString( f, e.name ? e.name : "" );
+    switch ( e.tipo ) {
+      case EVENTO_INICIO: fprintf( f, ",\"ph\":\"B\"" ); break;
+      case EVENTO_FIM: fprintf( f, ",\"ph\":\"E\"" ); break;
+      case EVENTO_CONTADOR: fprintf( f, ",\"ph\":\"C\"" ); break;
+    }
+    fprintf( f, ",\"ts\":%.3f,\"pid\":1,\"tid\":%d", us, c.tid );
+    if ( e.tipo == EVENTO_CONTADOR ) {
+      fprintf( f, ",\"args\":{" );
+      escreveString( f, e.name ? e.name : "" );
+      fprintf( f, ":%g}", e.value );
+    }
+    fprintf( f, "}" );
+    primeiro = false;
+  }
+  fprintf( f, "\n]}\n" );
+  fclose( f );
+  printf( "Trace: %zu eventos gravados em %s\n", coletados.size(), arquivoSaida.c_str() );
+  coletados.clear();
+}
+
+void Trace::begin( const char *name ) {
+  bufferDaThread()->push( { agoraNs(), name, 0.0, EVENTO_INICIO } );
+}
+
+void Trace::end() {
+  bufferDaThread()->push( { agoraNs(), nullptr, 0.0, EVENTO_FIM } );
+}
+
+void Trace::counter( const char *name, double value ) {
+  if ( !active() )
+    return;
+  bufferDaThread()->push( { agoraNs(), name, value, EVENTO_CONTADOR } );
+}
+
+void Trace::setThreadName( const char *name ) {
+  BufferThread               *b = bufferDaThread();
+  std::lock_guard<std::mutex> lock( mutexBuffers );
+  b->nome = name;
+}
+
+void Trace::capture( int nFrames, const char *path ) {
+  if ( active() || nFrames <= 0 )
+    return;
+  bufferDaThread();            // a thread principal e sempre a primeira
+  coletaBuffers( false );      // descarta fins de zonas de capturas anteriores
+  coletados.clear();
+  framesRestantes = nFrames;
+  arquivoSaida    = path;
+  inicioCaptura   = agoraNs();
+  printf( "Trace: capturando %d frames\n", nFrames );
+  capturing.store( true, std::memory_order_relaxed );
+}
+
+void Trace::beginFrame() {
+  if ( !active() || frameAberto )
+    return;
+  begin( "frame" );
+  frameAberto = true;
+}
+
+void Trace::endFrame() {
+  if ( frameAberto ) {
+    end();
+    frameAberto = false;
+  }
+  if ( !active() )
+    return;
+
+  counter( "cpu ms", Stats::cpuFrameMs() );
+  counter( "intervalo ms", Stats::frameIntervalMs() );
+
+  // esvazia os buffers a cada frame para que eles nao encham durante a captura
+  coletaBuffers( true );
+  if ( --framesRestantes > 0 )
+    return;
+
+  capturing.store( false, std::memory_order_relaxed );
+  coletaBuffers( true );
+  gravaArquivo();
+}
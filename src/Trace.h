@@ -0,0 +1,105 @@
+/**
+ * @file Trace.h
+ * @brief Declaração da classe Trace, um registrador de linha do tempo (timeline) multi-thread.
+ *
+ * @details Zonas (início/fim) e contadores são gravados em um buffer circular por thread,
+ * sem travas: cada thread é a única escritora do seu buffer e a thread principal é a única
+ * leitora. Fora de uma captura, cada zona custa apenas a leitura de uma flag atômica.
+ * Uma captura de N frames pode ser disparada pela tecla 'T' (glutGUI::defaultKey) ou por
+ * Trace::capture, e é gravada no formato JSON `trace_event` do Chrome, que pode ser aberto em
+ * `chrome://tracing` ou no Perfetto (ui.perfetto.dev).
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+
+/**
+ * @class Trace
+ * @brief Zonas e contadores com exportação para o formato de trace do Chrome.
+ */
+class Trace {
+public:
+  /**
+   * @class Zone
+   * @brief Registra uma zona que dura enquanto o objeto existir (use QXGL_TRACE_ZONE).
+   */
+  class Zone {
+  public:
+    explicit Zone( const char *name ) : recording( Trace::active() ) {
+      if ( recording )
+        Trace::begin( name );
+    }
+
+    ~Zone() {
+      if ( recording )
+        Trace::end();
+    }
+
+    Zone( const Zone & )            = delete;
+    Zone &operator=( const Zone & ) = delete;
+
+  private:
+    bool recording;
+  };
+
+  /**
+   * @brief Indica se uma captura está em andamento.
+   */
+  static bool active() { return capturing.load( std::memory_order_relaxed ); }
+
+  /**
+   * @brief Abre uma zona na thread atual.
+   * @param name Nome da zona. Deve ser uma string de vida longa (normalmente um literal).
+   */
+  static void begin( const char *name );
+
+  /**
+   * @brief Fecha a zona aberta mais recentemente na thread atual.
+   */
+  static void end();
+
+  /**
+   * @brief Registra o valor de um contador (aparece como gráfico na linha do tempo).
+   * @param name Nome do contador. Deve ser uma string de vida longa.
+   * @param value Valor atual.
+   */
+  static void counter( const char *name, double value );
+
+  /**
+   * @brief Define o nome exibido para a thread atual (ex.: "loader 1").
+   */
+  static void setThreadName( const char *name );
+
+  /**
+   * @brief Inicia a captura dos próximos frames.
+   * @param nFrames Quantidade de frames a capturar.
+   * @param path Arquivo JSON gerado ao final da captura.
+   */
+  static void capture( int nFrames, const char *path = "qxgl_trace.json" );
+
+  /**
+   * @brief Abre a zona do frame. Chamada por GUI::displayInit (repetições são ignoradas).
+   */
+  static void beginFrame();
+
+  /**
+   * @brief Fecha a zona do frame, registra os contadores do frame e esvazia os buffers das
+   * threads. Ao fim dos N frames pedidos, grava o arquivo. Chamada por GUI::displayEnd.
+   */
+  static void endFrame();
+
+private:
+  static std::atomic<bool> capturing;
+};
+
+#define QXGL_TRACE_CONCAT2( a, b ) a##b
+#define QXGL_TRACE_CONCAT( a, b )  QXGL_TRACE_CONCAT2( a, b )
+
+/**
+ * @def QXGL_TRACE_ZONE(name)
+ * @brief Registra uma zona com o nome dado até o fim do escopo atual.
+ */
+#define QXGL_TRACE_ZONE( name ) Trace::Zone QXGL_TRACE_CONCAT( traceZone, __LINE__ )( name )
+
+#endif  // TRACE_H
@@ -1,5 +1,13 @@
 #include "extra.h"
 
+#include "CamAnimation.h"
+#include "CameraPath.h"
+#include "GLState.h"
+#include "Primitives.h"
+#include "Stats.h"
+#include "Tessellation.h"
+#include "Trace.h"
+
 bool glutGUI::iluminacao3D = true;  // AL
 
 int glutGUI::width  = 400;
@@ -25,6 +33,10 @@ MouseLock glutGUI::mouse_lock = NOT_LOCKED;
 float     glutGUI::last_x     = 0.0;
 float     glutGUI::last_y     = 0.0;
 
+bool  glutGUI::accumulateInput = false;
+float glutGUI::pendingDx       = 0.0;
+float glutGUI::pendingDy       = 0.0;
+
 Camera *glutGUI::cam            = new CameraDistante();
 float   glutGUI::savedCamera[9] = { 5, 5, 20, 0, 0, 0, 0, 1, 0 };
 
@@ -33,6 +45,8 @@ float glutGUI::value        = 90;
 Axis  glutGUI::axis         = AXIS_Y;
 int   glutGUI::nIterations  = 10;
 
+bool glutGUI::redrawOnDemand = false;
+
 int glutGUI::slices = 200;  // 400;//16;
 int glutGUI::stacks = 200;  // 400;//16;
 
@@ -128,25 +142,27 @@ void glutGUI::defaultDisplay() {
 
   // LIGHT0
   // habilita luz
-  glEnable( GL_LIGHT0 );
+  GLState::enable( GL_LIGHT0 );
   // definindo intensidades de cor da luz
   GLfloat light_ambient[]  = { 0.2f, 0.2f, 0.2f, 1.0f };
   GLfloat light_diffuse[]  = { 0.7f, 0.7f, 0.7f, 1.0f };
   GLfloat light_specular[] = { 0.7f, 0.7f, 0.7f, 1.0f };
-  glLightfv( GL_LIGHT0, GL_AMBIENT, light_ambient );
-  glLightfv( GL_LIGHT0, GL_DIFFUSE, light_diffuse );
-  glLightfv( GL_LIGHT0, GL_SPECULAR, light_specular );
+  GLState::light( GL_LIGHT0, GL_AMBIENT, light_ambient );
+  GLState::light( GL_LIGHT0, GL_DIFFUSE, light_diffuse );
+  GLState::light( GL_LIGHT0, GL_SPECULAR, light_specular );
   // posicionando a luz
   GLfloat light_position[] = { 0.0f, 1.0f, 0.0f, 1.0f };
   glLightfv( GL_LIGHT0, GL_POSITION, light_position );
   // desenha uma esfera representando a luz
-  glDisable( GL_LIGHTING );
+  GLState::disable( GL_LIGHTING );
   glColor4f( 1.0, 1.0, 1.0, 1.0 );
   glPushMatrix();
   glTranslatef( light_position[0], light_position[1], light_position[2] );
-  glutSolidSphere( 0.02, slices, stacks );
+  GLint sl = slices, st = stacks;
+  Tessellation::adjust( 0.02, sl, st );
+  Primitives::sphere( 0.02, sl );
   glPopMatrix();
-  glEnable( GL_LIGHTING );
+  GLState::enable( GL_LIGHTING );
 
   // desenha sistema de coordenadas global
   // glPushMatrix();
@@ -159,13 +175,13 @@ void glutGUI::defaultDisplay() {
   GLfloat mat_specular[]   = { 1.0, 1.0, 1.0, 1.0 };
   GLfloat high_shininess[] = { 100.0f };
 
-  glMaterialfv( GL_FRONT, GL_AMBIENT, mat_ambient );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, mat_diffuse );
-  glMaterialfv( GL_FRONT, GL_SPECULAR, mat_specular );
-  glMaterialfv( GL_FRONT, GL_SHININESS, high_shininess );
+  GLState::material( GL_FRONT, GL_AMBIENT, mat_ambient );
+  GLState::material( GL_FRONT, GL_DIFFUSE, mat_diffuse );
+  GLState::material( GL_FRONT, GL_SPECULAR, mat_specular );
+  GLState::material( GL_FRONT, GL_SHININESS, high_shininess );
 
   // desenha chao
-  glDisable( GL_CULL_FACE );
+  GLState::disable( GL_CULL_FACE );
 
   // int discr = 1;
   // Desenha::drawGrid( 5/discr, 0, 5/discr, discr );
@@ -200,7 +216,7 @@ void glutGUI::defaultDisplay() {
   }
   glPopMatrix();
 
-  glEnable( GL_CULL_FACE );
+  GLState::enable( GL_CULL_FACE );
 
   glutSwapBuffers();
 }
@@ -303,6 +319,8 @@ void glutGUI::changeCam() {
 }
 
 void glutGUI::defaultKey( unsigned char key, int x, int y ) {
+  if ( redrawOnDemand )
+    glutPostRedisplay();  // o timer so pede frames com o mouse ou uma animacao em andamento
   switch ( key ) {
     case 27:
     case 13:
@@ -331,6 +349,17 @@ void glutGUI::defaultKey( unsigned char key, int x, int y ) {
       posCam++;
       changeCam();
       break;
+    case 'T': Trace::capture( 60 ); break;
+
+    case 'k': CameraPath::addKeyframe( cam ); break;
+    case 'K': CameraPath::clear(); break;
+    case 'p':
+      if ( CameraPath::isPlaying() )
+        CameraPath::stop();
+      else
+        CameraPath::play();
+      break;
+
     case 'j':
       posCam = 1;
       delete cam;
@@ -392,10 +421,7 @@ void glutGUI::autoCamMove( float value, Axis axis, int nIterations ) {
   if ( axis == AXIS_Y && fabs( cam->u.y ) <= 0.1 )
     return;
 
-  contRotation         = 0;
-  glutGUI::value       = value;
-  glutGUI::axis        = axis;
-  glutGUI::nIterations = nIterations;
+  CamAnimation::start( axis, value, nIterations * 16.0f );
 }
 
 void glutGUI::autoCamMotion( float value, Axis axis, int nIterations ) {
@@ -421,6 +447,10 @@ void glutGUI::autoCamMotion( float value, Axis axis, int nIterations ) {
   }
 }
 
+bool glutGUI::isIdle() {
+  return !mouseMoving && CamAnimation::isIdle() && !CameraPath::isPlaying();
+}
+
 // detecta quando o mouse pára de mover,
 // baseado no tempo após a última execução do mouseMove
 void glutGUI::checkMouseIdle() {
@@ -434,6 +464,46 @@ void glutGUI::checkMouseIdle() {
   }
 }
 
+// zera os deltas lidos por Transform::updateByMouse
+static void zeraDeltas() {
+  glutGUI::dtx = 0.0;
+  glutGUI::dty = 0.0;
+  glutGUI::dtz = 0.0;
+  glutGUI::dax = 0.0;
+  glutGUI::day = 0.0;
+  glutGUI::daz = 0.0;
+  glutGUI::dsx = 0.0;
+  glutGUI::dsy = 0.0;
+  glutGUI::dsz = 0.0;
+
+  glutGUI::drx  = 0.0;
+  glutGUI::dry  = 0.0;
+  glutGUI::dlry = 0.0;
+  glutGUI::dly  = 0.0;
+  glutGUI::dlx  = 0.0;
+  glutGUI::dlrx = 0.0;
+  glutGUI::dmx  = 0.0;
+  glutGUI::dmy  = 0.0;
+  glutGUI::dlmy = 0.0;
+}
+
+// com accumulateInput, indica se os deltas atuais ja foram expostos a um frame (e devem ser zerados
+// antes de somar novos deslocamentos)
+static bool deltasExpostos = true;
+static long frameComInput  = -1;
+
+static void aplicaPendentes() {
+  if ( deltasExpostos ) {
+    zeraDeltas();
+    deltasExpostos = false;
+  }
+  if ( glutGUI::pendingDx != 0.0 || glutGUI::pendingDy != 0.0 ) {
+    glutGUI::applyMouseDelta( glutGUI::pendingDx, glutGUI::pendingDy );
+    glutGUI::pendingDx = 0.0;
+    glutGUI::pendingDy = 0.0;
+  }
+}
+
 // os deltas do mouse precisam ser zerados periodicamente,
 // pois eles estavam se mantendo com os valores calculados
 // após a última execução do mouseMove
@@ -443,30 +513,15 @@ void glutGUI::checkMouseIdle() {
 // usar o idle no ubuntu foi suficiente, mas no windows os deltas ficavam sempre zerados, pois o
 // idle é chamado muito mais frequentemente no windows do que no ubuntu
 void glutGUI::idle() {
+  QXGL_TRACE_ZONE( "glutGUI::idle" );
   checkMouseIdle();  // detecta quando o mouse pára de mover
-  if ( !mouseMoving ) {
-    dtx = 0.0;
-    dty = 0.0;
-    dtz = 0.0;
-    dax = 0.0;
-    day = 0.0;
-    daz = 0.0;
-    dsx = 0.0;
-    dsy = 0.0;
-    dsz = 0.0;
-
-    drx  = 0.0;
-    dry  = 0.0;
-    dlry = 0.0;
-    dly  = 0.0;
-    dlx  = 0.0;
-    dlrx = 0.0;
-    dmx  = 0.0;
-    dmy  = 0.0;
-    dlmy = 0.0;
-  }
+  if ( !mouseMoving && !accumulateInput )  // com accumulateInput, applyInput zera por frame
+    zeraDeltas();
 
-  // autoCamMotion(value,axis,nIterations);
+  if ( redrawOnDemand && isIdle() ) {
+    glutIdleFunc( nullptr );  // nada para animar: para de ocupar a CPU ate o timer religar
+    return;
+  }
   glutPostRedisplay();
 }
 
@@ -478,8 +533,10 @@ void glutGUI::idle() {
 // o que torna essa solução com o timer muito ruim!
 //
 // a solução foi detectar quando o mouse parasse de mover (checkMouseIdle)
-// timer não mais usado para zerar os deltas do mouse, apenas para o autoCamMotion
+// timer não mais usado para zerar os deltas do mouse; as animações da câmera (CamAnimation) são
+// avançadas pelo relógio em GUI::displayInit, então o timer só pede os frames
 void glutGUI::timer( int time ) {
+  QXGL_TRACE_ZONE( "glutGUI::timer" );
   // dtx = 0.0; dty = 0.0; dtz = 0.0;
   // dax = 0.0; day = 0.0; daz = 0.0;
   // dsx = 0.0; dsy = 0.0; dsz = 0.0;
@@ -488,8 +545,15 @@ void glutGUI::timer( int time ) {
   // dly = 0.0; dlx = 0.0; dlrx = 0.0;
   // dmx = 0.0; dmy = 0.0; dlmy = 0.0;
 
-  autoCamMotion( value, axis, nIterations );
-  glutPostRedisplay();
+  if ( !redrawOnDemand ) {
+    glutPostRedisplay();
+  } else {
+    checkMouseIdle();
+    if ( !isIdle() ) {
+      glutIdleFunc( glutGUI::idle );
+      glutPostRedisplay();
+    }
+  }
 
   glutTimerFunc(
     16, glutGUI::timer, 0 );  // Chama a função novamente após 16 milissegundos (~60 FPS)
@@ -498,25 +562,12 @@ void glutGUI::timer( int time ) {
 }
 
 void glutGUI::defaultMouseButton( int button, int state, int x, int y ) {
-  dtx = 0.0;
-  dty = 0.0;
-  dtz = 0.0;
-  dax = 0.0;
-  day = 0.0;
-  daz = 0.0;
-  dsx = 0.0;
-  dsy = 0.0;
-  dsz = 0.0;
-
-  drx  = 0.0;
-  dry  = 0.0;
-  dlry = 0.0;
-  dly  = 0.0;
-  dlx  = 0.0;
-  dlrx = 0.0;
-  dmx  = 0.0;
-  dmy  = 0.0;
-  dlmy = 0.0;
+  if ( redrawOnDemand )
+    glutPostRedisplay();
+  if ( accumulateInput )
+    aplicaPendentes();  // o deslocamento acumulado pertence aos botoes anteriores
+  else
+    zeraDeltas();
 
   // if the left button is pressed
   if ( button == GLUT_LEFT_BUTTON ) {
@@ -571,6 +622,7 @@ void glutGUI::defaultMouseButton( int button, int state, int x, int y ) {
 // dsx = 0.0; dsy = 0.0; dsz = 0.0;
 
 void glutGUI::mouseMove( int x, int y ) {
+  QXGL_TRACE_ZONE( "glutGUI::mouseMove" );
   if ( mouse_lock == ONLY_X )
     last_y = y;
   if ( mouse_lock == ONLY_Y )
@@ -578,42 +630,40 @@ void glutGUI::mouseMove( int x, int y ) {
 
   lastMoveTime = std::chrono::steady_clock::now();
   mouseMoving  = true;
+  if ( redrawOnDemand )
+    glutPostRedisplay();
+
+  if ( accumulateInput ) {
+    // so acumula; a camera e os objetos sao atualizados uma vez por frame (applyInput)
+    pendingDx += x - last_x;
+    pendingDy += y - last_y;
+  } else {
+    zeraDeltas();
+    applyMouseDelta( x - last_x, y - last_y );
+  }
 
-  dtx = 0.0;
-  dty = 0.0;
-  dtz = 0.0;
-  dax = 0.0;
-  day = 0.0;
-  daz = 0.0;
-  dsx = 0.0;
-  dsy = 0.0;
-  dsz = 0.0;
-
-  drx  = 0.0;
-  dry  = 0.0;
-  dlry = 0.0;
-  dly  = 0.0;
-  dlx  = 0.0;
-  dlrx = 0.0;
-  dmx  = 0.0;
-  dmy  = 0.0;
-  dlmy = 0.0;
+  last_x = x;
+  last_y = y;
+}
 
+// as funcoes da camera dependem apenas da diferenca (novo - ultimo), entao o deslocamento
+// acumulado pode ser passado como (delta, 0)
+void glutGUI::applyMouseDelta( float dx, float dy ) {
   float fator = 10.0;
   if ( lbpressed && !rbpressed && !mbpressed ) {
     if ( !trans_obj && ( !trans_luz || !obj_transp ) ) {
-      cam->rotatex( y, last_y );
-      cam->rotatey( x, last_x );
+      cam->rotatex( dy, 0 );
+      cam->rotatey( dx, 0 );
     }
     if ( trans_obj ) {
-      dly = dax = ( y - last_y ) / fator;
-      dlx = day = ( x - last_x ) / fator;
-      ax += dax;
-      ay += day;
+      dly = dax += dy / fator;
+      dlx = day += dx / fator;
+      ax += dy / fator;
+      ay += dx / fator;
     }
     if ( trans_luz && obj_transp ) {
       fator = 100.0;
-      transparencia -= ( y - last_y ) / fator;
+      transparencia -= dy / fator;
       if ( transparencia < 0.0 )
         transparencia = 0.0;
       if ( transparencia > 1.0 )
@@ -623,62 +673,67 @@ void glutGUI::mouseMove( int x, int y ) {
   fator = 100.0;
   if ( !lbpressed && rbpressed && !mbpressed ) {
     if ( !trans_obj && !trans_luz ) {
-      cam->translatex( x, last_x );
-      cam->translatey( y, last_y );
+      cam->translatex( dx, 0 );
+      cam->translatey( dy, 0 );
     }
     if ( trans_obj ) {
-      drx = dtx = ( x - last_x ) / fator;
-      dry = dty = -( y - last_y ) / fator;
-      tx += dtx;
-      ty += dty;
+      drx = dtx += dx / fator;
+      dry = dty += -dy / fator;
+      tx += dx / fator;
+      ty += -dy / fator;
     }
     if ( trans_luz ) {
-      lx += ( x - last_x ) / fator;
-      ly += -( y - last_y ) / fator;
+      lx += dx / fator;
+      ly += -dy / fator;
     }
   }
   if ( lbpressed && rbpressed && !mbpressed ) {
     if ( !trans_obj && !trans_luz ) {
-      cam->zoom( y, last_y );
+      cam->zoom( dy, 0 );
       // orthof += -(y - last_y)/50000.0;
       orthof = 0.00025 * ( cam->c - cam->e ).modulo();
       // cam->rotatez(x,last_x);
     }
     if ( trans_obj ) {
       fator = 100.0;
-      dlry = dtz = ( y - last_y ) / fator;
-      tz += dtz;
+      dlry = dtz += dy / fator;
+      tz += dy / fator;
       fator = 10.0;
-      dlrx = daz = -( x - last_x ) / fator;
-      az += daz;
+      dlrx = daz += -dx / fator;
+      az += -dx / fator;
     }
     if ( trans_luz ) {
       fator = 100.0;
-      lz += ( y - last_y ) / fator;
+      lz += dy / fator;
       fator = 10.0;
-      spot_angle += -( x - last_x ) / fator;
+      spot_angle += -dx / fator;
     }
   }
   fator = 100.0;
   if ( !lbpressed && !rbpressed && mbpressed ) {
     if ( !trans_obj ) {
     } else {
-      dmx = dsx = ( x - last_x ) / fator;
-      dmy = dsy = -( y - last_y ) / fator;
-      sx += dsx;
-      sy += dsy;
+      dmx = dsx += dx / fator;
+      dmy = dsy += -dy / fator;
+      sx += dx / fator;
+      sy += -dy / fator;
     }
   }
   if ( lbpressed && !rbpressed && mbpressed ) {
     if ( !trans_obj ) {
     } else {
-      dlmy = dsz = ( y - last_y ) / fator;
-      sz += dsz;
+      dlmy = dsz += dy / fator;
+      sz += dy / fator;
     }
   }
+}
 
-  last_x = x;
-  last_y = y;
+void glutGUI::applyInput() {
+  if ( !accumulateInput || Stats::frame() == frameComInput )
+    return;  // displayInit chamado mais de uma vez no mesmo frame (varias viewports)
+  frameComInput = Stats::frame();
+  aplicaPendentes();
+  deltasExpostos = true;
 }
 
 //------------------------------------------------
@@ -80,18 +80,30 @@ public:
   static float     last_x;     /**< @brief Última posição X do mouse registrada. */
   static float     last_y;     /**< @brief Última posição Y do mouse registrada. */
 
+  static bool  accumulateInput; /**< @brief Se verdadeiro, o mouseMove apenas acumula os
+                                   deslocamentos, aplicados uma vez por frame por applyInput. */
+  static float pendingDx;       /**< @brief Deslocamento X acumulado ainda não aplicado. */
+  static float pendingDy;       /**< @brief Deslocamento Y acumulado ainda não aplicado. */
+
   static Camera *cam; /**< @brief Ponteiro para o objeto de câmera ativo. */
   static float
     savedCamera[9]; /**< @brief Array para salvar o estado da câmera (posição, alvo, up). */
 
-  static int   contRotation; /**< @brief Contador para a animação de rotação da câmera. */
-  static float value;        /**< @brief Valor (ângulo/distância) para a animação da câmera. */
-  static Axis  axis;         /**< @brief Eixo para a animação da câmera. */
-  static int   nIterations;  /**< @brief Número de passos na animação da câmera. */
+  static int   contRotation; /**< @brief Contador de passos de autoCamMotion.
+                                @deprecated Usado apenas por autoCamMotion. */
+  static float value;        /**< @brief Valor (ângulo/distância) para autoCamMotion.
+                                @deprecated Usado apenas por autoCamMotion. */
+  static Axis  axis;         /**< @brief Eixo para autoCamMotion.
+                                @deprecated Usado apenas por autoCamMotion. */
+  static int   nIterations;  /**< @brief Duração das animações de câmera do teclado, em passos
+                                de 16 ms. */
+  static bool redrawOnDemand; /**< @brief Se verdadeiro, idle e timer só pedem um novo frame
+                                 enquanto houver atividade (ver isIdle). */
 
   static int slices; /**< @brief Nível de detalhe (fatias) para objetos desenhados com GLU (esferas,
-                        cilindros). */
-  static int stacks; /**< @brief Nível de detalhe (pilhas) para objetos desenhados com GLU. */
+                        cilindros). Com Tessellation::autoLOD é o máximo. */
+  static int stacks; /**< @brief Nível de detalhe (pilhas) para objetos desenhados com GLU. Com
+                        Tessellation::autoLOD é o máximo. */
 
   static int posCam; /**< @brief Índice da câmera/visualização atual. */
 
@@ -157,21 +169,30 @@ public:
   static void defaultKey( unsigned char key, int x, int y );
 
   /**
-   * @brief Inicia uma animação de câmera.
+   * @brief Inicia uma animação de câmera (ver CamAnimation).
    * @param value O valor total da transformação (ex: 90 graus).
    * @param axis O eixo da transformação.
-   * @param nIterations O número de passos da animação.
+   * @param nIterations Duração da animação em passos de 16 ms (10 = 160 ms).
    */
   static void autoCamMove( float value, Axis axis, int nIterations = 10 );
 
   /**
-   * @brief Executa um passo da animação da câmera. Chamado por um timer.
+   * @brief Executa um passo de uma animação de câmera por passos (contRotation de 0 a
+   * nIterations).
+   * @deprecated Não é mais chamada pelo timer; autoCamMove usa CamAnimation, baseada no tempo.
+   * Mantida para código que avança a animação por conta própria.
    * @param value O valor total da transformação.
    * @param axis O eixo da transformação.
    * @param nIterations O número de passos da animação.
    */
   static void autoCamMotion( float value, Axis axis, int nIterations = 10 );
 
+  /**
+   * @brief Indica se não há nada a animar: mouse parado, nenhuma animação de câmera ativa e
+   * nenhum trajeto (CameraPath) em reprodução.
+   */
+  static bool isIdle();
+
   /**
    * @brief Verifica se o mouse parou de se mover por um tempo determinado.
    */
@@ -179,11 +200,14 @@ public:
 
   /**
    * @brief Função de idle do GLUT. Zera os deltas do mouse quando ele está inativo.
+   * @details Com redrawOnDemand, se desregistra quando isIdle() para não ocupar a CPU; o timer a
+   * registra de novo quando houver atividade.
    */
   static void idle();
 
   /**
-   * @brief Função de timer do GLUT. Usada para executar as animações da câmera.
+   * @brief Função de timer do GLUT. Pede novos frames a cada 16 ms (com redrawOnDemand,
+   * apenas enquanto houver atividade).
    * @param time Parâmetro do timer.
    */
   static void timer( int time );
@@ -204,6 +228,21 @@ public:
    */
   static void mouseMove( int x, int y );
 
+  /**
+   * @brief Aplica um deslocamento do mouse à câmera, à luz e às transformações de objetos,
+   * conforme os botões pressionados. Os deltas (dtx, dax, ...) são somados aos atuais.
+   * @param dx Deslocamento horizontal em pixels.
+   * @param dy Deslocamento vertical em pixels.
+   */
+  static void applyMouseDelta( float dx, float dy );
+
+  /**
+   * @brief Com accumulateInput ativo, aplica de uma só vez os deslocamentos acumulados desde o
+   * frame anterior e expõe os deltas resultantes para Transform::updateByMouse. Chamada no início
+   * de GUI::displayInit; sem accumulateInput não faz nada.
+   */
+  static void applyInput();
+
   /**
    * @brief Multiplica um vetor por uma matriz OpenGL (considerando column-major).
    * @param res Vetor de 4 floats para o resultado.
@@ -1,5 +1,26 @@
 #include "gui.h"
 
+#include "Batch.h"
+#include "CamAnimation.h"
+#include "CameraPath.h"
+#include "DebugDraw.h"
+#include "GLInstrument.h"
+#include "GLState.h"
+#include "GpuTimer.h"
+#include "Lighting.h"
+#include "Primitives.h"
+#include "Shader.h"
+#include "Stats.h"
+#include "Tessellation.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <vector>
+
 //-----Texturas---------
 // texture
 #include "OpenTextures.h"
@@ -20,6 +41,7 @@ int texture_mode = 0;
 // Texture ///////////////////////////////////////////////////////////
 // carrega inicialmente (apenas uma vez) as texturas dos arquivos
 void GUI::loadTextures() {
+  QXGL_TRACE_ZONE( "GUI::loadTextures" );
   /* Initialization of DevIL */
   if ( ilGetInteger( IL_VERSION_NUM ) < IL_VERSION ) {
     printf( "wrong DevIL version \n" );
@@ -30,52 +52,52 @@ void GUI::loadTextures() {
   // Generate 10 texture object ID's
   glGenTextures( 10, tList );
 
-  glBindTexture( GL_TEXTURE_2D, tList[GRANITO] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[GRANITO] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/granito.jpg", true );
   OT::loadTexture( "textures/granito.jpg", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[MARMORE] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[MARMORE] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/marmore.jpg", true );
   OT::loadTexture( "textures/marmore.jpg", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[LADRILHO] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[LADRILHO] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/ladrilho.jpg", true );
   OT::loadTexture( "textures/ladrilho.jpg", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[REFRI] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[REFRI] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/refri.jpg", true );
   OT::loadTexture( "textures/refri.jpg", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[REFRITRANSP] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[REFRITRANSP] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/refri.png", true );
   OT::loadTexture( "textures/refri.png", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[SKY] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[SKY] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/sky.jpg", true );
   OT::loadTexture( "textures/sky.jpg", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[KICK_ASS] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[KICK_ASS] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTextureRAW( "../textures/kick_ass.raw", true );
   OT::loadTextureRAW( "textures/kick_ass.raw", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[GRID] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[GRID] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/grid.jpg", true );
   OT::loadTexture( "textures/grid.jpg", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[AZULEJO] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[AZULEJO] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/azulejo.jpg", true );
   OT::loadTexture( "textures/azulejo.jpg", true );
 
-  glBindTexture( GL_TEXTURE_2D, tList[CHECKERS] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[CHECKERS] );
   // carrega a imagem e seta parametros de mapeamento de textura
   //  OT::loadTexture( "../textures/checkers.jpg", true );
   OT::loadTexture( "textures/checkers.jpg", true );
@@ -83,12 +105,12 @@ void GUI::loadTextures() {
 
 void GUI::habilitaTextura( bool renderTexture, bool texture_automatic, int texture_mode ) {
   if ( renderTexture ) {
-    glEnable( GL_TEXTURE_2D );
+    GLState::enable( GL_TEXTURE_2D );
     if ( texture_automatic ) {  // ignora as chamadas glTexCoord2f associadas aos glVertex3f (as
                                 // coordenadas de textura sao calculadas automaticamente em tempo de
                                 // execucao, acho que independente da geometria sendo desenhada)
-      glEnable( GL_TEXTURE_GEN_S );
-      glEnable( GL_TEXTURE_GEN_T );
+      GLState::enable( GL_TEXTURE_GEN_S );
+      GLState::enable( GL_TEXTURE_GEN_T );
       // glEnable(GL_TEXTURE_GEN_R);
       // glEnable(GL_TEXTURE_GEN_Q);
       // GLfloat zPlane[] = { 0.0f, 0.0f, 1.0f, 0.0f };
@@ -114,15 +136,15 @@ void GUI::habilitaTextura( bool renderTexture, bool texture_automatic, int textu
 }
 
 void GUI::selecionaTextura( int texture_id ) {
-  glBindTexture( GL_TEXTURE_2D, tList[texture_id] );
+  GLState::bindTexture( GL_TEXTURE_2D, tList[texture_id] );
 }
 
 void GUI::desabilitaTextura( bool renderTexture, bool texture_automatic ) {
   if ( renderTexture ) {
-    glDisable( GL_TEXTURE_2D );
+    GLState::disable( GL_TEXTURE_2D );
     if ( texture_automatic ) {
-      glDisable( GL_TEXTURE_GEN_S );
-      glDisable( GL_TEXTURE_GEN_T );
+      GLState::disable( GL_TEXTURE_GEN_S );
+      GLState::disable( GL_TEXTURE_GEN_T );
       // glDisable(GL_TEXTURE_GEN_R);
       // glDisable(GL_TEXTURE_GEN_Q);
     }
@@ -178,27 +200,28 @@ void GUI::GLInit() {
   glClearColor( 0.7, 0.7, 0.7, 1.0 );  // define a cor para limpar a imagem (cor de fundo)
   // glClearColor(1.0,1.0,1.0,1.0); //define a cor para limpar a imagem (cor de fundo)
 
-  glEnable( GL_LIGHTING );  // habilita iluminacao (chamada no setLight)
+  GLState::enable( GL_LIGHTING );  // habilita iluminacao (chamada no setLight)
   // glEnable(GL_COLOR_MATERIAL);
-  glEnable( GL_CULL_FACE );  // nao mostra as faces dos dois "lados" (frente [anti-horaria] e tras
-                             // [horaria])
+  GLState::enable( GL_CULL_FACE );  // nao mostra as faces dos dois "lados" (frente
+                                    // [anti-horaria] e tras [horaria])
   // glCullFace(GL_BACK); //define qual "lado" da face nao sera mostrado (padrao = nao mostrar a de
   // tras)
-  glEnable( GL_NORMALIZE );  // mantem a qualidade da iluminacao mesmo quando glScalef eh usada
+  GLState::enable( GL_NORMALIZE );  // mantem a qualidade da iluminacao mesmo quando glScalef eh
+                                    // usada
 
   glShadeModel( GL_SMOOTH );
   // glShadeModel(GL_FLAT);
 
-  glEnable( GL_LINE_SMOOTH );
+  GLState::enable( GL_LINE_SMOOTH );
   // glLineWidth( 1.0 );
   // glEnable( GL_POLYGON_SMOOTH ); //tem que modificar a maneira de fazer o blend ( GL_BLEND e
   // GL_ALPHA )
 
-  glEnable( GL_DEPTH_TEST );
+  GLState::enable( GL_DEPTH_TEST );
   // glDepthFunc(GL_LESS);
 
-  glEnable( GL_BLEND );  // habilita a transparencia
-  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  GLState::enable( GL_BLEND );  // habilita a transparencia
+  GLState::blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
 }
 
 GUI::~GUI() {
@@ -234,85 +257,70 @@ void GUI::setMouseButton( mouseButtonFunction mbFunction ) {
 // using namespace glutGUI;
 
 void GUI::displayInit() {
+  Batch::flush();  // o que sobrou de um desenho fora do frame
+  // entre um frame e outro a aplicacao pode ter alterado o estado direto pelo OpenGL
+  GLState::invalidate();
+  // inicio do frame (no picking o displayInit roda fora do frame normal)
+  if ( !glutGUI::picking ) {
+    Stats::beginFrame();
+    GpuTimer::beginFrame();
+    Trace::beginFrame();
+    glutGUI::applyInput();  // deslocamentos do mouse acumulados desde o frame anterior
+    CamAnimation::update( glutGUI::cam );
+    CameraPath::update( glutGUI::cam );  // a reproducao do trajeto tem prioridade
+  }
+  GpuTimer::Scope gpuScope( "GUI::displayInit" );
+  QXGL_TRACE_ZONE( "GUI::displayInit" );
+
   glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );  // limpa a imagem com a cor de fundo
 
-  const float ar     = glutGUI::height > 0 ? (float)glutGUI::width / (float)glutGUI::height : 1.0;
-  const float w      = glutGUI::width;
-  const float h      = glutGUI::height;
-  float       orthof = glutGUI::orthof;
+  ProjectionMode modo;
+  if ( glutGUI::perspective )
+    modo = PROJ_PERSPECTIVE;
+  else if ( glutGUI::ortho )
+    modo = PROJ_ORTHO;
+  else
+    modo = PROJ_OBLIQUE;
+  // as matrizes ficam em cache na camera e so sao recalculadas quando algo muda
+  glutGUI::cam->setProjection( modo,
+                               glutGUI::pontosDeFuga ? 150. : 30.,
+                               glutGUI::width,
+                               glutGUI::height,
+                               glutGUI::orthof );
 
   glMatrixMode( GL_PROJECTION );
 
   if ( !glutGUI::picking )
-    glLoadIdentity();
+    glLoadMatrixf( glutGUI::cam->projection().m );
   else {
     // lembrar de nao inicializar a matriz de projecao,
     // pois a gluPickMatrix é que redefine os planos de corte do volume de visualizacao reduzido
     //(apenas na vizinhanca do pixel selecionado pelo mouse)
-  }
-
-  if ( glutGUI::perspective )
-    if ( !glutGUI::pontosDeFuga )
-      gluPerspective( 30., ar, 0.1, 1000. );
-    else
-      gluPerspective( 150., ar, 0.1, 1000. );
-  else {
-    if ( glutGUI::ortho ) {
-      // orthof = 0.0025;
-      glOrtho( -orthof * w, orthof * w, -orthof * h, orthof * h, 0.0, 100.0 );
-    } else {
-      // obliqua  //   S . T . T(0,0,-near) . Sh . T(0,0,near)
-      float s         = 5;
-      float nearPlane = 0;
-      glOrtho( -s, s, -s * h / w, s * h / w, nearPlane, 20 );
-      glTranslatef( 0.0, 0.0, -nearPlane );  // translada -near em z de volta
-      // matriz de cisalhamento (projecao obliqua)
-      float alfa          = 75;                   // 60; //30 //90
-      alfa                = alfa * ( PI / 180 );  // grau2rad
-      float phi           = -75;                  //-60; //-30 //-90
-      phi                 = phi * ( PI / 180 );   // grau2rad
-      float transform[16] = { 1.0,
-                              0.0,
-                              1.0f / tan( alfa ),
-                              0.0,
-                              0.0,
-                              1.0,
-                              1.0f / tan( phi ),
-                              0.0,
-                              0.0,
-                              0.0,
-                              1.0,
-                              0.0,
-                              0.0,
-                              0.0,
-                              0.0,
-                              1.0 };
-      glMultTransposeMatrixf( transform );
-      glTranslatef( 0.0, 0.0, nearPlane );  // translada near em z
-    }
+    glMultMatrixf( glutGUI::cam->projection().m );
   }
 
   glMatrixMode( GL_MODELVIEW );  // Tcam . Tobj
-  glLoadIdentity();
 
   // viewport unica
   glViewport( 0, 0, glutGUI::width, glutGUI::height );
-  glLoadIdentity();
-  gluLookAt( glutGUI::cam->e.x,
-             glutGUI::cam->e.y,
-             glutGUI::cam->e.z,
-             glutGUI::cam->c.x,
-             glutGUI::cam->c.y,
-             glutGUI::cam->c.z,
-             glutGUI::cam->u.x,
-             glutGUI::cam->u.y,
-             glutGUI::cam->u.z );
+  glLoadMatrixf( glutGUI::cam->view().m );
   // gluLookAt(0,10,20,  0,0,0,  0,1,0);
 
   // GUI::setLight(7,0,4,0,true,false,true);
 }
 
 void GUI::displayEnd() {
+  Batch::flush();      // desenhos agrupados do frame, antes de medir o tempo de GPU
+  DebugDraw::flush();  // por ultimo: as formas sem teste de profundidade ficam por cima
+  {
+    QXGL_TRACE_ZONE( "GUI::displayEnd" );
+    GpuTimer::endFrame();
+  }
+  Stats::endFrame();
+  Trace::endFrame();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::endFrame();
+#endif
   glutSwapBuffers();
 }
 
@@ -324,6 +332,18 @@ void GUI::mouseButtonInit( int button, int state, int x, int y ) {
   glutGUI::defaultMouseButton( button, state, x, y );
 }
 
+bool GUI::lightSelection = true;
+
+// alcance das luzes do setLight, no espaco do olho, para o selectLights
+struct AlcanceLuz {
+  bool  ligada;    // ligada pelo setLight
+  bool  limitada;  // pontual e atenuada (alcance finito)
+  float pos[3];
+  float raio;
+};
+static AlcanceLuz alcanceLuzes[8];
+static int        luzesSelecionadas = -1;  // mascara do ultimo selectLights (-1: nenhuma selecao)
+
 void GUI::setLight( int   id,
                     float posx,
                     float posy,
@@ -342,9 +362,9 @@ void GUI::setLight( int   id,
   glutGUI::spot_light[id]    = spot;
   // habilita/desabilita luz
   if ( glutGUI::iluminacao && glutGUI::enabled_light[id] )
-    glEnable( GL_LIGHT0 + id );
+    GLState::enable( GL_LIGHT0 + id );
   else
-    glDisable( GL_LIGHT0 + id );
+    GLState::disable( GL_LIGHT0 + id );
   // definindo intensidades de cor da luz
   GLfloat light_ambient[]  = { 0.2f, 0.2f, 0.2f, 1.0f };
   GLfloat light_diffuse[]  = { 0.7f, 0.7f, 0.7f, 1.0f };
@@ -354,9 +374,9 @@ void GUI::setLight( int   id,
     light_diffuse[0] = light_diffuse[1] = light_diffuse[2] = 0.4f;
     light_specular[0] = light_specular[1] = light_specular[2] = 0.5f;
   }
-  glLightfv( GL_LIGHT0 + id, GL_AMBIENT, light_ambient );
-  glLightfv( GL_LIGHT0 + id, GL_DIFFUSE, light_diffuse );
-  glLightfv( GL_LIGHT0 + id, GL_SPECULAR, light_specular );
+  GLState::light( GL_LIGHT0 + id, GL_AMBIENT, light_ambient );
+  GLState::light( GL_LIGHT0 + id, GL_DIFFUSE, light_diffuse );
+  GLState::light( GL_LIGHT0 + id, GL_SPECULAR, light_specular );
   // posicionando a luz
   GLfloat light_position[] = {
     posx + glutGUI::lx, posy + glutGUI::ly, posz + glutGUI::lz, 1.0f
@@ -364,25 +384,45 @@ void GUI::setLight( int   id,
   if ( !glutGUI::pontual_light[id] )
     light_position[3] = 0.0f;
   glLightfv( GL_LIGHT0 + id, GL_POSITION, light_position );
+  // alcance: distancia em que a atenuacao deixa a luz abaixo de Lighting::threshold
+  AlcanceLuz &alcance = alcanceLuzes[id];
+  alcance.ligada      = glutGUI::iluminacao && glutGUI::enabled_light[id];
+  alcance.raio        = HUGE_VALF;
+  if ( attenuated && glutGUI::pontual_light[id] ) {
+    float intensidade = std::max( light_diffuse[0], light_specular[0] );
+    alcance.raio =
+      Lighting::rangeFromAttenuation( 2.0, 1.0, 0.5, intensidade, Lighting::threshold );
+  }
+  alcance.limitada = !std::isinf( alcance.raio );
+  if ( alcance.limitada ) {
+    float mv[16];
+    glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+    for ( int i = 0; i < 3; i++ )
+      alcance.pos[i] = mv[i] * light_position[0] + mv[4 + i] * light_position[1] +
+                       mv[8 + i] * light_position[2] + mv[12 + i];
+  }
+  luzesSelecionadas = -1;
   // desenha uma esfera representando a luz
   if ( glutGUI::iluminacao && glutGUI::enabled_light[id] && !glutGUI::hidden_light[id] ) {
-    glDisable( GL_LIGHTING );
+    GLState::disable( GL_LIGHTING );
     glColor4f( 1.0, 1.0, 1.0, 1.0 );
     glPushMatrix();
     glTranslatef( light_position[0], light_position[1], light_position[2] );
-    glutSolidSphere( 0.05, glutGUI::slices, glutGUI::stacks );
+    GLint slices = glutGUI::slices, stacks = glutGUI::stacks;
+    Tessellation::adjust( 0.05, slices, stacks );
+    Primitives::sphere( 0.05, slices );
     glPopMatrix();
-    glEnable( GL_LIGHTING );
+    GLState::enable( GL_LIGHTING );
   }
   // desenha uma linha do (0,0,0) ate a posicao da luz
   if ( glutGUI::iluminacao && glutGUI::enabled_light[id] && glutGUI::trans_luz ) {
-    glDisable( GL_LIGHTING );
+    GLState::disable( GL_LIGHTING );
     glColor4f( 1.0, 1.0, 1.0, 1.0 );
     glBegin( GL_LINES );
     glVertex3f( 0, 0, 0 );
     glVertex4fv( light_position );
     glEnd();
-    glEnable( GL_LIGHTING );
+    GLState::enable( GL_LIGHTING );
   }
   // spot_light
   if ( glutGUI::spot_light[id] ) {
@@ -390,19 +430,70 @@ void GUI::setLight( int   id,
       0.0f, 0.0f, -1.0f, 1.0f
     };  //{ -(2.0f + lx), -(5.0f + ly), -(5.0f + lz), 1.0f };
     glLightfv( GL_LIGHT0 + id, GL_SPOT_DIRECTION, light_direction );
-    glLightf( GL_LIGHT0 + id, GL_SPOT_CUTOFF, glutGUI::spot_angle );
+    GLState::light( GL_LIGHT0 + id, GL_SPOT_CUTOFF, glutGUI::spot_angle );
   } else {
-    glLightf( GL_LIGHT0 + id, GL_SPOT_CUTOFF, 180.0 );
+    GLState::light( GL_LIGHT0 + id, GL_SPOT_CUTOFF, 180.0 );
   }
   // attenuation
   if ( attenuated ) {
-    glLightf( GL_LIGHT0 + id, GL_CONSTANT_ATTENUATION, 2.0 );
-    glLightf( GL_LIGHT0 + id, GL_LINEAR_ATTENUATION, 1.0 );
-    glLightf( GL_LIGHT0 + id, GL_QUADRATIC_ATTENUATION, 0.5 );
+    GLState::light( GL_LIGHT0 + id, GL_CONSTANT_ATTENUATION, 2.0 );
+    GLState::light( GL_LIGHT0 + id, GL_LINEAR_ATTENUATION, 1.0 );
+    GLState::light( GL_LIGHT0 + id, GL_QUADRATIC_ATTENUATION, 0.5 );
   } else {
-    glLightf( GL_LIGHT0 + id, GL_CONSTANT_ATTENUATION, 1.0 );
-    glLightf( GL_LIGHT0 + id, GL_LINEAR_ATTENUATION, 0.0 );
-    glLightf( GL_LIGHT0 + id, GL_QUADRATIC_ATTENUATION, 0.0 );
+    GLState::light( GL_LIGHT0 + id, GL_CONSTANT_ATTENUATION, 1.0 );
+    GLState::light( GL_LIGHT0 + id, GL_LINEAR_ATTENUATION, 0.0 );
+    GLState::light( GL_LIGHT0 + id, GL_QUADRATIC_ATTENUATION, 0.0 );
+  }
+}
+
+void GUI::selectLights( const Vetor3D &min, const Vetor3D &max ) {
+  if ( !GLState::enabled )
+    return;  // gravando uma display list (cacheStatic): a selecao ficaria presa na gravacao
+
+  // caixa no espaco do olho: centro transformado e semi-extensoes somadas com |M|
+  float mv[16];
+  glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+  float c[3] = { float( min.x + max.x ) * 0.5f,
+                 float( min.y + max.y ) * 0.5f,
+                 float( min.z + max.z ) * 0.5f };
+  float e[3] = { float( max.x - min.x ) * 0.5f,
+                 float( max.y - min.y ) * 0.5f,
+                 float( max.z - min.z ) * 0.5f };
+  float centro[3], ext[3];
+  for ( int i = 0; i < 3; i++ ) {
+    centro[i] = mv[i] * c[0] + mv[4 + i] * c[1] + mv[8 + i] * c[2] + mv[12 + i];
+    ext[i]    = fabs( mv[i] ) * e[0] + fabs( mv[4 + i] ) * e[1] + fabs( mv[8 + i] ) * e[2];
+  }
+
+  int mascara = 0;
+  for ( int id = 0; id < 8; id++ ) {
+    const AlcanceLuz &a = alcanceLuzes[id];
+    if ( !a.ligada )
+      continue;
+    float d2 = 0.0f;
+    for ( int i = 0; i < 3 && a.limitada; i++ ) {
+      float d = std::max( fabs( a.pos[i] - centro[i] ) - ext[i], 0.0f );
+      d2 += d * d;
+    }
+    if ( d2 <= a.raio * a.raio )
+      mascara |= 1 << id;
+  }
+  if ( mascara == luzesSelecionadas )
+    return;
+  luzesSelecionadas = mascara;
+  for ( int id = 0; id < 8; id++ ) {
+    if ( alcanceLuzes[id].ligada )
+      GLState::set( GL_LIGHT0 + id, ( mascara >> id ) & 1 );
+  }
+}
+
+void GUI::restoreLights() {
+  if ( luzesSelecionadas == -1 )
+    return;
+  luzesSelecionadas = -1;
+  for ( int id = 0; id < 8; id++ ) {
+    if ( alcanceLuzes[id].ligada )
+      GLState::enable( GL_LIGHT0 + id );
   }
 }
 
@@ -414,10 +505,10 @@ void GUI::setColor( float r, float g, float b, float a, bool specular ) {
     mat_specular[0] = mat_specular[1] = mat_specular[2] = 1.0f;  // 0.5f;
   GLfloat high_shininess[] = { 100.0f };
 
-  glMaterialfv( GL_FRONT, GL_AMBIENT, mat_ambient );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, mat_diffuse );
-  glMaterialfv( GL_FRONT, GL_SPECULAR, mat_specular );
-  glMaterialfv( GL_FRONT, GL_SHININESS, high_shininess );
+  GLState::material( GL_FRONT, GL_AMBIENT, mat_ambient );
+  GLState::material( GL_FRONT, GL_DIFFUSE, mat_diffuse );
+  GLState::material( GL_FRONT, GL_SPECULAR, mat_specular );
+  GLState::material( GL_FRONT, GL_SHININESS, high_shininess );
 }
 
 //---------------transformacoes---------------
@@ -666,6 +757,7 @@ int GUI::processHits( GLint hits, GLuint buffer[] ) {
 
 void GUI::pickingInit(
   GLint cursorX, GLint cursorY, int w, int h, GLuint *selectBuf, int BUFSIZE ) {
+  Batch::flush();  // no modo de selecao os vertices vao direto para o OpenGL
   // glViewport(0, 3*glutGUI::height/4, glutGUI::width/4, glutGUI::height/4);
   glViewport( 0, 0, glutGUI::width, glutGUI::height );
   GLint viewport[4];
@@ -684,15 +776,17 @@ void GUI::pickingInit(
   // pixel selecionado pelo mouse)
   gluPickMatrix( cursorX, viewport[3] - cursorY, w, h, viewport );
 
-  glDisable( GL_LIGHTING );
+  GLState::disable( GL_LIGHTING );
 
   glutGUI::picking = true;
+
+  GpuTimer::begin( "GUI::picking" );
 }
 
 int GUI::pickingClosestName( GLuint *selectBuf, int BUFSIZE ) {
   glutGUI::picking = false;
 
-  glEnable( GL_LIGHTING );
+  GLState::enable( GL_LIGHTING );
 
   // processando as intersecoes
   int hits;
@@ -706,6 +800,8 @@ int GUI::pickingClosestName( GLuint *selectBuf, int BUFSIZE ) {
   // returning to normal rendering mode
   hits = glRenderMode( GL_RENDER );
 
+  GpuTimer::end();
+
   // if there are hits process them
   if ( hits != 0 ) {
     return GUI::processHits( hits, selectBuf );
@@ -714,20 +810,358 @@ int GUI::pickingClosestName( GLuint *selectBuf, int BUFSIZE ) {
   }
 }
 
+// picking por cor: framebuffer fora da tela e programa que escreve a cor do nome atual
+static GLuint              pickFbo = 0, pickCor = 0, pickProf = 0, pickPbo = 0;
+static int                 pickW = 0, pickH = 0;  // tamanho do framebuffer
+static GLuint              pickPrograma = 0;
+static GLint               pickUniform  = -1;
+static bool                pickPorCor   = false;
+static GLint               pickRegiao[4];  // x, y, largura, altura (coordenadas do OpenGL)
+static GLfloat             pickClearColor[4];
+static std::vector<GLuint> pickNomes;
+
+static bool criaProgramaPicking() {
+  const char *fonte = "uniform vec4 idColor;\n"
+                      "void main() { gl_FragColor = idColor; }\n";
+  pickPrograma      = Shader::program( NULL, fonte, "colorPicking" );
+  if ( pickPrograma == 0 )
+    return false;
+  pickUniform = glGetUniformLocation( pickPrograma, "idColor" );
+  return true;
+}
+
+static void criaFramebufferPicking( int w, int h ) {
+  if ( pickFbo == 0 ) {
+    glGenFramebuffers( 1, &pickFbo );
+    glGenRenderbuffers( 1, &pickCor );
+    glGenRenderbuffers( 1, &pickProf );
+    glGenBuffers( 1, &pickPbo );
+  }
+  glBindRenderbuffer( GL_RENDERBUFFER, pickCor );
+  glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, w, h );
+  glBindRenderbuffer( GL_RENDERBUFFER, pickProf );
+  glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h );
+  glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+  glBindFramebuffer( GL_FRAMEBUFFER, pickFbo );
+  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, pickCor );
+  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, pickProf );
+  if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+    printf( "colorPicking: framebuffer incompleto\n" );
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  pickW = w;
+  pickH = h;
+}
+
+// nome -> cor (24 bits em RGB)
+static void aplicaNomePicking() {
+  GLuint nome = pickNomes.empty() ? 0 : pickNomes.back();
+  glUniform4f( pickUniform,
+               ( nome & 0xFF ) / 255.0f,
+               ( ( nome >> 8 ) & 0xFF ) / 255.0f,
+               ( ( nome >> 16 ) & 0xFF ) / 255.0f,
+               1.0f );
+}
+
+void GUI::colorPickingInit( GLint cursorX, GLint cursorY, int w, int h ) {
+  Batch::flush();
+  if ( pickPrograma == 0 && !criaProgramaPicking() )
+    return;
+  if ( pickW != glutGUI::width || pickH != glutGUI::height )
+    criaFramebufferPicking( glutGUI::width, glutGUI::height );
+
+  // regiao w x h centrada no cursor (como a gluPickMatrix), limitada a janela
+  int x0 = cursorX - w / 2;
+  int y0 = ( glutGUI::height - cursorY ) - h / 2;
+  int x1 = x0 + w, y1 = y0 + h;
+  x0     = x0 < 0 ? 0 : x0;
+  y0     = y0 < 0 ? 0 : y0;
+  x1     = x1 > glutGUI::width ? glutGUI::width : x1;
+  y1     = y1 > glutGUI::height ? glutGUI::height : y1;
+  pickRegiao[0] = x0;
+  pickRegiao[1] = y0;
+  pickRegiao[2] = x1 > x0 ? x1 - x0 : 0;
+  pickRegiao[3] = y1 > y0 ? y1 - y0 : 0;
+
+  glBindFramebuffer( GL_FRAMEBUFFER, pickFbo );
+  glPushAttrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT );
+  glGetFloatv( GL_COLOR_CLEAR_VALUE, pickClearColor );
+  glClearColor( 0.0, 0.0, 0.0, 0.0 );  // nome 0: nenhum objeto
+  glDisable( GL_BLEND );
+  glDisable( GL_DITHER );
+  glScissor( pickRegiao[0], pickRegiao[1], pickRegiao[2], pickRegiao[3] );
+  glEnable( GL_SCISSOR_TEST );  // o glClear do displayInit tambem fica restrito a regiao
+
+  GLState::useProgram( pickPrograma );
+  pickNomes.clear();
+  aplicaNomePicking();
+
+  // o displayInit multiplica a projecao da camera sobre a atual
+  glMatrixMode( GL_PROJECTION );
+  glLoadIdentity();
+  glMatrixMode( GL_MODELVIEW );
+
+  pickPorCor       = true;
+  glutGUI::picking = true;
+
+  GpuTimer::begin( "GUI::picking" );
+}
+
+PickResult GUI::colorPickingClosest() {
+  PickResult res = { 0, 1.0f };
+  if ( !pickPorCor )
+    return res;
+  glutGUI::picking = false;
+  pickPorCor       = false;
+  GLState::useProgram( 0 );
+  GpuTimer::end();
+
+  const int n = pickRegiao[2] * pickRegiao[3];
+  if ( n > 0 ) {
+    // le apenas a regiao: cores (RGBA8) seguidas das profundidades (float)
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, pickPbo );
+    glBufferData( GL_PIXEL_PACK_BUFFER, n * 8, NULL, GL_STREAM_READ );
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    glReadPixels( pickRegiao[0],
+                  pickRegiao[1],
+                  pickRegiao[2],
+                  pickRegiao[3],
+                  GL_RGBA,
+                  GL_UNSIGNED_BYTE,
+                  (void *)0 );
+    glReadPixels( pickRegiao[0],
+                  pickRegiao[1],
+                  pickRegiao[2],
+                  pickRegiao[3],
+                  GL_DEPTH_COMPONENT,
+                  GL_FLOAT,
+                  (void *)(size_t)( n * 4 ) );
+    const GLubyte *dados = (const GLubyte *)glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
+    if ( dados ) {
+      const GLubyte *cores = dados;
+      const float   *prof  = (const float *)( dados + n * 4 );
+      for ( int i = 0; i < n; i++ ) {
+        GLuint nome = cores[4 * i] | ( cores[4 * i + 1] << 8 ) | ( cores[4 * i + 2] << 16 );
+        if ( nome != 0 && prof[i] < res.depth ) {
+          res.id    = nome;
+          res.depth = prof[i];
+        }
+      }
+      glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+    }
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+  }
+
+  glClearColor( pickClearColor[0], pickClearColor[1], pickClearColor[2], pickClearColor[3] );
+  glPopAttrib();
+  GLState::invalidate();  // o desenho entre o init e aqui pode ter passado pelo GLState
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();  // estado restaurado pelo glPopAttrib
+#endif
+  glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+  return res;
+}
+
+void GUI::pickingPushName( GLuint name ) {
+  if ( pickPorCor ) {
+    pickNomes.push_back( name );
+    aplicaNomePicking();
+  } else
+    glPushName( name );
+}
+
+void GUI::pickingPopName() {
+  if ( pickPorCor ) {
+    if ( !pickNomes.empty() )
+      pickNomes.pop_back();
+    aplicaNomePicking();
+  } else
+    glPopName();
+}
+
+// seleção por área: pool de occlusion queries reaproveitado entre chamadas
+static std::vector<GLuint> queriesSelecao;
+
+static void desenhaCaixa( const AABBSet &b, int i ) {
+  float x[2] = { b.minX[i], b.maxX[i] };
+  float y[2] = { b.minY[i], b.maxY[i] };
+  float z[2] = { b.minZ[i], b.maxZ[i] };
+  glBegin( GL_QUADS );
+  for ( int k = 0; k < 2; k++ ) {
+    glVertex3f( x[k], y[0], z[0] );
+    glVertex3f( x[k], y[1], z[0] );
+    glVertex3f( x[k], y[1], z[1] );
+    glVertex3f( x[k], y[0], z[1] );
+    glVertex3f( x[0], y[k], z[0] );
+    glVertex3f( x[1], y[k], z[0] );
+    glVertex3f( x[1], y[k], z[1] );
+    glVertex3f( x[0], y[k], z[1] );
+    glVertex3f( x[0], y[0], z[k] );
+    glVertex3f( x[1], y[0], z[k] );
+    glVertex3f( x[1], y[1], z[k] );
+    glVertex3f( x[0], y[1], z[k] );
+  }
+  glEnd();
+}
+
+int GUI::areaSelect( int               x0,
+                     int               y0,
+                     int               x1,
+                     int               y1,
+                     const AABBSet    &boxes,
+                     std::vector<int> &selected,
+                     bool              occlusion ) {
+  QXGL_TRACE_ZONE( "GUI::areaSelect" );
+  Camera *cam     = glutGUI::cam;
+  Frustum frustum = Frustum::fromScreenRect(
+    cam->viewProjection(), x0, y0, x1, y1, glutGUI::width, glutGUI::height );
+  Culling::cull( frustum, boxes, selected );
+  if ( !occlusion || selected.empty() )
+    return (int)selected.size();
+
+  Batch::flush();  // o depth buffer precisa estar completo para as consultas
+  GpuTimer::Scope gpuScope( "GUI::areaSelect" );
+  if ( queriesSelecao.size() < selected.size() ) {
+    size_t antes = queriesSelecao.size();
+    queriesSelecao.resize( selected.size() );
+    glGenQueries( (GLsizei)( selected.size() - antes ), &queriesSelecao[antes] );
+  }
+
+  // caixas contra o depth buffer da cena, sem alterar a imagem, so dentro do retangulo
+  glPushAttrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_SCISSOR_BIT |
+                GL_POLYGON_BIT );
+  glDisable( GL_LIGHTING );
+  glDisable( GL_TEXTURE_2D );
+  glDisable( GL_CULL_FACE );
+  glDisable( GL_BLEND );
+  glEnable( GL_DEPTH_TEST );
+  glDepthFunc( GL_LEQUAL );
+  glDepthMask( GL_FALSE );
+  glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+  glEnable( GL_POLYGON_OFFSET_FILL );
+  glPolygonOffset( -1.0, -1.0 );  // faces que coincidem com a superficie do objeto passam
+  glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+  glEnable( GL_SCISSOR_TEST );
+  glScissor( std::min( x0, x1 ),
+             glutGUI::height - std::max( y0, y1 ) - 1,
+             std::abs( x1 - x0 ) + 1,
+             std::abs( y1 - y0 ) + 1 );
+
+  glMatrixMode( GL_PROJECTION );
+  glPushMatrix();
+  glLoadMatrixf( cam->projection().m );
+  glMatrixMode( GL_MODELVIEW );
+  glPushMatrix();
+  glLoadMatrixf( cam->view().m );
+
+  // com o olho dentro da caixa as faces podem ficar atras do plano near: conta como visivel
+  std::vector<char> dentro( selected.size() );
+  for ( size_t k = 0; k < selected.size(); k++ ) {
+    int i     = selected[k];
+    dentro[k] = cam->e.x >= boxes.minX[i] && cam->e.x <= boxes.maxX[i] &&
+                cam->e.y >= boxes.minY[i] && cam->e.y <= boxes.maxY[i] &&
+                cam->e.z >= boxes.minZ[i] && cam->e.z <= boxes.maxZ[i];
+    if ( dentro[k] )
+      continue;
+    glBeginQuery( GL_SAMPLES_PASSED, queriesSelecao[k] );
+    desenhaCaixa( boxes, i );
+    glEndQuery( GL_SAMPLES_PASSED );
+  }
+
+  glPopMatrix();
+  glMatrixMode( GL_PROJECTION );
+  glPopMatrix();
+  glMatrixMode( GL_MODELVIEW );
+  glPopAttrib();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();  // estado restaurado pelo glPopAttrib
+#endif
+
+  // le os resultados so depois de disparar todas as queries (uma unica espera pela GPU)
+  size_t n = 0;
+  for ( size_t k = 0; k < selected.size(); k++ ) {
+    GLuint amostras = 1;
+    if ( !dentro[k] )
+      glGetQueryObjectuiv( queriesSelecao[k], GL_QUERY_RESULT, &amostras );
+    if ( amostras > 0 )
+      selected[n++] = selected[k];
+  }
+  selected.resize( n );
+  return (int)n;
+}
+
 //-------------------picking------------------
 
 //-------------------viewPorts------------------
 void GUI::glScissoredViewport( int x, int y, int width, int height ) {
   glScissor( x, y, width, height );
-  glEnable( GL_SCISSOR_TEST );
+  GLState::enable( GL_SCISSOR_TEST );
   glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-  glDisable( GL_SCISSOR_TEST );
+  GLState::disable( GL_SCISSOR_TEST );
 
   glViewport( x, y, width, height );
 }
 
 //-------------------viewPorts------------------
 
+//-------------------cache estatico------------------
+static std::map<std::string, GLuint> listasEstaticas;
+static bool                          gravandoEstatico = false;
+
+void GUI::cacheStatic( const std::string &key, const std::function<void()> &fn ) {
+  // no picking os nomes e as cores de identificacao mudam a cada chamada; dentro de outra gravacao
+  // nao pode haver glNewList aninhado (o conteudo entra na lista externa)
+  if ( glutGUI::picking || gravandoEstatico ) {
+    fn();
+    return;
+  }
+
+  auto it = listasEstaticas.find( key );
+  if ( it == listasEstaticas.end() ) {
+    QXGL_TRACE_ZONE( "GUI::cacheStatic (grava)" );
+    GLuint lista = glGenLists( 1 );
+    if ( lista == 0 ) {  // sem display lists: desenha sem cache
+      fn();
+      return;
+    }
+    // o Batch adiaria os vertices para depois do glEndList (grava direto na lista)
+    // e o GLState filtraria chamadas que a lista precisa ter (e a compilacao nao altera o estado)
+    bool batch       = Batch::enabled;
+    bool estado      = GLState::enabled;
+    Batch::enabled   = false;
+    GLState::enabled = false;
+    Batch::flush();
+    gravandoEstatico = true;
+    glNewList( lista, GL_COMPILE );
+    fn();
+    glEndList();
+    gravandoEstatico = false;
+    Batch::enabled   = batch;
+    GLState::enabled = estado;
+    it               = listasEstaticas.emplace( key, lista ).first;
+  }
+  glCallList( it->second );
+  GLState::invalidate();
+#ifdef QXGL_GL_INSTRUMENT
+  GLInstrument::invalidateState();  // a lista pode mudar estados sem passar pelos contadores
+#endif
+}
+
+void GUI::invalidateStatic( const std::string &key ) {
+  auto it = listasEstaticas.find( key );
+  if ( it == listasEstaticas.end() )
+    return;
+  glDeleteLists( it->second, 1 );
+  listasEstaticas.erase( it );
+}
+
+void GUI::invalidateAllStatic() {
+  for ( auto &l : listasEstaticas )
+    glDeleteLists( l.second, 1 );
+  listasEstaticas.clear();
+}
+//-------------------cache estatico------------------
+
 //-------------------clipping-------------------
 void GUI::drawHalfSphere( float px, float py, float pz, float radius ) {
   glPushMatrix();
@@ -742,17 +1176,17 @@ void GUI::drawHalfSphere( float px, float py, float pz, float radius ) {
   };  // deixa a parte à frente do plano (z) do plano aparecendo (plano posicionado no z=0, d
       // desloca o plano no sentido oposto à normal) (corta o z<0)
   glClipPlane( GL_CLIP_PLANE0, plane );
-  glEnable( GL_CLIP_PLANE0 );
+  GLState::enable( GL_CLIP_PLANE0 );
 
-  glDisable( GL_CULL_FACE );
+  GLState::disable( GL_CULL_FACE );
 
   // objeto a ser desenhado
   GUI::drawSphere( 0, 0, 0, radius );
 
-  glEnable( GL_CULL_FACE );
+  GLState::enable( GL_CULL_FACE );
 
   // clipping
-  glDisable( GL_CLIP_PLANE0 );
+  GLState::disable( GL_CLIP_PLANE0 );
   glPopMatrix();
 }
 
@@ -772,19 +1206,19 @@ void GUI::drawSphereInsideBox222( float px, float py, float pz, float radius ) {
   };
   for ( int pl = 0; pl < 6; pl++ ) {
     glClipPlane( GL_CLIP_PLANE0 + pl, planes[pl] );
-    glEnable( GL_CLIP_PLANE0 + pl );
+    GLState::enable( GL_CLIP_PLANE0 + pl );
   }
 
-  glDisable( GL_CULL_FACE );
+  GLState::disable( GL_CULL_FACE );
 
   // objeto a ser desenhado
   GUI::drawSphere( 0, 0, 0, radius );
 
-  glEnable( GL_CULL_FACE );
+  GLState::enable( GL_CULL_FACE );
 
   // clipping
   for ( int pl = 0; pl < 6; pl++ ) {
-    glDisable( GL_CLIP_PLANE0 + pl );
+    GLState::disable( GL_CLIP_PLANE0 + pl );
   }
   glPopMatrix();
 }
@@ -792,28 +1226,39 @@ void GUI::drawSphereInsideBox222( float px, float py, float pz, float radius ) {
 //-------------------clipping-------------------
 
 void GUI::drawSphere( float x, float y, float z, float radius ) {
-  GLUquadric *quad = gluNewQuadric();
-  gluQuadricDrawStyle( quad, GLU_FILL );
-  gluQuadricNormals( quad, GLU_SMOOTH );  // Create Smooth Normals
-  gluQuadricTexture( quad, GL_TRUE );     // Create Texture Coords
-
   // sphere
   glPushMatrix();
   glTranslated( x, y, z );
+  GLint slices = glutGUI::slices, stacks = glutGUI::stacks;
+  Tessellation::adjust( radius, slices, stacks );
   // glutSolidSphere(radius,slices,stacks);
-  gluSphere( quad, radius, glutGUI::slices, glutGUI::stacks );
+  Primitives::sphere( radius, slices );
   glPopMatrix();
-
-  gluDeleteQuadric( quad );
 }
 
-void GUI::drawQuad( float width,
-                    float height,
-                    float discrWidth,
-                    float discrHeight,
-                    float texWidth,
-                    float texHeight,
-                    bool  inverted ) {
+// cache das malhas do drawQuad: uma VBO por combinacao de parametros, com descarte da menos usada
+// recentemente (LRU) quando passa de GUI::quadCacheSize
+int GUI::quadCacheSize = 32;
+
+struct MalhaQuad {
+  float   chave[6];  // width, height, discrWidth, discrHeight, texWidth, texHeight
+  bool    inverted;
+  GLuint  vbo;
+  GLsizei nVertices;
+};
+
+static std::list<MalhaQuad> malhasQuad;  // a mais recente na frente
+
+// gera os quads na mesma ordem e com os mesmos valores do desenho imediato (glTranslatef e
+// glRotatef de 180 graus em X aplicados na CPU); formato GL_T2F_N3F_V3F
+static void geraMalhaQuad( float               width,
+                           float               height,
+                           float               discrWidth,
+                           float               discrHeight,
+                           float               texWidth,
+                           float               texHeight,
+                           bool                inverted,
+                           std::vector<float> &dados ) {
   int nWidth  = width / discrWidth;
   int nHeight = height / discrHeight;
   discrWidth =
@@ -824,32 +1269,73 @@ void GUI::drawQuad( float width,
                        // nHeight*discrHeight (feito pelo for) nao completara exatamente a height
   float discrTexWidth  = texWidth * ( discrWidth / width );
   float discrTexHeight = texHeight * ( discrHeight / height );
+  float sinal          = inverted ? -1.0f : 1.0f;  // rotacao de 180 graus em X: (x, -y, -z)
+  auto  vertice        = [&]( float s, float t, float x, float z ) {
+    float v[8] = { s, t, 0.0f, sinal, 0.0f, x, 0.0f, sinal * z };
+    dados.insert( dados.end(), v, v + 8 );
+  };
   for ( float i = -0.5 * ( width / discrWidth ); i < 0.5 * ( width / discrWidth ); i++ ) {
     for ( float j = -0.5 * ( height / discrHeight ); j < 0.5 * ( height / discrHeight ); j++ ) {
-      glPushMatrix();
-      if ( inverted )
-        glRotatef( 180, 1, 0, 0 );
-      glTranslatef( i * discrWidth, 0.0, j * discrHeight );
-      glBegin( GL_QUADS );
-      glNormal3f( 0., 1., 0. );
-      // glTexCoord2f(     i*discrTexWidth, (j+1)*discrTexHeight); glVertex3f(
-      // 0.0,0.0,+discrHeight); glTexCoord2f( (i+1)*discrTexWidth, (j+1)*discrTexHeight);
-      // glVertex3f(+discrWidth,0.0,+discrHeight); glTexCoord2f( (i+1)*discrTexWidth,
-      // j*discrTexHeight); glVertex3f(+discrWidth,0.0,         0.0); glTexCoord2f( i*discrTexWidth,
-      // j*discrTexHeight); glVertex3f(        0.0,0.0,         0.0);
-      glTexCoord2f( 0.5 + i * discrTexWidth / width, 0.5 - ( j + 1 ) * discrTexHeight / height );
-      glVertex3f( 0.0, 0.0, +discrHeight );
-      glTexCoord2f( 0.5 + ( i + 1 ) * discrTexWidth / width,
-                    0.5 - ( j + 1 ) * discrTexHeight / height );
-      glVertex3f( +discrWidth, 0.0, +discrHeight );
-      glTexCoord2f( 0.5 + ( i + 1 ) * discrTexWidth / width, 0.5 - j * discrTexHeight / height );
-      glVertex3f( +discrWidth, 0.0, 0.0 );
-      glTexCoord2f( 0.5 + i * discrTexWidth / width, 0.5 - j * discrTexHeight / height );
-      glVertex3f( 0.0, 0.0, 0.0 );
-      glEnd();
-      glPopMatrix();
+      float x = i * discrWidth, z = j * discrHeight;
+      vertice( 0.5 + i * discrTexWidth / width,
+               0.5 - ( j + 1 ) * discrTexHeight / height,
+               x,
+               z + discrHeight );
+      vertice( 0.5 + ( i + 1 ) * discrTexWidth / width,
+               0.5 - ( j + 1 ) * discrTexHeight / height,
+               x + discrWidth,
+               z + discrHeight );
+      vertice( 0.5 + ( i + 1 ) * discrTexWidth / width,
+               0.5 - j * discrTexHeight / height,
+               x + discrWidth,
+               z );
+      vertice( 0.5 + i * discrTexWidth / width, 0.5 - j * discrTexHeight / height, x, z );
+    }
+  }
+}
+
+void GUI::drawQuad( float width,
+                    float height,
+                    float discrWidth,
+                    float discrHeight,
+                    float texWidth,
+                    float texHeight,
+                    bool  inverted ) {
+  const float chave[6] = { width, height, discrWidth, discrHeight, texWidth, texHeight };
+
+  auto it = malhasQuad.begin();
+  for ( ; it != malhasQuad.end(); ++it )
+    if ( it->inverted == inverted && std::equal( chave, chave + 6, it->chave ) )
+      break;
+
+  if ( it != malhasQuad.end() ) {
+    malhasQuad.splice( malhasQuad.begin(), malhasQuad, it );  // passa a ser a mais recente
+  } else {
+    QXGL_TRACE_ZONE( "GUI::drawQuad (gera malha)" );
+    std::vector<float> dados;
+    geraMalhaQuad(
+      width, height, discrWidth, discrHeight, texWidth, texHeight, inverted, dados );
+    MalhaQuad m;
+    std::copy( chave, chave + 6, m.chave );
+    m.inverted  = inverted;
+    m.nVertices = (GLsizei)( dados.size() / 8 );
+    glGenBuffers( 1, &m.vbo );
+    glBindBuffer( GL_ARRAY_BUFFER, m.vbo );
+    glBufferData( GL_ARRAY_BUFFER, dados.size() * sizeof( float ), dados.data(), GL_STATIC_DRAW );
+    malhasQuad.push_front( m );
+    while ( (int)malhasQuad.size() > std::max( quadCacheSize, 1 ) ) {
+      glDeleteBuffers( 1, &malhasQuad.back().vbo );
+      malhasQuad.pop_back();
     }
   }
+
+  const MalhaQuad &m = malhasQuad.front();
+  glBindBuffer( GL_ARRAY_BUFFER, m.vbo );
+  glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+  glInterleavedArrays( GL_T2F_N3F_V3F, 0, (void *)0 );
+  glDrawArrays( GL_QUADS, 0, m.nVertices );
+  glPopClientAttrib();
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
 }
 
 void GUI::drawOriQuad( float angle,
@@ -928,154 +1414,356 @@ void GUI::drawBox(
   //    if (inverted) glCullFace(GL_FRONT);
   //    else glCullFace(GL_BACK);
 
+  // sem lote (ou no picking) o Batch desenharia em modo imediato: a malha BOX de Primitives tem as
+  // mesmas faces, normais e coordenadas de textura
+  if ( !inverted && ( !Batch::enabled || glutGUI::picking ) ) {
+    Primitives::box( xmin, ymin, zmin, xmax, ymax, zmax );
+    return;
+  }
+
   if ( !inverted ) {
     float um = 1.0;
 
-    glBegin( GL_QUADS );
-    glNormal3f( 0., 0., -um );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmin, ymin, zmin );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmin );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmin );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmax, ymin, zmin );
-    glEnd();
-
-    glBegin( GL_QUADS );
-    glNormal3f( um, 0., 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmin );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmax, ymax, zmin );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmax );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmax, ymin, zmax );
-    glEnd();
-
-    glBegin( GL_QUADS );
-    glNormal3f( 0., 0., um );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmax );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmax, ymax, zmax );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmin, ymax, zmax );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmax );
-    glEnd();
-
-    glBegin( GL_QUADS );
-    glNormal3f( -um, 0., 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmin, ymin, zmax );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmax );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmin, ymax, zmin );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmin );
-    glEnd();
-
-    glBegin( GL_QUADS );
-    glNormal3f( 0., um, 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmin );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmax );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmax );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmin );
-    glEnd();
-
-    glBegin( GL_QUADS );
-    glNormal3f( 0., -um, 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmin );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmax );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmax );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmin );
-    glEnd();
+    Batch::begin( GL_QUADS );
+    Batch::normal3f( 0., 0., -um );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmin, ymin, zmin );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmin );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmin );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmax, ymin, zmin );
+
+    Batch::normal3f( um, 0., 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmin );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmax, ymax, zmin );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmax );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmax, ymin, zmax );
+
+    Batch::normal3f( 0., 0., um );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmax );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmax, ymax, zmax );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmin, ymax, zmax );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmax );
+
+    Batch::normal3f( -um, 0., 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmin, ymin, zmax );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmax );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmin, ymax, zmin );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmin );
+
+    Batch::normal3f( 0., um, 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmin );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmax );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmax );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmin );
+
+    Batch::normal3f( 0., -um, 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmin );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmax );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmax );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmin );
+    Batch::end();
   } else {
     float um = -1.0;
 
-    glBegin( GL_QUADS );
-    glNormal3f( 0., 0., -um );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmin, ymin, zmin );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmax, ymin, zmin );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmin );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmin );
-    glEnd();
+    Batch::begin( GL_QUADS );
+    Batch::normal3f( 0., 0., -um );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmin, ymin, zmin );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmax, ymin, zmin );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmin );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmin );
+
+    Batch::normal3f( um, 0., 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmin );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmax, ymin, zmax );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmax );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmax, ymax, zmin );
+
+    Batch::normal3f( 0., 0., um );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmax );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmax );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmin, ymax, zmax );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmax, ymax, zmax );
+
+    Batch::normal3f( -um, 0., 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmin, ymin, zmax );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmin );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmin, ymax, zmin );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmax );
+
+    Batch::normal3f( 0., um, 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmin );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmin );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmax, ymax, zmax );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmin, ymax, zmax );
+
+    Batch::normal3f( 0., -um, 0. );
+    Batch::texCoord2f( 0.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmin );
+    Batch::texCoord2f( 0.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmin );
+    Batch::texCoord2f( 1.0f, 1.0f );
+    Batch::vertex3f( xmin, ymin, zmax );
+    Batch::texCoord2f( 1.0f, 0.0f );
+    Batch::vertex3f( xmax, ymin, zmax );
+    Batch::end();
+  }
+}
 
-    glBegin( GL_QUADS );
-    glNormal3f( um, 0., 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmin );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmax, ymin, zmax );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmax );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmax, ymax, zmin );
-    glEnd();
+// caixas instanciadas: cubo unitario [0,1]^3 com as faces de GUI::drawBox (24 vertices GL_QUADS,
+// T2F_N3F_V3F) e, em seguida, a versao invertida; cantos e cores vem de atributos por instancia
+enum { ATRIB_CAIXA_MIN = 5, ATRIB_CAIXA_MAX = 6, ATRIB_CAIXA_COR = 7 };
+static GLuint caixasPrograma = 0, caixasCubo = 0, caixasInstancias = 0;
+static GLint  caixasUsaCor = -1, caixasIluminacao = -1, caixasModoTextura = -1,
+              caixasCorMaterial = -1;
+
+// combinacao da textura no shader das caixas (a mesma do glTexEnv, com textura RGBA ou RGB)
+enum { TEXTURA_NENHUMA, TEXTURA_MODULATE, TEXTURA_DECAL, TEXTURA_ADD, TEXTURA_FIXA = -1 };
+
+static bool criaProgramaCaixas() {
+  std::string vs = std::string( "#version 120\n" ) + Shader::fixedLighting +
+                   "attribute vec3 caixaMin;\n"
+                   "attribute vec3 caixaMax;\n"
+                   "attribute vec4 caixaCor;\n"
+                   "uniform bool   usaCor;\n"
+                   "uniform bool   iluminacao;\n"
+                   "uniform bool   corMaterial;\n"
+                   "varying vec4   cor;\n"
+                   "void main() {\n"
+                   "  vec3 p          = caixaMin + gl_Vertex.xyz * ( caixaMax - caixaMin );\n"
+                   "  vec4 pe         = gl_ModelViewMatrix * vec4( p, 1.0 );\n"
+                   "  gl_Position     = gl_ProjectionMatrix * pe;\n"
+                   "  gl_ClipVertex   = pe;\n"
+                   "  gl_TexCoord[0]  = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+                   "  if ( !iluminacao ) {\n"  // como em drawBox: setColor so altera o material
+                   "    cor = gl_Color;\n"
+                   "    return;\n"
+                   "  }\n"
+                   // com cor por caixa o material e o de GUI::setColor; com GL_COLOR_MATERIAL o
+                   // glColor substitui a ambiente e a difusa (GL_AMBIENT_AND_DIFFUSE)
+                   "  vec4  amb    = usaCor ? vec4( 0.6 * caixaCor.rgb, caixaCor.a )\n"
+                   "                        : gl_FrontMaterial.ambient;\n"
+                   "  vec4  dif    = usaCor ? caixaCor : gl_FrontMaterial.diffuse;\n"
+                   "  vec4  spec   = usaCor ? vec4( 0.0, 0.0, 0.0, caixaCor.a )\n"
+                   "                        : gl_FrontMaterial.specular;\n"
+                   "  float brilho = usaCor ? 100.0 : gl_FrontMaterial.shininess;\n"
+                   "  if ( corMaterial ) {\n"
+                   "    amb = gl_Color;\n"
+                   "    dif = gl_Color;\n"
+                   "  }\n"
+                   "  vec3 n = normalize( gl_NormalMatrix * gl_Normal );\n"
+                   "  cor    = qxglIluminacao( pe.xyz, n, amb, dif, spec, brilho,\n"
+                   "                           gl_FrontMaterial.emission );\n"
+                   "}\n";
+  const char *fs = "uniform int       modoTextura;\n"  // TEXTURA_NENHUMA, _MODULATE, _DECAL, _ADD
+                   "uniform sampler2D textura;\n"
+                   "varying vec4      cor;\n"
+                   "void main() {\n"
+                   "  gl_FragColor = cor;\n"
+                   "  if ( modoTextura == 0 )\n"
+                   "    return;\n"
+                   "  vec4 t = texture2DProj( textura, gl_TexCoord[0] );\n"
+                   "  if ( modoTextura == 1 )\n"
+                   "    gl_FragColor *= t;\n"
+                   "  else if ( modoTextura == 2 )\n"
+                   "    gl_FragColor.rgb = mix( cor.rgb, t.rgb, t.a );\n"
+                   "  else\n"
+                   "    gl_FragColor = vec4( min( cor.rgb + t.rgb, 1.0 ), cor.a * t.a );\n"
+                   "}\n";
+  caixasPrograma = Shader::program( vs.c_str(),
+                                    fs,
+                                    "GUI::drawBoxes",
+                                    { { ATRIB_CAIXA_MIN, "caixaMin" },
+                                      { ATRIB_CAIXA_MAX, "caixaMax" },
+                                      { ATRIB_CAIXA_COR, "caixaCor" } } );
+  if ( caixasPrograma == 0 )
+    return false;
+  caixasUsaCor      = glGetUniformLocation( caixasPrograma, "usaCor" );
+  caixasIluminacao  = glGetUniformLocation( caixasPrograma, "iluminacao" );
+  caixasModoTextura = glGetUniformLocation( caixasPrograma, "modoTextura" );
+  caixasCorMaterial = glGetUniformLocation( caixasPrograma, "corMaterial" );
+  GLState::useProgram( caixasPrograma );
+  glUniform1i( glGetUniformLocation( caixasPrograma, "textura" ), 0 );
+  GLState::useProgram( 0 );
+  return true;
+}
 
-    glBegin( GL_QUADS );
-    glNormal3f( 0., 0., um );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmax );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmax );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmin, ymax, zmax );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmax, ymax, zmax );
-    glEnd();
+static void geraCuboCaixas() {
+  // cantos com bits x = 4, y = 2, z = 1, na ordem de GUI::drawBox
+  static const int     cantos[6][4]      = { { 0, 2, 6, 4 }, { 4, 6, 7, 5 }, { 5, 7, 3, 1 },
+                                             { 1, 3, 2, 0 }, { 2, 3, 7, 6 }, { 4, 5, 1, 0 } };
+  static const GLfloat normais[6][3]     = { { 0, 0, -1 }, { 1, 0, 0 }, { 0, 0, 1 },
+                                             { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+  static const GLfloat tex[4][2]         = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+  static const int     ordemInvertida[4] = { 0, 3, 2, 1 };  // mesma ordem do ramo invertido
+
+  std::vector<GLfloat> v;
+  for ( int inv = 0; inv < 2; inv++ ) {
+    for ( int f = 0; f < 6; f++ ) {
+      for ( int k = 0; k < 4; k++ ) {
+        int j = inv ? ordemInvertida[k] : k;
+        int c = cantos[f][j];
+        v.insert( v.end(),
+                  { tex[j][0],
+                    tex[j][1],
+                    inv ? -normais[f][0] : normais[f][0],
+                    inv ? -normais[f][1] : normais[f][1],
+                    inv ? -normais[f][2] : normais[f][2],
+                    (GLfloat)( ( c >> 2 ) & 1 ),
+                    (GLfloat)( ( c >> 1 ) & 1 ),
+                    (GLfloat)( c & 1 ) } );
+      }
+    }
+  }
+  glGenBuffers( 1, &caixasCubo );
+  glGenBuffers( 1, &caixasInstancias );
+  glBindBuffer( GL_ARRAY_BUFFER, caixasCubo );
+  glBufferData( GL_ARRAY_BUFFER, v.size() * sizeof( GLfloat ), v.data(), GL_STATIC_DRAW );
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
 
-    glBegin( GL_QUADS );
-    glNormal3f( -um, 0., 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmin, ymin, zmax );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmin );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmin, ymax, zmin );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmax );
-    glEnd();
+// modo de combinacao da textura 2D; geracao de coordenadas (glTexGen) e os modos sem equivalente
+// no shader (GL_REPLACE e GL_BLEND dependem do formato da textura, GL_COMBINE de muitos
+// parametros) ficam com o pipeline fixo
+static int modoTexturaCaixas() {
+  if ( !glIsEnabled( GL_TEXTURE_2D ) )
+    return TEXTURA_NENHUMA;
+  if ( glIsEnabled( GL_TEXTURE_GEN_S ) || glIsEnabled( GL_TEXTURE_GEN_T ) ||
+       glIsEnabled( GL_TEXTURE_GEN_R ) || glIsEnabled( GL_TEXTURE_GEN_Q ) )
+    return TEXTURA_FIXA;
+  GLint modo = GL_MODULATE;
+  glGetTexEnviv( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, &modo );
+  switch ( modo ) {
+    case GL_MODULATE:
+      return TEXTURA_MODULATE;
+    case GL_DECAL:
+      return TEXTURA_DECAL;
+    case GL_ADD:
+      return TEXTURA_ADD;
+    default:
+      return TEXTURA_FIXA;
+  }
+}
 
-    glBegin( GL_QUADS );
-    glNormal3f( 0., um, 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmin );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmin );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmax, ymax, zmax );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmin, ymax, zmax );
-    glEnd();
+void GUI::drawBoxes(
+  int n, const float *mins, const float *maxs, const float *colors, bool inverted ) {
+  if ( n <= 0 )
+    return;
+  // no picking (GL_SELECT ou por cor) o programa proprio nao pode ser usado, e numa display list
+  // (cacheStatic) os buffers e atributos por instancia nao seriam gravados
+  int  modoTextura = TEXTURA_NENHUMA;
+  bool fixo        = glutGUI::picking || gravandoEstatico;
+  if ( !fixo ) {
+    modoTextura = modoTexturaCaixas();
+    fixo = modoTextura == TEXTURA_FIXA || ( caixasPrograma == 0 && !criaProgramaCaixas() );
+  }
+  if ( fixo ) {
+    for ( int i = 0; i < n; i++ ) {
+      if ( colors && !glutGUI::picking )
+        setColor( colors[4 * i], colors[4 * i + 1], colors[4 * i + 2], colors[4 * i + 3] );
+      drawBox( mins[3 * i],
+               mins[3 * i + 1],
+               mins[3 * i + 2],
+               maxs[3 * i],
+               maxs[3 * i + 1],
+               maxs[3 * i + 2],
+               inverted );
+    }
+    return;
+  }
+  QXGL_TRACE_ZONE( "GUI::drawBoxes" );
+  Batch::flush();  // mantem a ordem com os desenhos agrupados antes
+  if ( caixasCubo == 0 )
+    geraCuboCaixas();
+
+  // instancias: cantos minimos, maximos e cores em blocos do mesmo buffer (realocado a cada
+  // chamada para nao esperar o desenho anterior)
+  GLsizeiptr bloco    = (GLsizeiptr)n * 3 * sizeof( float );
+  GLsizeiptr blocoCor = colors ? (GLsizeiptr)n * 4 * sizeof( float ) : 0;
+  glBindBuffer( GL_ARRAY_BUFFER, caixasInstancias );
+  glBufferData( GL_ARRAY_BUFFER, bloco * 2 + blocoCor, NULL, GL_STREAM_DRAW );
+  glBufferSubData( GL_ARRAY_BUFFER, 0, bloco, mins );
+  glBufferSubData( GL_ARRAY_BUFFER, bloco, bloco, maxs );
+  glVertexAttribPointer( ATRIB_CAIXA_MIN, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)0 );
+  glVertexAttribPointer( ATRIB_CAIXA_MAX, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)bloco );
+  glEnableVertexAttribArray( ATRIB_CAIXA_MIN );
+  glEnableVertexAttribArray( ATRIB_CAIXA_MAX );
+  glVertexAttribDivisor( ATRIB_CAIXA_MIN, 1 );
+  glVertexAttribDivisor( ATRIB_CAIXA_MAX, 1 );
+  if ( colors ) {
+    glBufferSubData( GL_ARRAY_BUFFER, bloco * 2, blocoCor, colors );
+    glVertexAttribPointer(
+      ATRIB_CAIXA_COR, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)( bloco * 2 ) );
+    glEnableVertexAttribArray( ATRIB_CAIXA_COR );
+    glVertexAttribDivisor( ATRIB_CAIXA_COR, 1 );
+  }
 
-    glBegin( GL_QUADS );
-    glNormal3f( 0., -um, 0. );
-    glTexCoord2f( 0.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmin );
-    glTexCoord2f( 0.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmin );
-    glTexCoord2f( 1.0f, 1.0f );
-    glVertex3f( xmin, ymin, zmax );
-    glTexCoord2f( 1.0f, 0.0f );
-    glVertex3f( xmax, ymin, zmax );
-    glEnd();
+  glBindBuffer( GL_ARRAY_BUFFER, caixasCubo );
+  glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+  glInterleavedArrays( GL_T2F_N3F_V3F, 0, (const GLvoid *)0 );
+
+  GLState::useProgram( caixasPrograma );
+  Shader::setFixedLighting( caixasPrograma );
+  glUniform1i( caixasUsaCor, colors != NULL );
+  // lidos do OpenGL, como no Batch usado por drawBox
+  glUniform1i( caixasIluminacao, glIsEnabled( GL_LIGHTING ) );
+  glUniform1i( caixasModoTextura, modoTextura );
+  glUniform1i( caixasCorMaterial, glIsEnabled( GL_COLOR_MATERIAL ) );
+  glDrawArraysInstanced( GL_QUADS, inverted ? 24 : 0, 24, n );
+  GLState::useProgram( 0 );
+
+  glPopClientAttrib();
+  for ( GLuint a = ATRIB_CAIXA_MIN; a <= ATRIB_CAIXA_COR; a++ ) {
+    glVertexAttribDivisor( a, 0 );
+    glDisableVertexAttribArray( a );
+  }
+  glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  // como no desenho uma a uma, o material fica com a cor da ultima caixa
+  if ( colors ) {
+    const float *c = colors + 4 * ( n - 1 );
+    setColor( c[0], c[1], c[2], c[3] );
   }
 }
 
@@ -1164,17 +1852,17 @@ void GUI::drawPlaneAL( GLfloat planeABCD[4],
                        float   discrHeight,
                        float   texWidth,
                        float   texHeight ) {
-  glDisable( GL_CULL_FACE );
+  GLState::disable( GL_CULL_FACE );
   if ( !glutGUI::iluminacao3D ) {
-    glDisable( GL_LIGHTING );
+    GLState::disable( GL_LIGHTING );
     glColor3f( 1, 1, 1 );
   }
   setColor( 1, 1, 1 );
 
   GUI::drawPlane( planeABCD, width, height, discrWidth, discrHeight, texWidth, texHeight );
 
-  glEnable( GL_LIGHTING );
-  glEnable( GL_CULL_FACE );
+  GLState::enable( GL_LIGHTING );
+  GLState::enable( GL_CULL_FACE );
 }
 
 // plano arbitrario
@@ -1214,18 +1902,23 @@ void GUI::drawOrigin( float tamanho ) {
   glPopMatrix();
 }
 
+// cone na ponta de um eixo de drawOriginAL, com no maximo as 10 fatias do desenho original
+static void coneEixo() {
+  GLint slices = 10, stacks = 10;
+  Tessellation::adjust( 0.1, slices, stacks, 0, 0, 0.05 );
+  Primitives::cylinder( 0.1 * 0.5, 0, 0.2 * 0.5, slices, true );
+}
+
 void GUI::drawOriginAL( float tam, float discr ) {
   const GLfloat redMaterial[]   = { 0.8, 0., 0., 1. };
   const GLfloat greenMaterial[] = { 0., 0.3, 0., 1. };
   const GLfloat blueMaterial[]  = { 0., 0., 0.3, 1. };
 
-  GLUquadricObj *quad = gluNewQuadric();
-
-  glLineWidth( 2 );
+  GLState::lineWidth( 2 );
 
   // x
-  glMaterialfv( GL_FRONT, GL_AMBIENT, redMaterial );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, redMaterial );
+  GLState::material( GL_FRONT, GL_AMBIENT, redMaterial );
+  GLState::material( GL_FRONT, GL_DIFFUSE, redMaterial );
   glColor3d( 0.8, 0.0, 0.0 );
 
   glBegin( GL_LINES );
@@ -1241,12 +1934,12 @@ void GUI::drawOriginAL( float tam, float discr ) {
   glPushMatrix();
   glRotated( 90, 0, 1, 0 );
   glTranslated( 0, 0, tam );
-  Desenha::gluClosedCylinder( quad, 0.1 * 0.5, 0, 0.2 * 0.5, 10, 10 );
+  coneEixo();
   glPopMatrix();
 
   // y
-  glMaterialfv( GL_FRONT, GL_AMBIENT, greenMaterial );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, greenMaterial );
+  GLState::material( GL_FRONT, GL_AMBIENT, greenMaterial );
+  GLState::material( GL_FRONT, GL_DIFFUSE, greenMaterial );
   glColor3d( 0.0, 0.3, 0.0 );
 
   glBegin( GL_LINES );
@@ -1262,12 +1955,12 @@ void GUI::drawOriginAL( float tam, float discr ) {
   glPushMatrix();
   glRotated( 90, -1, 0, 0 );
   glTranslated( 0, 0, tam );
-  Desenha::gluClosedCylinder( quad, 0.1 * 0.5, 0, 0.2 * 0.5, 10, 10 );
+  coneEixo();
   glPopMatrix();
 
   // z
-  glMaterialfv( GL_FRONT, GL_AMBIENT, blueMaterial );
-  glMaterialfv( GL_FRONT, GL_DIFFUSE, blueMaterial );
+  GLState::material( GL_FRONT, GL_AMBIENT, blueMaterial );
+  GLState::material( GL_FRONT, GL_DIFFUSE, blueMaterial );
   glColor3d( 0.0, 0.0, 0.3 );
 
   glBegin( GL_LINES );
@@ -1282,25 +1975,21 @@ void GUI::drawOriginAL( float tam, float discr ) {
   }
   glPushMatrix();
   glTranslated( 0, 0, tam );
-  Desenha::gluClosedCylinder( quad, 0.1 * 0.5, 0, 0.2 * 0.5, 10, 10 );
+  coneEixo();
   glPopMatrix();
 
-  glLineWidth( 1 );
-
-  gluDeleteQuadric( quad );
+  GLState::lineWidth( 1 );
 }
 
 void GUI::drawCamera( float tamanho ) {
-  GLUquadricObj *quad = gluNewQuadric();
-
   glPushMatrix();
-  Desenha::drawBox( -tamanho, -tamanho, -tamanho, tamanho, tamanho, tamanho );
+  Primitives::box( -tamanho, -tamanho, -tamanho, tamanho, tamanho, tamanho );
   glTranslatef( 0, 0, -2 * tamanho );
-  Desenha::gluClosedCylinder(
-    quad, tamanho, tamanho / 2, tamanho, glutGUI::slices, glutGUI::stacks );
+  // tronco de cone: fica com o quadric interno de Primitives, sem criar um por desenho
+  GLint slices = glutGUI::slices, stacks = glutGUI::stacks;
+  Tessellation::adjust( tamanho, slices, stacks, 0, 0, tamanho / 2 );
+  Primitives::cylinder( tamanho, tamanho / 2, tamanho, slices, true, 0, stacks );
   glPopMatrix();
-
-  gluDeleteQuadric( quad );
 }
 
 // void GUI::draw3ds(Model3DS &model3DS, float tx, float ty, float tz,
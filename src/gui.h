@@ -16,10 +16,23 @@ using displayFunction     = void ( * )();
 using keyFunction         = void ( * )( unsigned char, int, int );
 using mouseButtonFunction = void ( * )( int, int, int, int );
 
+#include "Culling.h"
 #include "extra.h"
 
+#include <functional>
+#include <string>
+
 // #include "model3ds.h"
 
+/**
+ * @struct PickResult
+ * @brief Resultado do picking por cor (GUI::colorPickingClosest).
+ */
+struct PickResult {
+  GLuint id;    /**< @brief Nome do objeto mais próximo (0 se nenhum). */
+  float  depth; /**< @brief Profundidade do objeto no pixel mais próximo, em [0,1]. */
+};
+
 /**
  * @class GUI
  * @brief Classe principal que gerencia a janela, eventos e renderização com OpenGL/GLUT.
@@ -160,6 +173,28 @@ public:
                         bool  spot             = false,
                         bool  onOffUserControl = true );
 
+  /**
+   * @brief Se verdadeiro (padrão), Model3D::draw chama selectLights com a caixa do modelo antes
+   * de desenhar e restoreLights depois.
+   */
+  static bool lightSelection;
+
+  /**
+   * @brief Liga apenas as luzes do setLight que alcançam a caixa (min, max).
+   * @details O pipeline fixo calcula todas as luzes ligadas em cada vértice, mesmo as que estão
+   * longe demais para contribuir. O alcance de cada luz é calculado no setLight a partir da
+   * atenuação (Lighting::rangeFromAttenuation, com Lighting::threshold); luzes direcionais ou
+   * sem atenuação alcançam tudo. A caixa está nas coordenadas da modelview corrente, como em
+   * drawBox. As luzes são ligadas e desligadas pelo GLState e nada é enviado se o conjunto
+   * selecionado não mudou. A seleção vale até restoreLights ou o próximo setLight.
+   */
+  static void selectLights( const Vetor3D &min, const Vetor3D &max );
+
+  /**
+   * @brief Religa todas as luzes ligadas pelo setLight (desfaz selectLights).
+   */
+  static void restoreLights();
+
   /**
    * @brief Define as propriedades de material de um objeto.
    * @param r Componente vermelha da cor difusa.
@@ -183,6 +218,9 @@ public:
   static void glShearXYf( float shX, float shY );
   static void glShearXZf( float shX, float shZ );
   static void glShearYZf( float shY, float shZ );
+  /**
+   * @brief Reflexões nos planos coordenados (para espelhos em textura, veja Reflection).
+   */
   static void glReflectPlaneYZf();
   static void glReflectPlaneXZf();
   static void glReflectPlaneXYf();
@@ -222,6 +260,7 @@ public:
    * @param shadowMat A matriz 4x4 resultante.
    * @param groundplane A equação do plano (vetor de 4 floats: A, B, C, D).
    * @param lightpos A posição da fonte de luz (vetor de 4 floats).
+   * @see ShadowMap para sombras sobre qualquer superfície sem redesenhar os objetos por plano.
    */
   static void shadowMatrix( GLfloat shadowMat[4][4], GLfloat groundplane[4], GLfloat lightpos[4] );
   //-------------------sombra-------------------
@@ -256,6 +295,57 @@ public:
    * @return O nome do objeto mais próximo que foi selecionado.
    */
   static int pickingClosestName( GLuint *selectBuf, int BUFSIZE );
+
+  /**
+   * @brief Inicializa o picking por cor, alternativa ao GL_SELECT.
+   * @details Os objetos são desenhados em um framebuffer fora da tela, apenas na região w x h
+   * em volta do cursor (scissor), com a cor codificando o nome definido por pickingPushName (a
+   * iluminação, as texturas e as cores da cena são ignoradas). Depois de desenhar a cena (com
+   * GUI::displayInit, como no GL_SELECT), chame colorPickingClosest. Requer OpenGL 2.1 e
+   * framebuffer objects.
+   * @param cursorX Coordenada X do cursor.
+   * @param cursorY Coordenada Y do cursor.
+   * @param w Largura da área de picking.
+   * @param h Altura da área de picking.
+   */
+  static void colorPickingInit( GLint cursorX, GLint cursorY, int w, int h );
+
+  /**
+   * @brief Finaliza o picking por cor: lê só os pixels da região (via pixel buffer object) e
+   * retorna o nome com menor profundidade.
+   */
+  static PickResult colorPickingClosest();
+
+  /**
+   * @brief Empilha o nome dos próximos objetos desenhados. Funciona nos dois modos de picking
+   * (no GL_SELECT equivale a glPushName).
+   */
+  static void pickingPushName( GLuint name );
+
+  /**
+   * @brief Desempilha o nome atual (no GL_SELECT equivale a glPopName).
+   */
+  static void pickingPopName();
+
+  /**
+   * @brief Seleção por área: objetos dentro do retângulo arrastado (x0, y0)-(x1, y1) da janela.
+   * @details As caixas são testadas na CPU contra o sub-frustum do retângulo
+   * (Frustum::fromScreenRect), sem GL_SELECT nem pilha de nomes. Com `occlusion`, as caixas que
+   * passaram são desenhadas (sem escrever cor nem profundidade) contra o depth buffer da cena,
+   * todas com occlusion queries disparadas em lote e lidas no fim; só ficam as que têm algum
+   * pixel visível dentro do retângulo. Nesse caso chame depois de desenhar a cena e antes de
+   * GUI::displayEnd, com a viewport ocupando a janela inteira.
+   * @param boxes Caixas envolventes dos objetos no espaço do mundo.
+   * @param selected Recebe os índices (em `boxes`) dos objetos selecionados, em ordem crescente.
+   * @return Quantidade de objetos selecionados.
+   */
+  static int areaSelect( int               x0,
+                         int               y0,
+                         int               x1,
+                         int               y1,
+                         const AABBSet    &boxes,
+                         std::vector<int> &selected,
+                         bool              occlusion = false );
   //-------------------picking------------------
 
   //-------------------viewPorts------------------
@@ -270,6 +360,32 @@ public:
   static void glScissoredViewport( int x, int y, int width, int height );
   //-------------------viewPorts------------------
 
+  //-------------------cache estatico------------------
+  /**
+   * @brief Desenha um conteúdo estático, gravado uma única vez.
+   * @details Na primeira chamada com `key`, a geometria e os estados emitidos por `fn` são
+   * compilados em uma display list; nas seguintes, `fn` não é chamada e a lista é reexecutada com
+   * a matriz e o estado correntes. Use para partes da cena que não mudam entre frames (paredes
+   * com drawQuadBox, móveis com drawBox...). O que `fn` lê do estado ao ser gravada fica fixo até
+   * a invalidação: as matrizes correntes vistas pelo LOD automático (Tessellation), texturas
+   * escolhidas, variáveis da aplicação etc. Durante o picking, `fn` é sempre chamada diretamente,
+   * e chamadas aninhadas dentro de uma gravação passam a fazer parte da lista externa.
+   * @param key Identificador do conteúdo.
+   * @param fn Função que desenha o conteúdo.
+   */
+  static void cacheStatic( const std::string &key, const std::function<void()> &fn );
+
+  /**
+   * @brief Descarta a gravação de `key` (a próxima chamada de cacheStatic grava de novo).
+   */
+  static void invalidateStatic( const std::string &key );
+
+  /**
+   * @brief Descarta todas as gravações de cacheStatic.
+   */
+  static void invalidateAllStatic();
+  //-------------------cache estatico------------------
+
   //-------------------textures------------------
   /**
    * @brief Carrega todas as texturas usadas na aplicação.
@@ -314,8 +430,16 @@ public:
    */
   static void drawSphere( float x, float y, float z, float radius );
 
+  /**
+   * @brief Quantidade máxima de malhas guardadas pelo drawQuad (padrão 32).
+   */
+  static int quadCacheSize;
+
   /**
    * @brief Desenha um quad (plano) no plano XZ, discretizado e com coordenadas de textura.
+   * @details A malha de cada combinação de parâmetros é gerada uma única vez em um vertex buffer
+   * e desenhada com um só glDrawArrays. Quando há mais de quadCacheSize malhas, a usada há mais
+   * tempo é descartada.
    */
   static void drawQuad( float width       = 5.0,
                         float height      = 5.0,
@@ -359,6 +483,29 @@ public:
   static void drawBox(
     float xmin, float ymin, float zmin, float xmax, float ymax, float zmax, bool inverted = false );
 
+  /**
+   * @brief Desenha n caixas alinhadas aos eixos com um único desenho instanciado.
+   * @details Todas as caixas compartilham um cubo unitário na GPU (as mesmas faces, normais e
+   * coordenadas de textura de drawBox); os cantos e as cores são atributos por instância. A
+   * iluminação fixa (até 8 luzes), o material corrente (ou o glColor, com GL_COLOR_MATERIAL), a
+   * textura 2D ligada com a matriz de textura e os modos GL_MODULATE, GL_DECAL e GL_ADD são
+   * reproduzidos em GLSL. Durante o picking, dentro de cacheStatic, com glTexGen ligado, com outro
+   * modo de textura ou sem suporte a shaders, as caixas são desenhadas uma a uma com drawBox, com
+   * o mesmo resultado. Caixas com escala (drawScaledBox) são passadas com os cantos já escalados.
+   * @param n Quantidade de caixas.
+   * @param mins Cantos mínimos (3 floats por caixa).
+   * @param maxs Cantos máximos (3 floats por caixa).
+   * @param colors Cores RGBA (4 floats por caixa), aplicadas como em setColor (só alteram o
+   * material: sem iluminação vale a cor corrente); no fim o material fica com a cor da última
+   * caixa. Nulo usa o material corrente.
+   * @param inverted Faces voltadas para dentro, como em drawBox.
+   */
+  static void drawBoxes( int          n,
+                         const float *mins,
+                         const float *maxs,
+                         const float *colors   = nullptr,
+                         bool         inverted = false );
+
   /**
    * @brief Desenha uma caixa com escala aplicada.
    */
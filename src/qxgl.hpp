@@ -1,12 +1,31 @@
 #ifndef QXGL_HPP
 #define QXGL_HPP
 
+#include "Batch.h"
+#include "BVH.h"
+#include "CamAnimation.h"
 #include "Camera.h"
 #include "CameraDistante.h"
 #include "CameraJogo.h"
+#include "CameraPath.h"
+#include "Culling.h"
+#include "DebugDraw.h"
 #include "Desenha.h"
+#include "GLInstrument.h"
+#include "GLState.h"
+#include "GpuTimer.h"
+#include "Lighting.h"
+#include "Matriz4.h"
 #include "Model3D.h"
 #include "OpenTextures.h"
+#include "Primitives.h"
+#include "Ray.h"
+#include "Reflection.h"
+#include "Shader.h"
+#include "ShadowMap.h"
+#include "Stats.h"
+#include "Tessellation.h"
+#include "Trace.h"
 #include "Transform.h"
 #include "Vetor3D.h"
 #include "extra.h"